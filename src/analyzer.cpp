@@ -47,14 +47,16 @@ analyzer::analyzer() {
     _view           = -1;
     _windowing      = -1;
     _speed          = -1;
-    fpos            = 0;
+    write_begin     = 0;
+    write_end       = 0;
     _draw_upper     = 0;
     sanitize        = true;
     recreate_plan   = true;
     
     spline_buffer = (int*) calloc(200, sizeof(int));
     
-    fft_buffer = (float*) calloc(max_fft_buffer_size, sizeof(float));
+    fft_buffer = (float*) calloc(ring_frames * 2, sizeof(float));
+    fft_snapshot = (float*) calloc(max_fft_cache_size * 2, sizeof(float));
     
     fft_inL = (float*) calloc(max_fft_cache_size, sizeof(float));
     fft_outL = (float*) calloc(max_fft_cache_size, sizeof(float));
@@ -90,6 +92,13 @@ analyzer::~analyzer()
     free(fft_inR);
     free(fft_inL);
     free(spline_buffer);
+    free(fft_snapshot);
+    free(fft_buffer);
+}
+const analyzer::fft_type &analyzer::get_fft()
+{
+    static fft_type fft;
+    return fft;
 }
 void analyzer::set_sample_rate(uint32_t sr) {
     srate = sr;
@@ -134,11 +143,37 @@ void analyzer::set_params(float resolution, float offset, int accuracy, int hold
         redraw_graph = true;
     }
 }
-void analyzer::process(float L, float R) {
-    fft_buffer[fpos] = L;
-    fft_buffer[fpos + 1] = R;
-    fpos += 2;
-    fpos %= (max_fft_buffer_size - 2);
+void analyzer::process(const float *L, const float *R, uint32_t numsamples)
+{
+    uint32_t begin = write_begin;
+    __atomic_store_n(&write_begin, begin + numsamples, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+    for (uint32_t i = 0; i < numsamples; i++) {
+        int pos = ((begin + i) & (ring_frames - 1)) * 2;
+        fft_buffer[pos]     = L ? L[i] : 0.f;
+        fft_buffer[pos + 1] = R ? R[i] : 0.f;
+    }
+    __atomic_store_n(&write_end, begin + numsamples, __ATOMIC_RELEASE);
+}
+
+/// Copy the latest frames into fft_snapshot. Fails if the audio thread
+/// kept overwriting the requested range while it was being copied.
+bool analyzer::take_snapshot(int frames) const
+{
+    for (int tries = 0; tries < 4; tries++) {
+        uint32_t start = __atomic_load_n(&write_end, __ATOMIC_ACQUIRE) - frames;
+        for (int i = 0; i < frames; i++) {
+            int pos = ((start + i) & (ring_frames - 1)) * 2;
+            fft_snapshot[i * 2]     = fft_buffer[pos];
+            fft_snapshot[i * 2 + 1] = fft_buffer[pos + 1];
+        }
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        // frames up to write_begin may have been stored meanwhile, they
+        // must not have reached the start of the copied range
+        if (__atomic_load_n(&write_begin, __ATOMIC_RELAXED) - start <= (uint32_t)ring_frames)
+            return true;
+    }
+    return false;
 }
 
 bool analyzer::do_fft(int subindex, int points) const
@@ -149,17 +184,18 @@ bool analyzer::do_fft(int subindex, int points) const
         sanitize = true;
     }
     if (sanitize) {
-        // null the overall buffer
-        dsp::zero(fft_inL,     max_fft_cache_size);
-        dsp::zero(fft_inR,     max_fft_cache_size);
-        dsp::zero(fft_outL,    max_fft_cache_size);
-        dsp::zero(fft_outR,    max_fft_cache_size);
-        dsp::zero(fft_holdL,   max_fft_cache_size);
-        dsp::zero(fft_holdR,   max_fft_cache_size);
-        dsp::zero(fft_smoothL, max_fft_cache_size);
-        dsp::zero(fft_smoothR, max_fft_cache_size);
-        dsp::zero(fft_deltaL,  max_fft_cache_size);
-        dsp::zero(fft_deltaR,  max_fft_cache_size);
+        // null the part of the buffers the current accuracy can reach
+        int used = std::min(_accuracy * 2, max_fft_cache_size);
+        dsp::zero(fft_inL,     used);
+        dsp::zero(fft_inR,     used);
+        dsp::zero(fft_outL,    used);
+        dsp::zero(fft_outR,    used);
+        dsp::zero(fft_holdL,   used);
+        dsp::zero(fft_holdR,   used);
+        dsp::zero(fft_smoothL, used);
+        dsp::zero(fft_smoothR, used);
+        dsp::zero(fft_deltaL,  used);
+        dsp::zero(fft_deltaR,  used);
         dsp::zero(spline_buffer, 200);
         analyzer_phase_drawn = 0;
         sanitize = false;
@@ -182,20 +218,15 @@ bool analyzer::do_fft(int subindex, int points) const
         // the main buffer and we use this cycle for filling other buffers
         // like smoothing, delta and hold
         // #####################################################################
-        if(!((int)analyzer_phase_drawn % __speed)) {
+        if(!((int)analyzer_phase_drawn % __speed) and take_snapshot(_accuracy)) {
             // seems we have to do a fft, so let's read the latest data from the
-            // buffer to send it to fft afterwards
+            // buffer to send it to fft afterwards (a consistent snapshot of
+            // it, the audio thread keeps writing into the ring)
             // we want to remember old fft_out values for smoothing as well
             // and we fill the hold buffer in this (extra) cycle
             for(int i = 0; i < _accuracy; i++) {
-                // go to the right position back in time according to accuracy
-                // settings and cycling in the main buffer
-                int _fpos = (fpos - _accuracy * 2 \
-                    + (i * 2)) % max_fft_buffer_size;
-                if(_fpos < 0)
-                    _fpos = max_fft_buffer_size + _fpos;
-                float L = fft_buffer[_fpos];
-                float R = fft_buffer[_fpos + 1];
+                float L = fft_snapshot[i * 2];
+                float R = fft_snapshot[i * 2 + 1];
                 float win = 0.54 - 0.46 * cos(2 * M_PI * i / _accuracy);
                 L *= win;
                 R *= win;
@@ -342,6 +373,7 @@ bool analyzer::do_fft(int subindex, int points) const
             // run fft
             // this takes our latest buffer and returns an array with
             // non-normalized
+            const fft_type &fft = get_fft();
             fft.execute_r2r(_acc + 7, fft_inL, fft_outL, fft_temp, false);
             //run fft for for right channel too. it is needed for stereo image 
             //and stereo difference modes
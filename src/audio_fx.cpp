@@ -319,47 +319,70 @@ void reverb::update_times()
 
 void reverb::reset()
 {
-    apL1.reset();apR1.reset();
-    apL2.reset();apR2.reset();
-    apL3.reset();apR3.reset();
-    apL4.reset();apR4.reset();
-    apL5.reset();apR5.reset();
-    apL6.reset();apR6.reset();
-    lp_left.reset();lp_right.reset();
-    old_left = 0; old_right = 0;
-}
-
-void reverb::process(float &left, float &right)
-{
-    unsigned int ipart = phase.ipart();
-
-    // the interpolated LFO might be an overkill here
-    int lfo = phase.lerp_by_fract_int<int, 14, int>(sine.data[ipart], sine.data[ipart+1]) >> 2;
-    phase += dphase;
-
-    left += old_right;
-    left = apL1.process_allpass_comb_lerp16(left, tl[0] - 45*lfo, ldec[0]);
-    left = apL2.process_allpass_comb_lerp16(left, tl[1] + 47*lfo, ldec[1]);
-    float out_left = left;
-    left = apL3.process_allpass_comb_lerp16(left, tl[2] + 54*lfo, ldec[2]);
-    left = apL4.process_allpass_comb_lerp16(left, tl[3] - 69*lfo, ldec[3]);
-    left = apL5.process_allpass_comb_lerp16(left, tl[4] + 69*lfo, ldec[4]);
-    left = apL6.process_allpass_comb_lerp16(left, tl[5] - 46*lfo, ldec[5]);
-    old_left = lp_left.process(left * fb);
-    sanitize(old_left);
-
-    right += old_left;
-    right = apR1.process_allpass_comb_lerp16(right, tr[0] - 45*lfo, rdec[0]);
-    right = apR2.process_allpass_comb_lerp16(right, tr[1] + 47*lfo, rdec[1]);
-    float out_right = right;
-    right = apR3.process_allpass_comb_lerp16(right, tr[2] + 54*lfo, rdec[2]);
-    right = apR4.process_allpass_comb_lerp16(right, tr[3] - 69*lfo, rdec[3]);
-    right = apR5.process_allpass_comb_lerp16(right, tr[4] + 69*lfo, rdec[4]);
-    right = apR6.process_allpass_comb_lerp16(right, tr[5] - 46*lfo, rdec[5]);
-    old_right = lp_right.process(right * fb);
-    sanitize(old_right);
-
-    left = out_left, right = out_right;
+    memset(ap, 0, sizeof(ap));
+    pos = 0;
+    stereo zero = { 0.f, 0.f };
+    lp_x1 = lp_y1 = old = zero;
+}
+
+void reverb::process(float *left, float *right, uint32_t nsamples)
+{
+    for (uint32_t i = 0; i < nsamples; i += LfoBlock)
+        process_chunk(left + i, right + i, std::min<uint32_t>(LfoBlock, nsamples - i));
+}
+
+void reverb::process_chunk(float *left, float *right, uint32_t nsamples)
+{
+    // per-stage LFO depth, the sign alternates between stages
+    static const int lfo_depth[Stages] = { -45, 47, 54, -69, 69, -46 };
+    int lfo[LfoBlock];
+    for (uint32_t i = 0; i < nsamples; i++)
+    {
+        unsigned int ipart = phase.ipart();
+        // the interpolated LFO might be an overkill here
+        lfo[i] = phase.lerp_by_fract_int<int, 14, int>(sine.data[ipart], sine.data[ipart+1]) >> 2;
+        phase += dphase;
+    }
+
+    stereo dec[Stages];
+    for (int s = 0; s < Stages; s++)
+        dec[s] = (stereo){ ldec[s], rdec[s] };
+    stereo a0 = { lp_left.a0, lp_right.a0 }, a1 = { lp_left.a1, lp_right.a1 }, b1 = { lp_left.b1, lp_right.b1 };
+    stereo x1 = lp_x1, y1 = lp_y1, feedback = old;
+    stereo gain = { fb, fb };
+    int p = pos;
+
+    for (uint32_t i = 0; i < nsamples; i++)
+    {
+        stereo sig = { left[i] + feedback[1], right[i] + feedback[0] }, out = sig;
+        for (int s = 0; s < Stages; s++)
+        {
+            // comb allpass with a linearly interpolated, modulated delay
+            unsigned int dl = tl[s] + lfo_depth[s] * lfo[i], dr = tr[s] + lfo_depth[s] * lfo[i];
+            const float *line = (const float *)ap[s];
+            int pl = (p - (dl >> 16)) & DelayMask, pr = (p - (dr >> 16)) & DelayMask;
+            float l0 = line[2 * pl], l1 = line[2 * ((pl - 1) & DelayMask)];
+            float r0 = line[2 * pr + 1], r1 = line[2 * ((pr - 1) & DelayMask) + 1];
+            stereo delayed = { l0 + (l1 - l0) * fract16(dl), r0 + (r1 - r0) * fract16(dr) };
+            stereo cur = sanitize_lanes(sig + dec[s] * delayed);
+            ap[s][p] = cur;
+            sig = delayed - dec[s] * cur;
+            if (s == 1)
+                out = sig;
+        }
+        // damping lowpass in the feedback path
+        sig *= gain;
+        feedback = sig * a0 + x1 * a1 - y1 * b1;
+        x1 = sig;
+        y1 = feedback;
+        p = (p + 1) & DelayMask;
+        left[i] = out[0];
+        right[i] = out[1];
+    }
+    lp_x1 = x1;
+    lp_y1 = y1;
+    old = sanitize_lanes(feedback);
+    pos = p;
 }
 
 /// Distortion Module by Tom Szilagyi
@@ -587,6 +610,10 @@ lookahead_limiter::lookahead_limiter() {
     id = 0;
     buffer_size = 0;
     overall_buffer_size = 0;
+    allocated_size = 0;
+    buffer = NULL;
+    nextpos = NULL;
+    nextdelta = NULL;
     att = 1.f;
     att_max = 1.0;
     pos = 0;
@@ -637,17 +664,31 @@ float lookahead_limiter::get_attenuation()
     return a;
 }
 
+void lookahead_limiter::allocate(uint32_t max_sr)
+{
+    int size = (int)(max_sr * (100.f / 1000.f) * channels) + channels; // buffer size max attack rate multiplied by 2 channels
+    if (size <= allocated_size)
+        return;
+    free(buffer);
+    free(nextpos);
+    free(nextdelta);
+    buffer = (float*) calloc(size, sizeof(float));
+    nextdelta = (float*) calloc(size, sizeof(float));
+    nextpos = (int*) malloc(size * sizeof(int));
+    memset(nextpos, -1, size * sizeof(int));
+    allocated_size = size;
+}
+
 void lookahead_limiter::set_sample_rate(uint32_t sr)
 {
     srate = sr;
-    // rebuild buffer
+    // rebuild buffer - the memory is normally preallocated by allocate()
     overall_buffer_size = (int)(srate * (100.f / 1000.f) * channels) + channels; // buffer size attack rate multiplied by 2 channels
-    buffer = (float*) calloc(overall_buffer_size, sizeof(float));
-    pos = 0;
-
-    nextdelta = (float*) calloc(overall_buffer_size, sizeof(float));
-    nextpos = (int*) malloc(overall_buffer_size * sizeof(int));
+    allocate(srate);
+    memset(buffer, 0, overall_buffer_size * sizeof(float));
+    memset(nextdelta, 0, overall_buffer_size * sizeof(float));
     memset(nextpos, -1, overall_buffer_size * sizeof(int));
+    pos = 0;
     
     reset();
 }
@@ -1053,6 +1094,7 @@ void crossover::init(int c, int b, uint32_t sr) {
     channels = std::min(8, c);
     bands    = std::min(8, b);
     srate    = sr;
+    sanitize_counter = 0;
     for(int b = 0; b < bands; b ++) {
         // reset frequency settings
         freq[b]     = 1.0;
@@ -1063,6 +1105,15 @@ void crossover::init(int c, int b, uint32_t sr) {
             out[c][b] = 0.f;
         }
     }
+    // lanes of the outermost bands don't filter on that side
+    for (int f = 0; f < 4; f++) {
+        for (int l = 0; l < 64; l++) {
+            lp_bank[f].set_null(l);
+            hp_bank[f].set_null(l);
+        }
+        lp_bank[f].reset();
+        hp_bank[f].reset();
+    }
 }
 float crossover::set_filter(int b, float f, bool force) {
     // keep between neighbour bands
@@ -1089,29 +1140,24 @@ float crossover::set_filter(int b, float f, bool force) {
             q = 0.54;
             break;
     }
+    lp[b][0].set_lp_rbj(freq[b], q, (float)srate);
+    hp[b][0].set_hp_rbj(freq[b], q, (float)srate);
+    if (mode > 1) {
+        lp[b][1].set_lp_rbj(freq[b], 1.34, (float)srate);
+        hp[b][1].set_hp_rbj(freq[b], 1.34, (float)srate);
+        lp[b][2].copy_coeffs(lp[b][0]);
+        hp[b][2].copy_coeffs(hp[b][0]);
+        lp[b][3].copy_coeffs(lp[b][1]);
+        hp[b][3].copy_coeffs(hp[b][1]);
+    } else {
+        lp[b][1].copy_coeffs(lp[b][0]);
+        hp[b][1].copy_coeffs(hp[b][0]);
+    }
+    // split point b is the low pass of band b and the high pass of band b + 1
     for (int c = 0; c < channels; c ++) {
-        if (!c) {
-            lp[c][b][0].set_lp_rbj(freq[b], q, (float)srate);
-            hp[c][b][0].set_hp_rbj(freq[b], q, (float)srate);
-        } else {
-            lp[c][b][0].copy_coeffs(lp[c-1][b][0]);
-            hp[c][b][0].copy_coeffs(hp[c-1][b][0]);
-        }
-        if (mode > 1) {
-            if (!c) {
-                lp[c][b][1].set_lp_rbj(freq[b], 1.34, (float)srate);
-                hp[c][b][1].set_hp_rbj(freq[b], 1.34, (float)srate);
-            } else {
-                lp[c][b][1].copy_coeffs(lp[c-1][b][1]);
-                hp[c][b][1].copy_coeffs(hp[c-1][b][1]);
-            }
-            lp[c][b][2].copy_coeffs(lp[c][b][0]);
-            hp[c][b][2].copy_coeffs(hp[c][b][0]);
-            lp[c][b][3].copy_coeffs(lp[c][b][1]);
-            hp[c][b][3].copy_coeffs(hp[c][b][1]);
-        } else {
-            lp[c][b][1].copy_coeffs(lp[c][b][0]);
-            hp[c][b][1].copy_coeffs(hp[c][b][0]);
+        for (int i = 0; i < 4; i++) {
+            lp_bank[i].copy_coeffs(c * bands + b, lp[b][i]);
+            hp_bank[i].copy_coeffs(c * bands + b + 1, hp[b][i]);
         }
     }
     redraw_graph = std::min(2, redraw_graph + 1);
@@ -1139,20 +1185,24 @@ void crossover::set_level(int b, float l) {
     redraw_graph = std::min(2, redraw_graph + 1);
 }
 void crossover::process(float *data) {
-    for (int c = 0; c < channels; c++) {
-        for(int b = 0; b < bands; b ++) {
-            out[c][b] = data[c];
-            for (int f = 0; f < get_filter_count(); f++){
-                if(b + 1 < bands) {
-                    out[c][b] = lp[c][b][f].process(out[c][b]);
-                    lp[c][b][f].sanitize();
-                }
-                if(b - 1 >= 0) {
-                    out[c][b] = hp[c][b - 1][f].process(out[c][b]);
-                    hp[c][b - 1][f].sanitize();
-                }
-            }
-            out[c][b] *= level[b];
+    double lanes[64] __attribute__((aligned(32)));
+    int count = channels * bands;
+    for (int c = 0; c < channels; c++)
+        for(int b = 0; b < bands; b ++)
+            lanes[c * bands + b] = data[c];
+    for (int f = 0; f < get_filter_count(); f++) {
+        lp_bank[f].process(lanes, 0, count);
+        hp_bank[f].process(lanes, 0, count);
+    }
+    for (int c = 0; c < channels; c++)
+        for(int b = 0; b < bands; b ++)
+            out[c][b] = lanes[c * bands + b] * level[b];
+    // denormals can only build up slowly, no need to check every sample
+    if (++sanitize_counter >= 64) {
+        sanitize_counter = 0;
+        for (int f = 0; f < get_filter_count(); f++) {
+            lp_bank[f].sanitize();
+            hp_bank[f].sanitize();
         }
     }
 }
@@ -1172,9 +1222,9 @@ bool crossover::get_graph(int subindex, int phase, float *data, int points, cair
         freq = 20.0 * pow (20000.0 / 20.0, i * 1.0 / points);
         for(int f = 0; f < get_filter_count(); f ++) {
             if(subindex < bands -1)
-                ret *= lp[0][subindex][f].freq_gain(freq, (float)srate);
+                ret *= lp[subindex][f].freq_gain(freq, (float)srate);
             if(subindex > 0)
-                ret *= hp[0][subindex - 1][f].freq_gain(freq, (float)srate);
+                ret *= hp[subindex - 1][f].freq_gain(freq, (float)srate);
         }
         ret *= level[subindex];
         context->set_source_rgba(0.15, 0.2, 0.0, !active[subindex] ? 0.3 : 0.8);
@@ -1339,52 +1389,141 @@ bool bitreduction::get_gridline(int subindex, int phase, float &pos, bool &verti
 
 //////////////////////////////////////////////////////////////////
 
+/// Zeroth order modified Bessel function of the first kind (for the Kaiser window)
+static double bessel_i0(double x)
+{
+    double sum = 1, term = 1, q = x * x / 4;
+    for (int k = 1; k < 32 && term > sum * 1e-12; k++) {
+        term *= q / (k * k);
+        sum += term;
+    }
+    return sum;
+}
+
 resampleN::resampleN()
 {
-    factor  = 2;
     srate   = 0;
+    factor  = 2;
     filters = 2;
+    taps    = 0;
+    length  = 1;
+    set_params(44100, 2, 2);
 }
 resampleN::~resampleN()
 {
-    free(tmp);
 }
 void resampleN::set_params(uint32_t sr, int fctr = 2, int fltrs = 2)
 {
     srate   = sr;
-    factor  = std::min(16, std::max(1, fctr));
+    factor  = std::min((int)max_factor, std::max(1, fctr));
     filters = std::min(4, std::max(1, fltrs));
-    // set all filters
-    filter[0][0].set_lp_rbj(std::max(25000., (double)srate / 2), 0.8, (float)srate * factor);
-    for (int i = 1; i < filters; i++) {
-        filter[0][i].copy_coeffs(filter[0][0]);
-        filter[1][i].copy_coeffs(filter[0][0]);
+    taps    = max_taps * filters / 4;
+    length  = factor * taps + 1;
+    // Kaiser windowed sinc, cutoff slightly below the base rate Nyquist
+    // frequency, normalized to unity gain at DC
+    const double beta = 7.0;
+    double fc = 0.46 / factor, center = 0.5 * (length - 1), i0beta = bessel_i0(beta), sum = 0;
+    for (int i = 0; i < length; i++) {
+        double x = i - center, r = x / center;
+        double sinc = x ? sin(2 * M_PI * fc * x) / (M_PI * x) : 2 * fc;
+        double c = sinc * bessel_i0(beta * sqrt(std::max(0.0, 1 - r * r))) / i0beta;
+        kernel[i] = c;
+        sum += c;
     }
+    for (int i = 0; i < length; i++)
+        kernel[i] /= sum;
+    // branch p computes output p of each input sample; zero stuffing loses
+    // (factor - 1) / factor of the energy, hence the gain of factor
+    for (int p = 0; p < factor; p++)
+        for (int j = 0; j <= taps; j++) {
+            int k = p + (taps - j) * factor;
+            branch[p][j] = k < length ? kernel[k] * factor : 0.f;
+        }
+    reset();
+}
+void resampleN::reset()
+{
+    up_pos = down_pos = 0;
+    dsp::zero(up_hist, 2 * (max_taps + 1));
+    dsp::zero(down_hist, 2 * max_length);
+}
+// Histories are stored twice in a row so that the most recent taps + 1
+// (or length) samples are always contiguous, oldest first, at hist + pos
+inline void resampleN::push_up(float sample)
+{
+    up_hist[up_pos] = up_hist[up_pos + taps + 1] = sample;
+    if (++up_pos > taps)
+        up_pos = 0;
+}
+inline float resampleN::branch_out(int phase) const
+{
+    const float *h = branch[phase], *x = up_hist + up_pos;
+    float sum = 0.f;
+    for (int j = 0; j <= taps; j++)
+        sum += h[j] * x[j];
+    return sum;
+}
+inline void resampleN::push_down(float sample)
+{
+    down_hist[down_pos] = down_hist[down_pos + length] = sample;
+    if (++down_pos >= length)
+        down_pos = 0;
+}
+inline float resampleN::kernel_out() const
+{
+    // the kernel is symmetric, no need to reverse it
+    const float *x = down_hist + down_pos;
+    float sum = 0.f;
+    for (int j = 0; j < length; j++)
+        sum += kernel[j] * x[j];
+    return sum;
 }
 double *resampleN::upsample(double sample)
 {
-    tmp[0] = sample;
-    if (factor > 1) {
-        for (int f = 0; f < filters; f++)
-            tmp[0] = filter[0][f].process(sample);
-        for (int i = 1; i < factor; i++) {
-            tmp[i] = 0;
-            for (int f = 0; f < filters; f++)
-                tmp[i] = filter[0][f].process(sample);
-        }
+    if (factor == 1) {
+        tmp[0] = sample;
+        return tmp;
     }
+    push_up(sample);
+    for (int p = 0; p < factor; p++)
+        tmp[p] = branch_out(p);
     return tmp;
 }
 double resampleN::downsample(double *sample)
 {
-    if (factor > 1) {
-        for(int i = 0; i < factor; i++) {
-            for (int f = 0; f < filters; f++) {
-                sample[i] = filter[1][f].process(sample[i]);
-            }
-        }
+    if (factor == 1)
+        return sample[0];
+    // decimate at phase 0 so the round trip delay is a whole number of samples
+    push_down(sample[0]);
+    double out = kernel_out();
+    for (int i = 1; i < factor; i++)
+        push_down(sample[i]);
+    return out;
+}
+void resampleN::upsample(const float *src, float *dst, uint32_t numsamples)
+{
+    if (factor == 1) {
+        memcpy(dst, src, numsamples * sizeof(float));
+        return;
+    }
+    for (uint32_t i = 0; i < numsamples; i++) {
+        push_up(src[i]);
+        for (int p = 0; p < factor; p++)
+            *dst++ = branch_out(p);
+    }
+}
+void resampleN::downsample(const float *src, float *dst, uint32_t numsamples)
+{
+    if (factor == 1) {
+        memcpy(dst, src, numsamples * sizeof(float));
+        return;
+    }
+    for (uint32_t i = 0; i < numsamples; i++) {
+        push_down(*src++);
+        dst[i] = kernel_out();
+        for (int p = 1; p < factor; p++)
+            push_down(*src++);
     }
-    return sample[0];
 }
 
 //////////////////////////////////////////////////////////////////
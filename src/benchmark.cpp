@@ -150,11 +150,145 @@ struct filter_12dB_lp_d2: public filter_lp24dB_benchmark<biquad_d2 >
     }
 };
 
+/// 32 band pass filters fed with the same signal (vocoder-like)
+struct filter_bank_benchmark
+{
+    enum { BUF_SIZE = 256, BANDS = 32 };
+    float buffer[BUF_SIZE], output[BUF_SIZE];
+    float result;
+    biquad_d2 filters[BANDS];
+    biquad_d2_bank<BANDS> bank;
+    void prepare()
+    {
+        for (int i = 0; i < BUF_SIZE; i++)
+            buffer[i] = (i % 17) - 8;
+        for (int i = 0; i < BANDS; i++)
+        {
+            filters[i].set_bp_rbj(50 * pow(1.2, i), 4, 44100);
+            bank.copy_coeffs(i, filters[i]);
+        }
+        result = 0;
+    }
+    void cleanup() { result = output[BUF_SIZE - 1]; }
+    double scaler() { return BUF_SIZE; }
+};
+
+struct filter_32bands_d2: public filter_bank_benchmark
+{
+    void run()
+    {
+        for (int i = 0; i < BUF_SIZE; i++)
+        {
+            float sum = 0;
+            for (int j = 0; j < BANDS; j++)
+                sum += filters[j].process(buffer[i]);
+            output[i] = sum;
+        }
+    }
+};
+
+struct filter_32bands_bank: public filter_bank_benchmark
+{
+    void run()
+    {
+        float lanes[BANDS] __attribute__((aligned(32)));
+        for (int i = 0; i < BUF_SIZE; i++)
+        {
+            for (int j = 0; j < BANDS; j++)
+                lanes[j] = buffer[i];
+            bank.process(lanes);
+            float sum = 0;
+            for (int j = 0; j < BANDS; j++)
+                sum += lanes[j];
+            output[i] = sum;
+        }
+    }
+};
+
+/// 16 filters in series (multispread-like)
+struct filter_16stages_d2: public filter_bank_benchmark
+{
+    void run()
+    {
+        for (int i = 0; i < BUF_SIZE; i++)
+        {
+            double v = buffer[i];
+            for (int j = 0; j < 16; j++)
+                v = filters[j].process(v);
+            output[i] = v;
+        }
+    }
+};
+
+struct filter_16stages_bank: public filter_bank_benchmark
+{
+    biquad_d2_bank<16, double> chain;
+    void prepare()
+    {
+        filter_bank_benchmark::prepare();
+        for (int i = 0; i < 16; i++)
+            chain.copy_coeffs(i, filters[i]);
+    }
+    void run()
+    {
+        chain.process_cascade(buffer, output, BUF_SIZE, 16);
+    }
+};
+
+/// Stereo compressor fed with a signal that keeps it in the knee region
+struct gain_reduction_benchmark
+{
+    enum { BUF_SIZE = 256 };
+    float left[BUF_SIZE], right[BUF_SIZE], outL[BUF_SIZE], outR[BUF_SIZE];
+    float result;
+    calf_plugins::gain_reduction_audio_module compressor;
+    void prepare()
+    {
+        for (int i = 0; i < BUF_SIZE; i++)
+        {
+            left[i] = 0.5 * sin(i * 0.1);
+            right[i] = 0.25 * cos(i * 0.07);
+        }
+        compressor.set_sample_rate(44100);
+        compressor.set_params(0.1, 100, 0.125, 4, 2.8, 1, 0, 0, 0, 0);
+        compressor.update_curve();
+        compressor.activate();
+        result = 0;
+    }
+    void cleanup() { result = outL[BUF_SIZE - 1] + outR[BUF_SIZE - 1]; }
+    double scaler() { return BUF_SIZE; }
+};
+
+struct gain_reduction_per_sample: public gain_reduction_benchmark
+{
+    void run()
+    {
+        for (int i = 0; i < BUF_SIZE; i++)
+        {
+            outL[i] = left[i];
+            outR[i] = right[i];
+            compressor.process(outL[i], outR[i]);
+        }
+    }
+};
+
+struct gain_reduction_block: public gain_reduction_benchmark
+{
+    void run()
+    {
+        compressor.process_block(left, right, outL, outR, BUF_SIZE);
+    }
+};
+
 template<int N>
 struct fft_test_class
 {
     typedef fft<float, N> fft_class;
-    fft_class ffter;
+    static const fft_class &ffter()
+    {
+        static fft_class instance;
+        return instance;
+    }
     float result;
     complex<float> data[1 << N], output[1 << N];
     void prepare() {
@@ -167,7 +301,34 @@ struct fft_test_class
     }
     void run()
     {
-        ffter.calculate(data, output, false);
+        ffter().calculate(data, output, false);
+    }
+    double scaler() { return 1 << N; }
+};
+
+template<int N>
+struct rfft_test_class
+{
+    typedef fft<float, N> fft_class;
+    static const fft_class &ffter()
+    {
+        static fft_class instance;
+        return instance;
+    }
+    float result;
+    float data[1 << N];
+    complex<float> output[(1 << (N - 1)) + 1];
+    void prepare() {
+        for (int i = 0; i < (1 << N); i++)
+            data[i] = sin(i);
+        result = 0;
+    }
+    void cleanup()
+    {
+    }
+    void run()
+    {
+        ffter().rfft(N, data, output);
     }
     double scaler() { return 1 << N; }
 };
@@ -235,11 +396,22 @@ void biquad_test()
         do_simple_benchmark<filter_24dB_lp_onepass_d2>();
         do_simple_benchmark<filter_24dB_lp_onepass_d2_lp>();
         do_simple_benchmark<filter_12dB_lp_d2>();
+        do_simple_benchmark<filter_32bands_d2>();
+        do_simple_benchmark<filter_32bands_bank>();
+        do_simple_benchmark<filter_16stages_d2>();
+        do_simple_benchmark<filter_16stages_bank>();
+}
+
+void dynamics_test()
+{
+        do_simple_benchmark<gain_reduction_per_sample>();
+        do_simple_benchmark<gain_reduction_block>();
 }
 
 void fft_test()
 {
         do_simple_benchmark<fft_test_class<17> >(5, 10);
+        do_simple_benchmark<rfft_test_class<17> >(5, 10);
 }
 
 void alignment_test()
@@ -253,13 +425,15 @@ template<class Effect>
 void get_default_effect_params(float params[Effect::param_count], uint32_t &sr);
 
 template<>
-void get_default_effect_params<calf_plugins::reverb_audio_module>(float params[3], uint32_t &sr)
+void get_default_effect_params<calf_plugins::reverb_audio_module>(float params[], uint32_t &sr)
 {
     typedef calf_plugins::reverb_audio_module mod;
+    for (int i = 0; i < mod::param_count; i++)
+        params[i] = mod::param_props[i].def_value;
     params[mod::par_decay] = 4;
     params[mod::par_hfdamp] = 2000;
     params[mod::par_amount] = 2;
-    sr = 4000;
+    sr = 44100;
 }
 
 template<>
@@ -504,7 +678,7 @@ int main(int argc, char *argv[])
         switch(c) {
             case 'h':
             case '?':
-                printf("Benchmark suite Calf plugin pack\nSyntax: %s [--help] [--version] [--unit biquad|alignment|effects]\n", argv[0]);
+                printf("Benchmark suite Calf plugin pack\nSyntax: %s [--help] [--version] [--unit biquad|alignment|effects|dynamics]\n", argv[0]);
                 return 0;
             case 'v':
                 printf("%s\n", PACKAGE_STRING);
@@ -538,6 +712,9 @@ int main(int argc, char *argv[])
     if (unit && !strcmp(unit, "aweighting"))
         aweighting_calc();
 
+    if (!unit || !strcmp(unit, "dynamics"))
+        dynamics_test();
+
     if (!unit || !strcmp(unit, "fft"))
         fft_test();
     
@@ -60,7 +60,8 @@ private:
 public:
     uint32_t srate;
     analyzer();
-    void process(float L, float R);
+    /// Feed numsamples stereo frames from the audio thread, NULL means silence
+    void process(const float *L, const float *R, uint32_t numsamples);
     void set_sample_rate(uint32_t sr);
     bool set_mode(int mode);
     void invalidate();
@@ -73,16 +74,25 @@ public:
     bool get_gridline(int subindex, int phase, float &pos, bool &vertical, std::string &legend, cairo_iface *context) const;
     bool get_layers(int generation, unsigned int &layers) const;
 protected:
-    int fft_buffer_size;
-    float *fft_buffer;
     int *spline_buffer;
-    int fpos;
     mutable bool sanitize, recreate_plan;
     static const int MAX_FFT_ORDER = 15;
-    dsp::fft<float, MAX_FFT_ORDER> fft;
-    mutable dsp::fft<float, MAX_FFT_ORDER>::complex fft_temp[1 << MAX_FFT_ORDER];
+    typedef dsp::fft<float, MAX_FFT_ORDER> fft_type;
+    /// FFT plan, shared between all analyzer instances
+    static const fft_type &get_fft();
+    mutable fft_type::complex fft_temp[(1 << (MAX_FFT_ORDER - 1)) + 1];
     static const int max_fft_cache_size = 32768;
-    static const int max_fft_buffer_size = max_fft_cache_size * 2;
+    /// Stereo frames in the ring buffer. Twice the largest FFT, so a snapshot
+    /// can be copied while the audio thread keeps writing.
+    static const int ring_frames = max_fft_cache_size * 2;
+    /// Interleaved L/R ring buffer, written by the audio thread only
+    float *fft_buffer;
+    /// Sequence numbers (frames written so far). write_begin is raised
+    /// before a block is stored, write_end after it has been stored.
+    uint32_t write_begin, write_end;
+    /// Interleaved copy of the most recent frames, GUI thread only
+    float *fft_snapshot;
+    bool take_snapshot(int frames) const;
     float *fft_inL, *fft_outL;
     float *fft_inR, *fft_outR;
     float *fft_smoothL, *fft_smoothR;
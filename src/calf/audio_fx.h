@@ -347,24 +347,43 @@ public:
 };
 
 /**
- * A classic allpass loop reverb with modulated allpass filter.
- * Just started implementing it, so there is no control over many
- * parameters.
+ * Stereo reverb made of two chains of six modulated allpass combs, fed into
+ * each other through a damping lowpass. The chains run side by side as the
+ * two lanes of a vector, with the delay lines interleaved, so every stage
+ * does the arithmetic for both channels at once. The LFO is calculated
+ * for the whole block before the chains are run.
  */
 class reverb: public audio_effect
 {
-    simple_delay<2048, float> apL1, apL2, apL3, apL4, apL5, apL6;
-    simple_delay<2048, float> apR1, apR2, apR3, apR4, apR5, apR6;
+    typedef float stereo __attribute__((vector_size(8)));
+    typedef int32_t stereo_mask __attribute__((vector_size(8)));
+    enum { Stages = 6, DelaySize = 2048, DelayMask = DelaySize - 1, LfoBlock = 64 };
+    /// Allpass delay lines, left and right channel interleaved
+    stereo ap[Stages][DelaySize];
+    int pos;
     fixed_point<unsigned int, 25> phase, dphase;
     sine_table<int, 128, 10000> sine;
+    /// Only the coefficients are used, the state is in lp_x1/lp_y1
     onepole<float> lp_left, lp_right;
-    float old_left, old_right;
+    stereo lp_x1, lp_y1;
+    /// Output of the damping filters, fed into the other channel
+    stereo old;
     int type;
     float time, fb, cutoff, diffusion;
     int tl[6], tr[6];
     float ldec[6], rdec[6];
 
     int sr;
+
+    /// Zero the lanes that are too small to matter (and denormals)
+    static inline stereo sanitize_lanes(stereo v)
+    {
+        static const stereo_mask abs_mask = { 0x7FFFFFFF, 0x7FFFFFFF };
+        static const stereo small = { 1.0 / 16777216.0, 1.0 / 16777216.0 };
+        stereo_mask keep = (stereo)((stereo_mask)v & abs_mask) >= small;
+        return (stereo)((stereo_mask)v & keep);
+    }
+    void process_chunk(float *left, float *right, uint32_t nsamples);
 public:
     reverb()
     {
@@ -428,11 +447,17 @@ public:
         lp_right.set_lp(cutoff,sr);
     }
     void reset();
-    void process(float &left, float &right);
+    /// Process one sample in place
+    void process(float &left, float &right)
+    {
+        process(&left, &right, 1);
+    }
+    /// Process a block of samples in place
+    void process(float *left, float *right, uint32_t nsamples);
     void extra_sanitize()
     {
-        lp_left.sanitize();
-        lp_right.sanitize();
+        lp_x1 = sanitize_lanes(lp_x1);
+        lp_y1 = sanitize_lanes(lp_y1);
     }
 };
 
@@ -562,6 +587,7 @@ public:
     int pos; // where we are actually in our sample buffer
     int buffer_size;
     int overall_buffer_size;
+    int allocated_size; // number of elements in buffer, nextpos and nextdelta
     bool is_active;
     bool debug;
     bool auto_release;
@@ -598,9 +624,14 @@ public:
     ~lookahead_limiter();
     void set_multi(bool set);
     void process(float &left, float &right, float *multi_buffer);
+    /// Allocate the buffers for sample rates up to max_sr (not realtime safe)
+    void allocate(uint32_t max_sr);
+    /// Change the sample rate, allocates only if it exceeds the rate passed to allocate()
     void set_sample_rate(uint32_t sr);
     void set_params(float l, float a, float r, float weight = 1.f, bool ar = false, float arc = 1.f, bool d = false);
     float get_attenuation();
+    /// Delay of the lookahead buffer in samples (at the limiter's sample rate)
+    int get_latency() const { return std::max(0, buffer_size / channels - 1); }
     void activate();
     void deactivate();
 };
@@ -635,7 +666,11 @@ private:
 public:
     int channels, bands, mode;
     float freq[8], active[8], level[8], out[8][8];
-    dsp::biquad_d2 lp[8][8][4], hp[8][8][4];
+    /// Coefficients of the low and high pass stages for each split point
+    dsp::biquad_coeffs lp[8][4], hp[8][4];
+    /// Filter stages, one lane per channel and band (channel * bands + band)
+    dsp::biquad_d2_bank<64, double> lp_bank[4], hp_bank[4];
+    int sanitize_counter;
     mutable int redraw_graph;
     uint32_t srate;
     crossover();
@@ -672,20 +707,43 @@ public:
     bool get_gridline(int subindex, int phase, float &pos, bool &vertical, std::string &legend, calf_plugins::cairo_iface *context) const;
 };
 
+/// Integer factor oversampler. Interpolation and decimation share one linear
+/// phase Kaiser windowed sinc lowpass, split into polyphase branches for the
+/// upsampling side, so an up/down round trip delays the signal by exactly
+/// get_latency() samples at the base rate.
 class resampleN
 {
+public:
+    enum { max_factor = 16, max_taps = 32, max_length = max_factor * max_taps + 1 };
 private:
+    int taps; // taps per polyphase branch (= round trip latency)
+    int length; // length of the prototype lowpass, factor * taps + 1
+    int up_pos, down_pos;
+    float kernel[max_length]; // prototype lowpass (symmetric)
+    float branch[max_factor][max_taps + 1]; // polyphase branches, oldest input first
+    float up_hist[2 * (max_taps + 1)];
+    float down_hist[2 * max_length];
+    inline void push_up(float sample);
+    inline float branch_out(int phase) const;
+    inline void push_down(float sample);
+    inline float kernel_out() const;
 public:
     uint32_t srate; // sample rate; source for upsampling, target for downsampling
     int factor; // number of added/removed samples, max 16
-    int filters; // how many lowpasses should be used, max 4
-    double tmp[16];
-    dsp::biquad_d2 filter[2][4];
+    int filters; // quality/latency tier 1..4 (8, 16, 24 or 32 taps per branch)
+    double tmp[max_factor];
     resampleN();
     ~resampleN();
     void set_params(uint32_t sr, int factor, int filters);
+    void reset();
     double *upsample(double sample);
     double downsample(double *sample);
+    /// Upsample numsamples samples from src into numsamples * factor samples in dst
+    void upsample(const float *src, float *dst, uint32_t numsamples);
+    /// Downsample numsamples * factor samples from src into numsamples samples in dst
+    void downsample(const float *src, float *dst, uint32_t numsamples);
+    /// Delay of an upsample/downsample round trip in samples at the base rate
+    int get_latency() const { return factor > 1 ? taps : 0; }
 };
 
 class samplereduction
@@ -722,6 +780,8 @@ public:
     void set_sample_rate(uint32_t sr);
     float process(float in);
     float get_distortion_level();
+    /// Delay introduced by the oversampling filters, in samples
+    int get_latency() const { return resampler.get_latency(); }
     static inline float M(float x)
     {
         return (fabs(x) > 0.00000001f) ? x : 0.0f;
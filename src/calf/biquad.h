@@ -24,6 +24,8 @@
 #define __CALF_BIQUAD_H
 
 #include <complex>
+#include <stdint.h>
+#include <string.h>
 #include "primitives.h"
 
 namespace dsp {
@@ -582,6 +584,182 @@ struct biquad_d1_lerp: public biquad_coeffs
     
 };
     
+/// Size (in bytes) of the vectors used by biquad_d2_bank
+#if defined(__AVX__)
+#define CALF_BIQUAD_BANK_BYTES 32
+#else
+#define CALF_BIQUAD_BANK_BYTES 16
+#endif
+
+/// Vector types used by biquad_d2_bank (GCC vector extensions, which compile
+/// to SSE/SSE2 or AVX instructions when available)
+template<class T>
+struct biquad_bank_traits;
+
+template<>
+struct biquad_bank_traits<float>
+{
+    typedef float vec __attribute__((vector_size(CALF_BIQUAD_BANK_BYTES)));
+    typedef int32_t mask __attribute__((vector_size(CALF_BIQUAD_BANK_BYTES)));
+};
+
+template<>
+struct biquad_bank_traits<double>
+{
+    typedef double vec __attribute__((vector_size(CALF_BIQUAD_BANK_BYTES)));
+    typedef int64_t mask __attribute__((vector_size(CALF_BIQUAD_BANK_BYTES)));
+};
+
+/**
+ * A set of independent two-pole two-zero filters, stored as structure of
+ * arrays, so that several filters are processed by a single instruction
+ * (4 or 8 in single precision, 2 or 4 in double precision, for SSE or AVX).
+ * Lanes are either unrelated filters fed with one sample each (process), or
+ * stages of a single series chain (process_cascade).
+ *
+ * The state uses transposed Direct II form. Single precision is fine for
+ * band pass filters, but low shelves, low peaks and crossovers below a few
+ * hundred Hz need T = double to keep the noise floor where biquad_d2 has it.
+ */
+template<int Lanes, class T = float>
+struct biquad_d2_bank
+{
+    typedef typename biquad_bank_traits<T>::vec vec;
+    typedef typename biquad_bank_traits<T>::mask mask;
+    enum { width = CALF_BIQUAD_BANK_BYTES / sizeof(T), lanes = (Lanes + width - 1) / width * width };
+    // no more than the heap guarantees, the banks live inside modules created with new
+    T a0[lanes] __attribute__((aligned(16)));
+    T a1[lanes] __attribute__((aligned(16)));
+    T a2[lanes] __attribute__((aligned(16)));
+    T b1[lanes] __attribute__((aligned(16)));
+    T b2[lanes] __attribute__((aligned(16)));
+    /// transposed direct II state
+    T s1[lanes] __attribute__((aligned(16)));
+    T s2[lanes] __attribute__((aligned(16)));
+
+    static inline vec load(const T *src)
+    {
+        vec v;
+        memcpy(&v, src, sizeof(v));
+        return v;
+    }
+    static inline void store(T *dest, vec v)
+    {
+        memcpy(dest, &v, sizeof(v));
+    }
+    static inline vec select(mask m, vec a, vec b)
+    {
+        return (vec)(((mask)a & m) | ((mask)b & ~m));
+    }
+
+    /// Constructor (all lanes pass the signal through unchanged)
+    biquad_d2_bank()
+    {
+        for (int i = 0; i < lanes; i++)
+            set_null(i);
+        reset();
+    }
+    /// Make a lane pass the signal through unchanged
+    inline void set_null(int lane)
+    {
+        a0[lane] = 1;
+        a1[lane] = a2[lane] = b1[lane] = b2[lane] = 0;
+    }
+    /// Use coefficients of a single filter for a lane
+    inline void copy_coeffs(int lane, const biquad_coeffs &src)
+    {
+        a0[lane] = src.a0;
+        a1[lane] = src.a1;
+        a2[lane] = src.a2;
+        b1[lane] = src.b1;
+        b2[lane] = src.b2;
+    }
+    /// Reset state variables
+    inline void reset()
+    {
+        memset(s1, 0, sizeof(s1));
+        memset(s2, 0, sizeof(s2));
+    }
+    /// Sanitize (set to 0 if potentially denormal) state of all lanes
+    inline void sanitize()
+    {
+        vec zero = (vec){};
+        vec small = zero + small_value<T>();
+        for (int i = 0; i < lanes; i += width)
+        {
+            vec v1 = load(s1 + i), v2 = load(s2 + i);
+            store(s1 + i, select((v1 < small) & (v1 > -small), zero, v1));
+            store(s2 + i, select((v2 < small) & (v2 > -small), zero, v2));
+        }
+    }
+    /// Filter one sample for each lane in the range [from, to), in place.
+    /// data is indexed by lane number. The range is extended to whole
+    /// vectors, so from should be a multiple of width and data must have room
+    /// for the lanes up to the next multiple of width after to.
+    inline void process(T *data, int from = 0, int to = Lanes)
+    {
+        for (int i = from; i < to; i += width)
+        {
+            vec x = load(data + i);
+            vec y = load(a0 + i) * x + load(s1 + i);
+            store(s1 + i, load(a1 + i) * x - load(b1 + i) * y + load(s2 + i));
+            store(s2 + i, load(a2 + i) * x - load(b2 + i) * y);
+            store(data + i, y);
+        }
+    }
+    /// Filter a block through a chain made of the first stages lanes (lane 0
+    /// first). The stages run in parallel, lane k working on the sample that
+    /// lane k - 1 produced one step earlier; the pipeline is filled and
+    /// drained within the block, so there is no added latency. Sanitizes the
+    /// state at the end. in and out may point to the same buffer.
+    template<class Sample>
+    void process_cascade(const Sample *in, Sample *out, int nsamples, int stages)
+    {
+        if (stages < 1) {
+            for (int i = 0; i < nsamples; i++)
+                out[i] = in[i];
+            return;
+        }
+        // buf[0] is the chain input, buf[k + 1] the last output of lane k
+        T buf[lanes + 1];
+        memset(buf, 0, sizeof(buf));
+        int groups = (stages + width - 1) / width;
+        vec index0;
+        for (int i = 0; i < width; i++)
+            index0[i] = i;
+        int steps = nsamples + stages - 1;
+        for (int t = 0; t < steps; t++)
+        {
+            buf[0] = t < nsamples ? in[t] : 0;
+            // lane k works on sample t - k, which may be outside the block
+            // while the pipeline is being filled or drained
+            bool partial = t < stages - 1 || t >= nsamples;
+            for (int g = groups - 1; g >= 0; g--)
+            {
+                int i = g * width;
+                vec x = load(buf + i);
+                vec old1 = load(s1 + i), old2 = load(s2 + i);
+                vec y = load(a0 + i) * x + old1;
+                vec new1 = load(a1 + i) * x - load(b1 + i) * y + old2;
+                vec new2 = load(a2 + i) * x - load(b2 + i) * y;
+                if (partial)
+                {
+                    vec index = index0 + (T)i;
+                    mask valid = (index <= (T)t) & (index > (T)(t - nsamples));
+                    new1 = select(valid, new1, old1);
+                    new2 = select(valid, new2, old2);
+                }
+                store(s1 + i, new1);
+                store(s2 + i, new2);
+                store(buf + i + 1, y);
+            }
+            if (t >= stages - 1)
+                out[t - stages + 1] = buf[stages];
+        }
+        sanitize();
+    }
+};
+
 /// Compose two filters in series
 template<class F1, class F2>
 class filter_compose {
@@ -0,0 +1,119 @@
+/* Calf DSP Library
+ * Partitioned FFT convolution
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef CALF_CONVOLVE_H
+#define CALF_CONVOLVE_H
+
+#include "fft.h"
+#include <stdint.h>
+#include <string>
+#include <vector>
+
+namespace dsp
+{
+
+/**
+ * Zero latency convolution with long impulse responses. The first
+ * BlockSize taps are applied directly, the rest of the impulse response is
+ * cut into partitions which grow with the distance from the start (up to
+ * MaxPartSize), and each group of equal partitions is applied by uniformly
+ * partitioned overlap-save convolution with a frequency domain delay line.
+ *
+ * A group with partition size N only needs its result N samples after the
+ * last input block was complete, so the spectra of the older blocks are
+ * multiplied in slices during the preceding BlockSize runs, and only one
+ * forward and one inverse transform are left for the block boundary.
+ *
+ * The constructor does all the allocation and transforms the impulse
+ * response. process() is real time safe.
+ */
+class convolver
+{
+public:
+    enum { BlockSize = 64, MaxPartOrder = 13, MaxPartSize = 1 << MaxPartOrder };
+    typedef fft<float, MaxPartOrder + 1> fft_type;
+    typedef std::complex<float> complex;
+private:
+    /// Group of partitions of equal size
+    struct stage
+    {
+        /// Partition size
+        int size;
+        /// Order of the transform (2 * size)
+        int order;
+        /// First tap of the impulse response covered by the stage
+        int offset;
+        /// Number of partitions
+        int parts;
+        /// Spectra of the partitions, size + 1 bins each
+        std::vector<complex> ir;
+        /// Spectra of the last parts input blocks
+        std::vector<complex> fdl;
+        /// Slot in fdl the next input spectrum goes to
+        int fdl_pos;
+        /// Sum of products for the next output block
+        std::vector<complex> accum;
+        /// Partitions of the next output block already added to accum
+        int parts_done;
+        /// Partitions to add per BlockSize run
+        int parts_per_block;
+    };
+    const fft_type &transform;
+    std::vector<stage> stages;
+    /// The first BlockSize taps, reversed
+    std::vector<float> head;
+    /// Input history: last BlockSize-1 samples of the previous block followed by the current block
+    std::vector<float> recent;
+    /// Last inputs, for the transforms
+    std::vector<float> input;
+    /// Contributions of the stages to the coming outputs
+    std::vector<float> output;
+    uint32_t input_mask, output_mask;
+    /// Number of samples processed so far
+    uint32_t time;
+    /// Scratch buffer for the transforms
+    std::vector<float> frame;
+
+    void add_products(stage &s, int first, int last);
+    void end_of_block();
+public:
+    convolver(const float *ir, int length);
+    /// Write nsamples of in convolved with the impulse response to out (in and out may be the same)
+    void process(const float *in, float *out, uint32_t nsamples);
+    void reset();
+    static const fft_type &get_fft();
+};
+
+/// Multichannel impulse response read from a WAV file and resampled to a given rate
+struct impulse_response
+{
+    std::vector<std::vector<float> > channels;
+    int sample_rate;
+
+    /// Read a PCM or floating point RIFF WAVE file, false (and error) on failure
+    bool load(const char *path, std::string &error);
+    /// Convert all channels to a new sample rate
+    void resample(int new_rate);
+    int get_length() const { return channels.empty() ? 0 : channels[0].size(); }
+};
+
+};
+
+#endif
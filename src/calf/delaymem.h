@@ -0,0 +1,73 @@
+/* Calf DSP Library
+ * Delay line memory
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA 02111-1307, USA.
+ */
+#ifndef CALF_DELAYMEM_H
+#define CALF_DELAYMEM_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+namespace dsp
+{
+
+/**
+ * Buffer for a long delay line, sized for the sample rate in use instead of
+ * the worst case. The memory comes from a process wide arena of anonymous
+ * mappings: blocks of 2 MB and more are huge page aligned and marked for
+ * transparent huge pages, and blocks freed by one plugin instance are
+ * handed to the next one without another trip to the kernel.
+ *
+ * By default all pages are touched on allocation, so that the audio thread
+ * never takes a page fault. With CALF_DELAY_LAZY_COMMIT=1 in the
+ * environment pages are only committed when the delay line first writes
+ * to them and clear() returns them to the system, which saves memory for
+ * delays set far below their maximum at the cost of page faults in the
+ * audio thread.
+ */
+class delay_memory
+{
+    float *data;
+    uint32_t size;
+    size_t mapped;
+
+    delay_memory(const delay_memory &);
+    void operator=(const delay_memory &);
+public:
+    delay_memory() : data(NULL), size(0), mapped(0) {}
+    ~delay_memory() { free(); }
+    /// Replace the buffer with a zeroed one of at least min_size samples, rounded up to a power of 2 if pow2 is set
+    void alloc(uint32_t min_size, bool pow2 = true);
+    /// Return the buffer to the arena
+    void free();
+    /// Zero the whole buffer (not real time safe)
+    void clear();
+    float *get() const { return data; }
+    uint32_t get_size() const { return size; }
+    /// Mask for wrapping ring buffer positions (power of 2 sizes only)
+    uint32_t get_mask() const { return size - 1; }
+    float &operator[](uint32_t pos) { return data[pos]; }
+    const float &operator[](uint32_t pos) const { return data[pos]; }
+    /// True if pages are committed on first use (CALF_DELAY_LAZY_COMMIT)
+    static bool lazy_commit();
+};
+
+};
+
+#endif
@@ -15,28 +15,164 @@
  *
  * You should have received a copy of the GNU Lesser General
  * Public License along with this program; if not, write to the
- * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor, 
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
  * Boston, MA 02111-1307, USA.
  */
 
 #ifndef __CALF_FFT_H
 #define __CALF_FFT_H
 
+#include <assert.h>
+#include <math.h>
 #include <complex>
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
 
 namespace dsp {
 
-/// FFT routine copied from my old OneSignal library, modified to 
-/// match Calf's style. It's not fast at all, just a straightforward
-/// implementation.
+/// Complex multiply without the NaN/Inf special-casing of std::complex operator*
+template<class T>
+inline std::complex<T> fft_cmul(const std::complex<T> &a, const std::complex<T> &b)
+{
+    return std::complex<T>(a.real() * b.real() - a.imag() * b.imag(), a.real() * b.imag() + a.imag() * b.real());
+}
+
+/// Multiply by i (a quarter turn in the direction of the forward transform)
+template<class T>
+inline std::complex<T> fft_rot90(const std::complex<T> &a)
+{
+    return std::complex<T>(-a.imag(), a.real());
+}
+
+/// One radix-4 decimation-in-time pass over bit-reversed data. Each group
+/// of 4*h values is made of four length-h sub-transforms that are combined
+/// into one length-4h transform. tw points to 3*h twiddle factors: W^2k,
+/// W^k and W^3k (W = exp(2*pi*i/(4h))), each stored as a contiguous run.
+template<class T>
+inline void fft_radix4_pass(std::complex<T> *data, int N, int h, const std::complex<T> *tw)
+{
+    typedef std::complex<T> complex;
+    const complex *w1 = tw, *w2 = tw + h, *w3 = tw + 2 * h;
+    for (int base = 0; base < N; base += 4 * h)
+    {
+        complex *p0 = data + base, *p1 = p0 + h, *p2 = p1 + h, *p3 = p2 + h;
+        for (int k = 0; k < h; k++)
+        {
+            complex a0 = p0[k];
+            complex c1 = fft_cmul(p1[k], w1[k]);
+            complex c2 = fft_cmul(p2[k], w2[k]);
+            complex c3 = fft_cmul(p3[k], w3[k]);
+            complex b0 = a0 + c1, b1 = a0 - c1;
+            complex d = c2 + c3, e = fft_rot90(c2 - c3);
+            p0[k] = b0 + d;
+            p1[k] = b1 + e;
+            p2[k] = b0 - d;
+            p3[k] = b1 - e;
+        }
+    }
+}
+
+#if defined(__SSE__)
+/// Complex multiply of two pairs of interleaved single precision values
+static inline __m128 fft_cmul_ps(__m128 a, __m128 w)
+{
+    __m128 wr = _mm_shuffle_ps(w, w, _MM_SHUFFLE(2, 2, 0, 0));
+    __m128 wi = _mm_shuffle_ps(w, w, _MM_SHUFFLE(3, 3, 1, 1));
+    __m128 as = _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_add_ps(_mm_mul_ps(a, wr), _mm_mul_ps(_mm_mul_ps(as, wi), _mm_set_ps(1.f, -1.f, 1.f, -1.f)));
+}
+
+/// Multiply two interleaved single precision values by i
+static inline __m128 fft_rot90_ps(__m128 a)
+{
+    return _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)), _mm_set_ps(1.f, -1.f, 1.f, -1.f));
+}
+
+/// SSE version of the radix-4 pass, two butterflies per iteration
+inline void fft_radix4_pass(std::complex<float> *data, int N, int h, const std::complex<float> *tw)
+{
+    if (h < 2)
+    {
+        fft_radix4_pass<float>(data, N, h, tw);
+        return;
+    }
+    const float *w1 = (const float *)tw, *w2 = (const float *)(tw + h), *w3 = (const float *)(tw + 2 * h);
+    for (int base = 0; base < N; base += 4 * h)
+    {
+        float *p0 = (float *)(data + base), *p1 = p0 + 2 * h, *p2 = p1 + 2 * h, *p3 = p2 + 2 * h;
+        for (int k = 0; k < 2 * h; k += 4)
+        {
+            __m128 a0 = _mm_loadu_ps(p0 + k);
+            __m128 c1 = fft_cmul_ps(_mm_loadu_ps(p1 + k), _mm_loadu_ps(w1 + k));
+            __m128 c2 = fft_cmul_ps(_mm_loadu_ps(p2 + k), _mm_loadu_ps(w2 + k));
+            __m128 c3 = fft_cmul_ps(_mm_loadu_ps(p3 + k), _mm_loadu_ps(w3 + k));
+            __m128 b0 = _mm_add_ps(a0, c1), b1 = _mm_sub_ps(a0, c1);
+            __m128 d = _mm_add_ps(c2, c3), e = fft_rot90_ps(_mm_sub_ps(c2, c3));
+            _mm_storeu_ps(p0 + k, _mm_add_ps(b0, d));
+            _mm_storeu_ps(p1 + k, _mm_add_ps(b1, e));
+            _mm_storeu_ps(p2 + k, _mm_sub_ps(b0, d));
+            _mm_storeu_ps(p3 + k, _mm_sub_ps(b1, e));
+        }
+    }
+}
+#endif
+
+/// Radix-4 FFT with precomputed plans for all orders up to O, plus a
+/// real-input (real to complex and complex to real) path that runs a half
+/// size complex transform. Twiddle factors for each pass are stored
+/// contiguously, which lets the inner loop run two butterflies per SSE
+/// instruction (or more, when the compiler is allowed to use AVX).
+///
+/// The sign convention is the one of the original OneSignal-derived code:
+/// forward transform uses exp(+2*pi*i*k*n/N), inverse uses exp(-2*pi*i*k*n/N)
+/// and is scaled by 1/N.
+///
+/// The object is not modified by any of the transforms, so a single
+/// instance can be shared between threads.
 template<class T, int O>
 class fft
 {
 public:
     typedef typename std::complex<T> complex;
 private:
+    /// Bit reversal table for order O (use scramble[i] >> (O - order) for lower orders)
     int scramble[1<<O];
-    complex sines[1<<O];
+    /// Twiddle factors for the radix-4 pass with quarter span h are stored at 3 * (h - 1)
+    complex twiddles[3 << (O - 1)];
+
+    /// Plan for radix-4 pass with quarter span h
+    inline const complex *pass_twiddles(int h) const
+    {
+        return twiddles + 3 * (h - 1);
+    }
+    /// W^k for the transform of size 4h, k < h
+    inline const complex &root(int h, int k) const
+    {
+        return twiddles[3 * (h - 1) + h + k];
+    }
+    /// Run all butterfly passes over bit-reversed data in place
+    void transform(complex *data, int order) const
+    {
+        int N = 1 << order;
+        int h = 1;
+        if (order & 1)
+        {
+            for (int i = 0; i < N; i += 2)
+            {
+                complex a = data[i], b = data[i + 1];
+                data[i] = a + b;
+                data[i + 1] = a - b;
+            }
+            h = 2;
+        }
+        for (; h < N; h <<= 2)
+            fft_radix4_pass(data, N, h, pass_twiddles(h));
+    }
+    static inline complex swap(const complex &c)
+    {
+        return complex(c.imag(), c.real());
+    }
 public:
     fft()
     {
@@ -50,63 +186,21 @@ public:
                     v+=(N>>(j+1));
             scramble[i]=v;
         }
-        int N90 = N >> 2;
-        T divN = 2 * M_PI / N;
-        // use symmetry
-        for (int i=0; i<N90; i++)
+        for (int h = 1; h <= N / 4; h <<= 1)
         {
-            T angle = divN * i;
-            T c = cos(angle), s = sin(angle);
-            sines[i + 3 * N90] = -(sines[i + N90] = complex(-s, c));
-            sines[i + 2 * N90] = -(sines[i] = complex(c, s));
+            complex *tw = twiddles + 3 * (h - 1);
+            double divN = 2 * M_PI / (4 * h);
+            for (int k = 0; k < h; k++)
+            {
+                tw[k] = complex(cos(divN * 2 * k), sin(divN * 2 * k));
+                tw[k + h] = complex(cos(divN * k), sin(divN * k));
+                tw[k + 2 * h] = complex(cos(divN * 3 * k), sin(divN * 3 * k));
+            }
         }
     }
     void calculate(complex *input, complex *output, bool inverse) const
     {
-        int N=1<<O;
-        int N1=N-1;
-        int i;
-        // Scramble the input data
-        if (inverse)
-        {
-            float mf=1.0/N;
-            for (i=0; i<N; i++)
-            {
-                complex &c=input[scramble[i]];
-                output[i]=mf*complex(c.imag(),c.real());
-            }
-        }
-        else
-            for (i=0; i<N; i++)
-                output[i]=input[scramble[i]];
-
-        // O butterfiles
-        for (i=0; i<O; i++)
-        {
-            int PO=1<<i, PNO=1<<(O-i-1);
-            int j,k;
-            for (j=0; j<PNO; j++)
-            {
-                int base=j<<(i+1);
-                for (k=0; k<PO; k++)
-                {
-                    int B1=base+k;
-                    int B2=base+k+(1<<i);
-                    complex r1=output[B1];
-                    complex r2=output[B2];
-                    output[B1]=r1+r2*sines[(B1<<(O-i-1))&N1];
-                    output[B2]=r1+r2*sines[(B2<<(O-i-1))&N1];
-                }
-            }
-        }
-        if (inverse)
-        {
-            for (i=0; i<N; i++)
-            {
-                const complex &c=output[i];
-                output[i]=complex(c.imag(),c.real());
-            }
-        }
+        calculateN(input, output, inverse, O);
     }
     template<class InType>
     void calculateN(InType *input, complex *output, bool inverse, int order) const
@@ -114,61 +208,104 @@ public:
         assert(order <= O);
         int N=1<<order;
         int rsh=O - order;
-        int N1=(N-1) << rsh;
         int i;
         // Scramble the input data
         if (inverse)
         {
-            float mf=1.0/N;
+            T mf=1.0/N;
             for (i=0; i<N; i++)
-            {
-                const complex &c=input[scramble[i] >> rsh];
-                output[i]=mf*complex(c.imag(),c.real());
-            }
+                output[i]=mf*swap(complex(input[scramble[i] >> rsh]));
         }
         else
             for (i=0; i<N; i++)
                 output[i]=input[scramble[i] >> rsh];
 
-        // O butterfiles
-        for (i=0; i<order; i++)
-        {
-            int PO=1<<i, PNO=1<<(order-i-1);
-            int j,k;
-            for (j=0; j<PNO; j++)
-            {
-                int base=j<<(i+1);
-                for (k=0; k<PO; k++)
-                {
-                    int B1=base+k;
-                    int B2=base+k+(1<<i);
-                    complex r1=output[B1];
-                    complex r2=output[B2];
-                    output[B1]=r1+r2*sines[(B1<<(O-i-1))&N1];
-                    output[B2]=r1+r2*sines[(B2<<(O-i-1))&N1];
-                }
-            }
-        }
+        transform(output, order);
+
         if (inverse)
         {
             for (i=0; i<N; i++)
-            {
-                const complex &c=output[i];
-                output[i]=complex(c.imag(),c.real());
-            }
+                output[i]=swap(output[i]);
+        }
+    }
+    /// Forward transform of 2^order real values. Writes 2^(order-1)+1 bins
+    /// (from DC to Nyquist, inclusive) to output.
+    void rfft(int order, const T *input, complex *output) const
+    {
+        assert(order >= 2 && order <= O);
+        int M = 1 << (order - 1);
+        int rsh = O - order + 1;
+        // Pack even/odd samples as one half-size complex sequence
+        for (int i = 0; i < M; i++)
+        {
+            int j = scramble[i] >> rsh;
+            output[i] = complex(input[2 * j], input[2 * j + 1]);
+        }
+        transform(output, order - 1);
+        // Split the half-size spectrum into the spectrum of a real signal
+        complex z0 = output[0];
+        output[0] = z0.real() + z0.imag();
+        output[M] = z0.real() - z0.imag();
+        for (int k = 1; k < M / 2; k++)
+        {
+            complex a = output[k], b = std::conj(output[M - k]);
+            complex e = (a + b) * T(0.5), o = fft_rot90(b - a) * T(0.5);
+            complex wo = fft_cmul(root(M / 2, k), o);
+            output[k] = e + wo;
+            output[M - k] = std::conj(e - wo);
+        }
+        // Bin M/2 is multiplied by W^(N/4) = i which leaves it unchanged
+    }
+    /// Inverse of rfft. Reads 2^(order-1)+1 bins (treated as the lower half of
+    /// a Hermitian spectrum) and writes 2^order real values, scaled by 1/N.
+    void irfft(int order, const complex *input, T *output) const
+    {
+        assert(order >= 2 && order <= O);
+        int M = 1 << (order - 1);
+        int rsh = O - order + 1;
+        // The output buffer holds exactly M complex values, the half-size
+        // spectrum is scrambled into it directly
+        complex *data = (complex *)output;
+        T mf = 1.0 / M;
+        T x0 = input[0].real(), xm = input[M].real();
+        data[0] = mf * swap(complex((x0 + xm) * T(0.5), (x0 - xm) * T(0.5)));
+        data[scramble[M / 2] >> rsh] = mf * swap(input[M / 2]);
+        for (int k = 1; k < M / 2; k++)
+        {
+            complex a = input[k], b = std::conj(input[M - k]);
+            complex e = (a + b) * T(0.5), wo = (a - b) * T(0.5);
+            complex io = fft_rot90(fft_cmul(std::conj(root(M / 2, k)), wo));
+            data[scramble[k] >> rsh] = mf * swap(e + io);
+            data[scramble[M - k] >> rsh] = mf * swap(std::conj(e - io));
         }
+        transform(data, order - 1);
+        for (int i = 0; i < M; i++)
+            data[i] = swap(data[i]);
     }
-    void execute_r2r(int order, float *input, float *output, complex *tmp, bool inverse = false) const
+    /// Real to real transform in the half-complex format: real parts of the
+    /// bins from DC up to Nyquist, followed by imaginary parts of the bins
+    /// from Nyquist-1 down to 1 (output[N - k] = Im X[k]). tmp must hold
+    /// 2^(order-1)+1 complex values.
+    void execute_r2r(int order, T *input, T *output, complex *tmp, bool inverse = false) const
     {
-        calculateN<float>(input, tmp, inverse, order);
         size_t s = 1 << order;
         size_t s2 = 1 << (order - 1);
+        if (inverse)
+        {
+            tmp[0] = input[0];
+            tmp[s2] = input[s2];
+            for (size_t i = 1; i < s2; ++i)
+                tmp[i] = complex(input[i], input[s - i]);
+            irfft(order, tmp, output);
+            return;
+        }
+        rfft(order, input, tmp);
         output[0] = tmp[0].real();
-        output[s2] = tmp[0].imag();
+        output[s2] = tmp[s2].real();
         for (size_t i = 1; i < s2; ++i)
         {
             output[i] = tmp[i].real();
-            output[s - 1 - i] = tmp[i].imag();
+            output[s - i] = tmp[i].imag();
         }
     }
 };
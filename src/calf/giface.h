@@ -35,7 +35,9 @@ namespace osctl {
 namespace calf_plugins {
 
 enum {
-    MAX_SAMPLE_RUN = 256
+    MAX_SAMPLE_RUN = 256,
+    /// Ramping automated parameters are updated every PARAM_RAMP_STEP samples
+    PARAM_RAMP_STEP = 16
 };
     
 struct automation_range;
@@ -171,6 +173,39 @@ struct progress_report_iface
     virtual ~progress_report_iface() {}
 };
 
+/// Non-realtime work done on behalf of a module (rebuilding tables, loading
+/// files etc.). The host calls work() in a worker thread, then apply() from
+/// the module's processing thread between two process() calls, then
+/// cleanup() in the worker thread again. A job is owned by the module and
+/// can be scheduled again once it is idle; its destructor must cope with
+/// the job being in any state (it may be destroyed with the host).
+struct work_job
+{
+    enum job_state { JOB_IDLE, JOB_QUEUED, JOB_APPLIED };
+    /// Current job_state, set by the host
+    int state;
+
+    work_job() : state(JOB_IDLE) {}
+    /// Worker thread: prepare the result
+    virtual void work() = 0;
+    /// Processing thread: swap the prepared result in, keeping what it replaced
+    virtual void apply() = 0;
+    /// Worker thread: free what apply() replaced
+    virtual void cleanup() {}
+    /// True when the job has gone through cleanup() and may be scheduled again
+    bool is_idle() const { return __atomic_load_n(&state, __ATOMIC_ACQUIRE) == JOB_IDLE; }
+    void set_state(job_state new_state) { __atomic_store_n(&state, (int)new_state, __ATOMIC_RELEASE); }
+    virtual ~work_job() {}
+};
+
+/// Host side of work_job scheduling (LV2 worker extension, calfjackhost worker thread)
+struct worker_iface
+{
+    /// Queue an idle job, false if there is no room. Processing thread only, never blocks.
+    virtual bool schedule_work(work_job *job) = 0;
+    virtual ~worker_iface() {}
+};
+
 /// possible bit masks for get_layers
 enum layers_flags {
     LG_NONE            = 0x000000,
@@ -329,7 +364,7 @@ struct ladspa_plugin_info
 /// An interface returning metadata about a plugin
 struct plugin_metadata_iface
 {
-    enum { simulate_stereo_input = true, has_live_updates = true };
+    enum { simulate_stereo_input = true, has_live_updates = true, has_latency = false, has_threadsafe_configure = false };
     /// @return plugin long name
     virtual const char *get_name() const = 0;
     /// @return plugin LV2 label
@@ -378,6 +413,10 @@ struct plugin_metadata_iface
     virtual bool get_simulate_stereo_input() const = 0;
     /// @return whether live UI events are generated
     virtual bool sends_live_updates() const = 0;
+    /// @return whether the plugin delays its outputs and reports by how much (audio_module_iface::get_latency)
+    virtual bool reports_latency() const = 0;
+    /// @return whether configure() may be called from another thread while the plugin is processing
+    virtual bool configure_is_threadsafe() const = 0;
 
     /// Do-nothing destructor to silence compiler warning
     virtual ~plugin_metadata_iface() {}
@@ -475,6 +514,11 @@ struct audio_module_iface
     virtual void channel_pressure(int channel, int value) = 0;
     /// Called when params are changed (before processing)
     virtual void params_changed() = 0;
+    /// Call params_changed() if any input parameter changed since the previous check
+    /// @retval true if params_changed() has been called
+    virtual bool check_params() = 0;
+    /// Make the next check_params() call params_changed() even if no parameter changed
+    virtual void invalidate_params() = 0;
     /// LADSPA-esque activate function, except it is called after ports are connected, not before
     virtual void activate() = 0;
     /// LADSPA-esque deactivate function
@@ -499,6 +543,14 @@ struct audio_module_iface
     virtual const plugin_metadata_iface *get_metadata_iface() const = 0;
     /// Set the progress report interface to communicate progress to
     virtual void set_progress_report_iface(progress_report_iface *iface) = 0;
+    /// Set the worker interface to schedule non-realtime jobs with (NULL = run them synchronously)
+    virtual void set_worker_iface(worker_iface *iface) = 0;
+    /// Change a parameter at a sample of the current cycle, ramping to it from the previous value if it's continuous.
+    /// Changes must be scheduled in time order, before the process_slice() calls of the cycle (processing thread).
+    /// @retval false if there is no room for the change and none of the parameter is queued (set the parameter directly instead)
+    virtual bool schedule_param_change(uint32_t time, int param_no, float value) = 0;
+    /// @return delay of the outputs against the inputs in samples, with the current parameters (processing thread)
+    virtual uint32_t get_latency() = 0;
     /// Clear a part of output buffers that have 0s at mask; subdivide the buffer so that no runs > MAX_SAMPLE_RUN are fed to process function
     virtual uint32_t process_slice(uint32_t offset, uint32_t end) = 0;
     /// The audio processing loop; assumes numsamples <= MAX_SAMPLE_RUN, for larger buffers, call process_slice
@@ -512,6 +564,115 @@ struct audio_module_iface
     virtual ~audio_module_iface() {}
 };
 
+/// Parameter changes at given samples of the current cycle. Each parameter
+/// moves through the values of its changes, starting from its value at the
+/// start of the cycle; continuous parameters ramp linearly from one value to
+/// the next, the others step.
+template<int ParamCount>
+class param_event_queue
+{
+public:
+    enum { max_events = 128 };
+private:
+    struct param_event
+    {
+        /// Sample the value is reached at
+        uint32_t time;
+        float value;
+        /// Sample and value the change starts from (the previous change, or the start of the cycle)
+        uint32_t from;
+        float from_value;
+        /// Change per sample on the way to the value, 0 for a step
+        float slope;
+        /// Next event of the same parameter, -1 if none
+        int next;
+    };
+    param_event events[max_events];
+    int count;
+    /// For each parameter, the event it moves towards and the last event queued, -1 if none
+    int target[ParamCount], last[ParamCount];
+    /// Parameters that still have events to reach
+    int active[ParamCount];
+    int active_count;
+public:
+    param_event_queue()
+    : count(0)
+    , active_count(0)
+    {
+        for (int i = 0; i < ParamCount; i++)
+            target[i] = last[i] = -1;
+    }
+    bool empty() const { return !active_count; }
+    /// Add a change, false if the queue is full and the parameter has no changes queued
+    bool push(uint32_t time, int param_no, float current_value, float value, bool ramp)
+    {
+        int prev = last[param_no];
+        if (count == max_events)
+        {
+            if (prev == -1)
+                return false;
+            // no room: the last change of the parameter goes to the new value
+            // instead, so that the newest value still wins
+            param_event &e = events[prev];
+            e.time = time;
+            e.value = value;
+            e.slope = ramp && time > e.from ? (value - e.from_value) / (time - e.from) : 0.f;
+            return true;
+        }
+        param_event &e = events[count];
+        e.from = prev != -1 ? events[prev].time : 0;
+        e.from_value = prev != -1 ? events[prev].value : current_value;
+        e.time = time;
+        e.value = value;
+        e.slope = ramp && time > e.from ? (value - e.from_value) / (time - e.from) : 0.f;
+        e.next = -1;
+        if (prev != -1)
+            events[prev].next = count;
+        else {
+            target[param_no] = count;
+            active[active_count++] = param_no;
+        }
+        last[param_no] = count++;
+        return true;
+    }
+    /// Write the values the parameters have at sample pos
+    void apply(uint32_t pos, float **params)
+    {
+        for (int i = 0; i < active_count; )
+        {
+            int param_no = active[i];
+            int e = target[param_no];
+            while (e != -1 && events[e].time <= pos) {
+                *params[param_no] = events[e].value;
+                e = events[e].next;
+            }
+            target[param_no] = e;
+            if (e != -1) {
+                if (events[e].slope != 0.f)
+                    *params[param_no] = events[e].value - events[e].slope * (events[e].time - pos);
+                i++;
+                continue;
+            }
+            last[param_no] = -1;
+            active[i] = active[--active_count];
+        }
+        if (!active_count)
+            count = 0;
+    }
+    /// The sample after pos the parameters have to be written again at: the next
+    /// change, or pos + step while a parameter is ramping
+    uint32_t next_update(uint32_t pos, uint32_t step) const
+    {
+        uint32_t next = 0xFFFFFFFF;
+        for (int i = 0; i < active_count; i++)
+        {
+            const param_event &e = events[target[active[i]]];
+            next = std::min(next, e.slope != 0.f ? pos + step : e.time);
+        }
+        return next;
+    }
+};
+
 /// Empty implementations for plugin functions.
 template<class Metadata>
 class audio_module: public Metadata, public audio_module_iface
@@ -526,16 +687,29 @@ public:
     float *params[Metadata::param_count];
     bool questionable_data_reported_in;
     bool questionable_data_reported_out;
+    /// Input parameter values seen by the last params_changed() called from check_params()
+    float params_snapshot[Metadata::param_count];
+    /// Bit mask of parameters changed since the previous check_params(), all bits are set outside of it
+    uint32_t params_dirty[(Metadata::param_count + 31) / 32];
+    /// Set when the next check_params() must call params_changed() unconditionally
+    bool params_invalid;
 
     progress_report_iface *progress_report;
+    worker_iface *worker;
+    /// Automation of the current cycle, applied by process_slice()
+    param_event_queue<Metadata::param_count> param_events;
 
     audio_module() {
         progress_report = NULL;
+        worker = NULL;
         memset(ins, 0, sizeof(ins));
         memset(outs, 0, sizeof(outs));
         memset(params, 0, sizeof(params));
+        memset(params_snapshot, 0, sizeof(params_snapshot));
+        memset(params_dirty, 0xFF, sizeof(params_dirty));
         questionable_data_reported_in = false;
         questionable_data_reported_out = false;
+        params_invalid = true;
     }
 
     /// Handle MIDI Note On
@@ -554,6 +728,40 @@ public:
     void channel_pressure(int channel, int value) {}
     /// Called when params are changed (before processing)
     void params_changed() {}
+    /// Compare input parameters against the snapshot and call params_changed() if any of them differ.
+    /// Within that call, param_changed() tells which ones did.
+    bool check_params()
+    {
+        bool dirty = params_invalid;
+        memset(params_dirty, 0, sizeof(params_dirty));
+        for (int i = 0; i < Metadata::param_count; i++) {
+            if (!params[i] || (Metadata::param_props[i].flags & PF_PROP_OUTPUT))
+                continue;
+            if (params_invalid || *params[i] != params_snapshot[i]) {
+                params_dirty[i >> 5] |= 1u << (i & 31);
+                dirty = true;
+            }
+        }
+        if (dirty) {
+            if (params_invalid)
+                memset(params_dirty, 0xFF, sizeof(params_dirty));
+            params_changed();
+            // take the snapshot afterwards, so that the values written by
+            // the module itself don't count as changes next time
+            for (int i = 0; i < Metadata::param_count; i++) {
+                if (params[i])
+                    params_snapshot[i] = *params[i];
+            }
+            params_invalid = false;
+        }
+        // direct params_changed() calls (activate, gliding etc.) see everything as changed
+        memset(params_dirty, 0xFF, sizeof(params_dirty));
+        return dirty;
+    }
+    /// Make the next check_params() call params_changed() unconditionally
+    void invalidate_params() { params_invalid = true; }
+    /// Check whether a parameter changed since the previous params_changed() (always true if not called from check_params())
+    inline bool param_changed(int param_no) const { return (params_dirty[param_no >> 5] & (1u << (param_no & 31))) != 0; }
     /// LADSPA-esque activate function, except it is called after ports are connected, not before
     void activate() {}
     /// LADSPA-esque deactivate function
@@ -589,6 +797,33 @@ public:
     virtual const plugin_metadata_iface *get_metadata_iface() const { return this; }
     /// Set the progress report interface to communicate progress to
     virtual void set_progress_report_iface(progress_report_iface *iface) { progress_report = iface; }
+    /// Set the worker interface to schedule non-realtime jobs with
+    virtual void set_worker_iface(worker_iface *iface) { worker = iface; }
+    /// No latency by default
+    virtual uint32_t get_latency() { return 0; }
+    /// Queue a parameter change for process_slice()
+    virtual bool schedule_param_change(uint32_t time, int param_no, float value)
+    {
+        if (!params[param_no])
+            return false;
+        bool ramp = (Metadata::param_props[param_no].flags & PF_TYPEMASK) == PF_FLOAT;
+        return param_events.push(time, param_no, *params[param_no], value, ramp);
+    }
+    /// Have the host run a job outside the processing thread; without a worker, run it right away.
+    /// Call from the processing thread only.
+    /// @retval false if the job is still busy with an earlier request or the host's queue is full (try again later)
+    bool schedule_work(work_job *job)
+    {
+        if (!job->is_idle())
+            return false;
+        if (!worker) {
+            job->work();
+            job->apply();
+            job->cleanup();
+            return true;
+        }
+        return worker->schedule_work(job);
+    }
 
     /// utility function: zero port values if mask is 0
     inline void zero_by_mask(uint32_t mask, uint32_t offset, uint32_t nsamples)
@@ -599,56 +834,53 @@ public:
             }
         }
     }
-    /// utility function: call process, and if it returned zeros in output masks, zero out the relevant output port buffers
+    /// utility function: check a buffer for NaNs, infinities and huge values, report the first one found
+    /// (once per plugin instance, or every time in debug builds)
+    /// @return true if the buffer contains questionable data
+    bool check_questionable(const float *data, uint32_t offset, uint32_t end, bool &reported, const char *fmt, int port)
+    {
+        uint32_t pos = dsp::find_questionable(data + offset, end - offset);
+        if (pos == end - offset)
+            return false;
+#if ENABLE_DEBUG
+        reported = false;
+#endif
+        if (!reported) {
+            fprintf(stderr, fmt, Metadata::get_name(), data[offset + pos], port, offset + pos);
+            reported = true;
+        }
+        return true;
+    }
+    /// utility function: call process, and if it returned zeros in output masks, zero out the relevant output port buffers;
+    /// scheduled parameter changes split the slice at their samples, ramps update the parameters every PARAM_RAMP_STEP samples
     uint32_t process_slice(uint32_t offset, uint32_t end)
     {
         bool had_errors = false;
         for (int i=0; i<Metadata::in_count; ++i) {
-            float *indata = ins[i];
-            if (indata) {
-                float errval = 0;
-                for (uint32_t j = offset; j < end; j++)
-                {
-                    if (!std::isfinite(indata[j]) || fabs(indata[j]) > 4294967296.0) {
-                        errval = indata[j];
-                        had_errors = true;
-                    }
-                }
-                if (had_errors && !questionable_data_reported_in) {
-                    fprintf(stderr, "Warning: Plugin %s got questionable value %f on its input %d\n", Metadata::get_name(), errval, i);
-                    questionable_data_reported_in = true;
-                }
-            }
+            if (ins[i] && check_questionable(ins[i], offset, end, questionable_data_reported_in, "Warning: Plugin %s got questionable value %f on its input %d (sample %u)\n", i))
+                had_errors = true;
         }
         uint32_t total_out_mask = 0;
-        while(offset < end)
+        for (uint32_t pos = offset; pos < end; )
         {
-            uint32_t newend = std::min(offset + MAX_SAMPLE_RUN, end);
-            uint32_t out_mask = !had_errors ? process(offset, newend - offset, -1, -1) : 0;
+            uint32_t newend = std::min(pos + MAX_SAMPLE_RUN, end);
+            if (!param_events.empty()) {
+                param_events.apply(pos, params);
+                check_params();
+                if (!param_events.empty())
+                    newend = std::min(newend, param_events.next_update(pos, PARAM_RAMP_STEP));
+            }
+            uint32_t out_mask = !had_errors ? process(pos, newend - pos, -1, -1) : 0;
             total_out_mask |= out_mask;
-            zero_by_mask(out_mask, offset, newend - offset);
-            offset = newend;
+            zero_by_mask(out_mask, pos, newend - pos);
+            pos = newend;
         }
+        // the next slice starts where this one ended
+        if (!param_events.empty())
+            param_events.apply(end, params);
         for (int i=0; i<Metadata::out_count; ++i) {
-            if (total_out_mask & (1 << i))
-            {
-                had_errors = false;
-                float *outdata = outs[i];
-                float errval = 0;
-                for (uint32_t j = offset; j < end; j++)
-                {
-                    if (!std::isfinite(outdata[j]) || fabs(outdata[j]) > 4294967296.0) {
-                        errval = outdata[j];
-                        had_errors = true;
-                    }
-                }
-                if (had_errors && !questionable_data_reported_out) {
-                    fprintf(stderr, "Warning: Plugin %s generated questionable value %f on its output %d - this is most likely a bug in the plugin!\n", Metadata::get_name(), errval, i);
-                    questionable_data_reported_out = true;
-                }
-                if (had_errors)
-                    dsp::zero(outs[i] + offset, end - offset);
-            }
+            if ((total_out_mask & (1 << i)) && check_questionable(outs[i], offset, end, questionable_data_reported_out, "Warning: Plugin %s generated questionable value %f on its output %d (sample %u) - this is most likely a bug in the plugin!\n", i))
+                dsp::zero(outs[i] + offset, end - offset);
         }
         return total_out_mask;
     }
@@ -733,6 +965,8 @@ public:
     const ladspa_plugin_info &get_plugin_info() const { return plugin_info; }
     bool get_simulate_stereo_input() const { return Metadata::simulate_stereo_input; }
     bool sends_live_updates() const { return Metadata::has_live_updates; }
+    bool reports_latency() const { return Metadata::has_latency; }
+    bool configure_is_threadsafe() const { return Metadata::has_threadsafe_configure; }
 };
 
 #define CALF_PORT_NAMES(name) template<> const char *::plugin_metadata<name##_metadata>::port_names[]
@@ -863,7 +1097,7 @@ struct automation_range
     , max_value(u)
     , param_no(param)
     {}
-    void send_configure(const plugin_metadata_iface *metadata, uint32_t from_controller, send_configure_iface *sci);
+    void send_configure(const plugin_metadata_iface *metadata, uint32_t from_controller, send_configure_iface *sci) const;
     static automation_range *new_from_configure(const plugin_metadata_iface *metadata, const char *key, const char *value, uint32_t &from_controller);
 };
 
@@ -0,0 +1,133 @@
+/* Calf DSP Library Utility Application - calfjackhost
+ * Parallel scheduler for the plugin graph
+ *
+ * Copyright (C) 2007-2011 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+#ifndef __CALF_GRAPH_SCHEDULER_H
+#define __CALF_GRAPH_SCHEDULER_H
+
+#include <config.h>
+
+#if USE_JACK
+
+#include <stdint.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <map>
+#include <vector>
+#include <jack/jack.h>
+
+namespace calf_plugins {
+
+class jack_host;
+
+/// Bounded work-stealing deque of node indices (Chase-Lev). The owning
+/// thread pushes and pops at the bottom, other threads steal from the top.
+/// Indices grow monotonically, so the deque never needs to be reset.
+class work_stealing_queue
+{
+    int64_t top, bottom, mask;
+    std::vector<int> items;
+public:
+    work_stealing_queue() : top(0), bottom(0), mask(0) {}
+    /// Allocate room for at least capacity items (not realtime safe)
+    void init(int capacity);
+    /// Add an item (owner thread only)
+    void push(int item);
+    /// Take the most recently pushed item (owner thread only)
+    bool pop(int &item);
+    /// Take the oldest item (any thread)
+    bool steal(int &item);
+};
+
+/// Dependency graph of the plugins in a rack, prepared on a non-realtime
+/// thread and then swapped into the scheduler as a whole
+struct schedule_graph
+{
+    struct node
+    {
+        jack_host *plugin;
+        /// Number of nodes that must finish before this one can start
+        int dependency_count;
+        /// Dependencies still not processed in the current cycle
+        int pending;
+        /// Nodes that consume output of this one
+        std::vector<int> successors;
+    };
+    std::vector<node> nodes;
+    /// Nodes without dependencies
+    std::vector<int> roots;
+    /// One queue per thread, including the JACK process thread
+    std::vector<work_stealing_queue> queues;
+};
+
+/// Runs independent plugins of a rack in parallel on a pool of realtime
+/// threads. The JACK process thread takes part in the work as thread 0, so
+/// the cycle always completes even if the workers are not woken in time.
+class graph_scheduler
+{
+public:
+    typedef void (*process_func)(void *arg, jack_host *plugin);
+private:
+    struct worker
+    {
+        graph_scheduler *owner;
+        int index;
+        pthread_t thread;
+        sem_t wakeup;
+    };
+    std::vector<worker *> workers;
+    schedule_graph *graph;
+    process_func cycle_func;
+    void *cycle_arg;
+    /// Nodes not finished yet in the current cycle
+    int remaining;
+    /// Set while the JACK thread is inside run()
+    int running;
+    /// Number of worker threads currently looking at the graph
+    int active;
+    volatile bool quit;
+
+    static void *worker_thread(void *arg);
+    void work(int thread);
+public:
+    graph_scheduler();
+    ~graph_scheduler();
+    /// Start thread_count - 1 worker threads (0 = one thread per CPU)
+    void start(jack_client_t *client, int thread_count);
+    /// Stop and join the worker threads
+    void stop();
+    /// Number of threads taking part in processing, including the JACK thread
+    int get_thread_count() const { return workers.size() + 1; }
+    /// True if there are worker threads to distribute the work to
+    bool is_parallel() const { return !workers.empty(); }
+    /// Build a graph from the plugin list and a (consumer, producer) dependency map
+    schedule_graph *create_graph(const std::vector<jack_host *> &plugins, const std::multimap<int, int> &run_before) const;
+    /// Replace the current graph, returning the old one. Must not be called
+    /// concurrently with run().
+    schedule_graph *swap_graph(schedule_graph *new_graph);
+    /// Call func for every plugin in the graph, honouring dependencies.
+    /// Called from the JACK process callback.
+    void run(process_func func, void *arg);
+};
+
+};
+
+#endif
+
+#endif
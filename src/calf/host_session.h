@@ -25,6 +25,7 @@
 
 #include "gui.h"
 #include "jackhost.h"
+#include "preset.h"
 #include "session_mgr.h"
 
 namespace calf_plugins {
@@ -70,6 +71,8 @@ public:
     std::string jack_session_id;
     /// Command used to start the JACK host
     std::string calfjackhost_cmd;
+    /// Number of threads used for processing the plugins (1 = JACK thread only, 0 = one per CPU)
+    int thread_count;
     
     // these are not saved
     jack_client client;
@@ -90,6 +93,10 @@ public:
     void close();
     bool activate_preset(int plugin, const std::string &preset, bool builtin);
     void remove_all_plugins();
+    /// Link the inputs of a plugin to the outputs of other plugins of the rack
+    void apply_links(int plugin_no, const std::vector<preset_list::input_link> &links);
+    /// Find the links feeding the inputs of a plugin
+    void get_links(int plugin_no, std::vector<preset_list::input_link> &links);
     std::string get_next_instance_name(const std::string &effect_name);
     std::string get_full_plugin_name(const std::string &effect_name);
     
@@ -27,7 +27,9 @@
 
 #include "utils.h"
 #include "vumeter.h"
+#include "graph_scheduler.h"
 #include <pthread.h>
+#include <semaphore.h>
 #include <jack/jack.h>
 #include <jack/session.h>
 
@@ -43,23 +45,136 @@ class jack_host;
     
 struct automation_iface
 {
-    virtual uint32_t apply_and_adjust(uint32_t start, uint32_t time) = 0;
+    /// Pass the automation events of the cycle to the plugin
+    virtual void schedule_events() = 0;
     virtual ~automation_iface() {}
 };
 
+/// Automation routes of a plugin, indexed directly by designator (MIDI channel << 8 | controller).
+/// Built on the GUI thread, read-only afterwards.
+struct automation_table
+{
+    enum { designator_count = 16 << 8 };
+    /// The mappings the table was built from
+    automation_map mappings;
+    /// Routes grouped by designator, the ones of designator d are routes[first[d]] to routes[first[d + 1] - 1]
+    std::vector<automation_range> routes;
+    uint32_t first[designator_count + 1];
+
+    automation_table(const automation_map &_mappings);
+};
+
+class job_thread;
+
+/// Jobs of one plugin on their way between its processing thread and the
+/// host's worker thread. Each direction is a single producer, single
+/// consumer ring, so the processing thread never blocks on the worker.
+class job_queue: public worker_iface
+{
+    enum { ring_size = 32 };
+    struct ring
+    {
+        work_job *items[ring_size];
+        /// Written by the producer only
+        uint32_t head;
+        /// Written by the consumer only
+        uint32_t tail;
+        ring() : head(0), tail(0) {}
+        bool is_full() const;
+        bool push(work_job *job);
+        bool pop(work_job *&job);
+    };
+    /// Jobs to work on or to clean up, in the order they were queued
+    ring to_worker;
+    /// Jobs to apply
+    ring from_worker;
+    job_thread *owner;
+public:
+    job_queue(job_thread *_owner) : owner(_owner) {}
+    /// Detach from the worker thread and clean up the jobs left in the queue
+    ~job_queue();
+    /// Queue an idle job (processing thread)
+    virtual bool schedule_work(work_job *job);
+    /// Apply the jobs the worker has finished and send them back for cleanup (processing thread)
+    void apply_finished();
+    /// Work on or clean up the queued jobs (worker thread)
+    void run_queued();
+};
+
+/// Background thread running non-realtime jobs for all plugins of a rack
+class job_thread
+{
+    pthread_t thread;
+    sem_t wakeup;
+    calf_utils::ptmutex mutex;
+    std::vector<job_queue *> queues;
+    bool running;
+    volatile bool quit;
+
+    static void *thread_func(void *arg);
+public:
+    job_thread();
+    ~job_thread();
+    void start();
+    void stop();
+    /// Create a queue served by this thread
+    job_queue *create_queue();
+    /// Stop serving a queue (waits for the job being worked on to finish)
+    void remove_queue(job_queue *queue);
+    /// Wake the thread up (any thread, does not block)
+    void notify() { sem_post(&wakeup); }
+};
+
+/// Delay line compensating the latency difference between parallel branches
+class compensation_delay
+{
+    std::vector<float> buffer;
+    uint32_t pos;
+public:
+    compensation_delay() : pos(0) {}
+    uint32_t get_delay() const { return buffer.size(); }
+    /// Change the delay and clear the line (not realtime safe)
+    void set_delay(uint32_t samples) { buffer.assign(samples, 0.f); pos = 0; }
+    /// Delay len samples in place
+    void process(float *data, uint32_t len);
+    void swap(compensation_delay &other) { buffer.swap(other.buffer); std::swap(pos, other.pos); }
+};
+
 class jack_client {
+    /// The plugins change their port handles under the lock
+    friend class jack_host;
 protected:
     std::vector<jack_host *> plugins;
     calf_utils::ptmutex mutex;
 
     /// Common port for MIDI parameter automation
     jack_port_t *automation_port;
+    /// Worker pool for processing independent plugins in parallel
+    graph_scheduler scheduler;
+    /// Set by JACK when connections change, checked in check_schedule
+    volatile bool schedule_dirty;
+    /// Buffer size of the cycle being processed by the scheduler
+    jack_nframes_t cycle_nframes;
+    /// Worker thread for the plugins' non-realtime jobs
+    job_thread jobs;
+    /// Set when connections change or JACK could not be told the port latencies, checked in check_latency
+    volatile bool latency_dirty;
+
+    /// Rebuild the scheduler's dependency graph (GUI thread only)
+    void update_schedule();
+    /// Recalculate the compensation delays and let JACK recompute the port latencies (GUI thread only)
+    void update_latency();
+    static void process_plugin(void *p, jack_host *plugin);
+    static int do_jack_graph_order(void *p);
+    static void do_jack_latency(jack_latency_callback_mode_t mode, void *p);
 
 public:
     jack_client_t *client;
     int input_nr, output_nr, midi_nr;
     std::string name, input_name, output_name, midi_name;
     int sample_rate;
+    /// Current JACK buffer size, the size of the buffers of the linked outputs
+    jack_nframes_t buffer_size;
 
     jack_client();
     void add(jack_host *plugin);
@@ -75,26 +190,47 @@ public:
     void close();
     void apply_plugin_order(const std::vector<int> &indices);
     void calculate_plugin_order(std::vector<int> &indices);
+    /// Find which plugins feed which, as (consumer, producer) pairs
+    void calculate_plugin_dependencies(std::multimap<int, int> &run_before);
+    /// Start a pool of thread_count processing threads (0 = one per CPU, 1 = serial)
+    void start_scheduler(int thread_count);
+    /// Create a job queue for a plugin, served by the client's worker thread
+    job_queue *create_job_queue() { return jobs.create_queue(); }
+    /// Rebuild the dependency graph if the connections have changed (GUI thread only)
+    void check_schedule();
+    /// Update the compensation delays if connections or plugin latencies have changed (GUI thread only)
+    void check_latency();
+    /// Feed an input of a plugin directly from an output of another plugin in the rack, bypassing JACK.
+    /// Both ports stop being JACK ports, so ports connected in JACK are refused (GUI thread only)
+    void link(jack_host *from, int output, jack_host *to, int input);
+    /// Feed a linked input from its JACK port again (GUI thread only)
+    void unlink(jack_host *to, int input);
+    /// Remove all links from and to a plugin (GUI thread only)
+    void unlink_all(jack_host *plugin);
     const char **get_ports(const char *name_re, const char *type_re, unsigned long flags);
     
     static int do_jack_process(jack_nframes_t nframes, void *p);
     static int do_jack_bufsize(jack_nframes_t numsamples, void *p);
-    template<class T>
-    void atomic_swap(T &v1, T &v2)
-    {
-        calf_utils::ptlock lock(mutex);
-        std::swap(v1, v2);
-    }
 };
 
 class jack_host: public plugin_ctl_iface {
 public:
     struct port {
+        /// JACK port, NULL if the port is linked inside the rack
         jack_port_t *handle;
         float *data;
         std::string name, nice_name;
         dsp::vumeter meter;
-        port() : handle(NULL), data(NULL) {}
+        /// Aligns the signal with the other branches feeding the same ports (outputs) or plugin (inputs)
+        compensation_delay delay;
+        jack_host *owner;
+        /// Output feeding this input directly, NULL if the input is a JACK port
+        port *source;
+        /// Inputs fed directly by this output
+        std::vector<port *> sinks;
+        /// Buffer of a linked output (JACK doesn't provide one) or a delayed copy of an input
+        std::vector<float> buffer;
+        port() : handle(NULL), data(NULL), owner(NULL), source(NULL) {}
         ~port() { }
     };
 public:
@@ -103,10 +239,23 @@ public:
     float *param_values;
     float midi_meter;
     audio_module_iface *module;
-    automation_map *cc_mappings;
+    /// Non-realtime jobs scheduled by the module
+    job_queue *jobs;
+    /// Current automation routes, replaced by the GUI thread, read by the processing thread
+    automation_table *cc_table;
+    /// The table the processing thread saw at the end of its last cycle, the ones replaced before are not used any more
+    automation_table *cc_table_seen;
+    /// Replaced tables, oldest first, waiting until the processing thread is done with them (GUI thread)
+    std::vector<automation_table *> retired_tables;
     std::vector<int> write_serials;
     int last_modify_serial;
     uint32_t last_designator;
+    /// Smoothed time spent in process(), in microseconds
+    float process_time;
+    /// Latency reported by the module in the last cycle (written by the processing thread)
+    volatile uint32_t latency;
+    /// Latency the compensation delays were calculated for (GUI thread)
+    uint32_t compensated_latency;
     
 public:
     typedef int (*process_func)(jack_nframes_t nframes, void *p);
@@ -123,6 +272,10 @@ public:
     void create();
     void create_ports();
     void rename_ports();
+    /// Register a port with JACK under its current names, if not registered yet
+    void register_port(port &p, const char *type, unsigned long flags);
+    /// Unregister a port from JACK, if registered
+    void unregister_port(port &p);
     void init_module();
     void destroy();
     ~jack_host();
@@ -136,13 +289,16 @@ public:
     virtual float get_level(unsigned int port);
     /// Process audio/MIDI buffers
     int process(jack_nframes_t nframes, automation_iface &automation);
-    /// Retrieve and cache output port buffers
+    /// Retrieve and cache output port buffers (linked outputs use their own)
     void cache_ports();
     /// Retrieve the full list of input ports, audio+MIDI (the pointers are temporary, may point to nowhere after any changes etc.)
     void get_all_input_ports(std::vector<port *> &ports);
     /// Retrieve the full list of output ports (the pointers are temporary, may point to nowhere after any changes etc.)
     void get_all_output_ports(std::vector<port *> &ports);
-    void handle_automation_cc(uint32_t designator, int value);
+    /// Schedule the parameter changes mapped to an automation CC at a sample of the cycle
+    void handle_automation_cc(uint32_t designator, int value, uint32_t time);
+    /// Average time spent processing a single JACK cycle, in microseconds
+    float get_process_time() const { return process_time; }
     
 public:
     // Port access
@@ -176,7 +332,10 @@ public:
     virtual void delete_automation(uint32_t source, int param_no);
     virtual void get_automation(int param_no, std::multimap<uint32_t, automation_range> &dests);
     virtual uint32_t get_last_automation_source();
-    void replace_automation_map(automation_map *amap);
+    /// Publish a new set of automation routes (GUI thread)
+    void replace_automation_map(const automation_map &amap);
+    /// Free the replaced tables the processing thread can't be using any more (GUI thread)
+    void free_retired_tables();
 };
 
 extern jack_host *create_jack_host(jack_client *_client, const char *name, const std::string &instance_name, calf_plugins::progress_report_iface *priface);
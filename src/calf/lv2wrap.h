@@ -34,11 +34,12 @@
 #include <calf/lv2_options.h>
 #include <calf/lv2_progress.h>
 #include <calf/lv2_urid.h>
+#include <calf/lv2_worker.h>
 #include <string.h>
 
 namespace calf_plugins {
 
-struct lv2_instance: public plugin_ctl_iface, public progress_report_iface
+struct lv2_instance: public plugin_ctl_iface, public progress_report_iface, public worker_iface
 {
     const plugin_metadata_iface *metadata;
     audio_module_iface *module;
@@ -46,10 +47,28 @@ struct lv2_instance: public plugin_ctl_iface, public progress_report_iface
     int srate_to_set;
     LV2_Atom_Sequence *event_in_data, *event_out_data;
     uint32_t event_out_capacity;
+    /// lv2:reportsLatency output port (only plugins with reports_latency() have one)
+    float *latency_port;
     LV2_URID_Map *urid_map;
     uint32_t midi_event_type, property_type, string_type, sequence_type;
     LV2_Progress *progress_report_feature;
     LV2_Options_Interface *options_feature;
+    LV2_Worker_Schedule *worker_schedule;
+    /// Message passed through the host's worker, CONFIGURE is followed by the value string
+    struct work_message
+    {
+        enum { JOB, CONFIGURE } type;
+        work_job *job;
+        int var;
+    };
+    enum { max_applied_jobs = 16 };
+    /// Jobs applied in work_response(), to be sent back to the worker for cleanup by the next run()
+    work_job *applied_jobs[max_applied_jobs];
+    int applied_count;
+    /// configure() calls still waiting for or running in the worker (decremented by the worker if it can't respond)
+    int configures_pending;
+    /// A request for the configure variables arrived while configures_pending was non-zero
+    bool send_configures_pending;
     float **ins, **outs, **params;
     int in_count;
     int out_count;
@@ -109,6 +128,13 @@ struct lv2_instance: public plugin_ctl_iface, public progress_report_iface
     void process_event_property(const LV2_Atom_Property *prop);
     void process_events(uint32_t &offset);
     void run(uint32_t SampleCount, bool has_simulate_stereo_input_flag);
+    /// Reply to the GUI's request for the configure variables
+    void output_configures();
+    /// Queue a configure call for the worker, false if there is no worker, no room or the module needs configure() in run()
+    bool schedule_configure(int var, const char *value);
+    virtual bool schedule_work(work_job *job);
+    LV2_Worker_Status work(LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle handle, uint32_t size, const void *data);
+    LV2_Worker_Status work_response(uint32_t size, const void *data);
     virtual float get_param_value(int param_no)
     {
         // XXXKF hack
@@ -151,6 +177,7 @@ struct lv2_wrapper
     static LV2_Descriptor descriptor;
     static LV2_Calf_Descriptor calf_descriptor;
     static LV2_State_Interface state_iface;
+    static LV2_Worker_Interface work_iface;
     std::string uri;
     
     lv2_wrapper()
@@ -167,6 +194,9 @@ struct lv2_wrapper
         descriptor.extension_data = cb_ext_data;
         state_iface.save = cb_state_save;
         state_iface.restore = cb_state_restore;
+        work_iface.work = cb_work;
+        work_iface.work_response = cb_work_response;
+        work_iface.end_run = NULL;
         calf_descriptor.get_pci = cb_get_pci;
     }
 
@@ -194,6 +224,9 @@ struct lv2_wrapper
         else if (has_event_out && port == ins + outs + params + (has_event_in ? 1 : 0)) {
             mod->event_out_data = (LV2_Atom_Sequence *)DataLocation;
         }
+        else if (md->reports_latency() && port == ins + outs + params + (has_event_in ? 1 : 0) + (has_event_out ? 1 : 0)) {
+            mod->latency_port = (float *)DataLocation;
+        }
     }
 
     static void cb_activate(LV2_Handle Instance)
@@ -236,6 +269,8 @@ struct lv2_wrapper
             return &calf_descriptor;
         if (!strcmp(URI, LV2_STATE__interface))
             return &state_iface;
+        if (!strcmp(URI, LV2_WORKER__interface))
+            return &work_iface;
         return NULL;
     }
     static LV2_State_Status cb_state_save(
@@ -253,6 +288,18 @@ struct lv2_wrapper
         inst->impl_restore(retrieve, callback_data);
         return LV2_STATE_SUCCESS;
     }
+    static LV2_Worker_Status cb_work(
+        LV2_Handle Instance, LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle handle,
+        uint32_t size, const void *data)
+    {
+        instance *const inst = (instance *)Instance;
+        return inst->work(respond, handle, size, data);
+    }
+    static LV2_Worker_Status cb_work_response(LV2_Handle Instance, uint32_t size, const void *data)
+    {
+        instance *const inst = (instance *)Instance;
+        return inst->work_response(size, data);
+    }
     
     static lv2_wrapper &get() { 
         static lv2_wrapper *instance = new lv2_wrapper;
@@ -102,6 +102,17 @@ struct reverb_metadata: public plugin_metadata<reverb_metadata>
     PLUGIN_NAME_ID_LABEL("reverb", "reverb", "Reverb")
 };
 
+struct conv_reverb_metadata: public plugin_metadata<conv_reverb_metadata>
+{
+    enum { param_bypass, param_level_in, param_level_out,
+        STEREO_VU_METER_PARAMS,
+        par_dry, par_wet, par_ir_length,
+        param_count };
+    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, rt_capable = true, support_midi = false, require_midi = false, require_instance_access = false, has_threadsafe_configure = true };
+    PLUGIN_NAME_ID_LABEL("convreverb", "convreverb", "Convolution Reverb")
+    void get_configure_vars(std::vector<std::string> &names) const;
+};
+
 struct vintage_delay_metadata: public plugin_metadata<vintage_delay_metadata>
 {
     enum {  param_on, param_level_in, param_level_out,
@@ -347,7 +358,7 @@ struct multibandgate_metadata: public plugin_metadata<multibandgate_metadata>
 /// Markus's limiter - metadata
 struct limiter_metadata: public plugin_metadata<limiter_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS,
            param_limit, param_attack, param_release,
@@ -361,7 +372,7 @@ struct limiter_metadata: public plugin_metadata<limiter_metadata>
 /// Markus's and Chrischis multibandlimiter - metadata
 struct multibandlimiter_metadata: public plugin_metadata<multibandlimiter_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS,
            param_freq0, param_freq1, param_freq2,
@@ -381,7 +392,7 @@ struct multibandlimiter_metadata: public plugin_metadata<multibandlimiter_metada
 /// Markus's and Chrischis sidechainlimiter - metadata
 struct sidechainlimiter_metadata: public plugin_metadata<sidechainlimiter_metadata>
 {
-    enum { in_count = 4, out_count = 2, ins_optional = 2, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 4, out_count = 2, ins_optional = 2, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS,
            param_meter_scL, param_meter_scR,
@@ -676,7 +687,7 @@ struct ringmodulator_metadata: public plugin_metadata<ringmodulator_metadata>
 /// Markus's Saturator - metadata
 struct saturator_metadata: public plugin_metadata<saturator_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS,
            param_mix, param_drive, param_blend,
@@ -687,7 +698,7 @@ struct saturator_metadata: public plugin_metadata<saturator_metadata>
 /// Markus's Exciter - metadata
 struct exciter_metadata: public plugin_metadata<exciter_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out, param_amount, MONO_VU_METER_PARAMS, param_drive, param_blend, param_meter_drive,
            param_freq, param_listen, param_ceil_active, param_ceil, param_count };
     PLUGIN_NAME_ID_LABEL("exciter", "exciter", "Exciter")
@@ -695,7 +706,7 @@ struct exciter_metadata: public plugin_metadata<exciter_metadata>
 /// Markus's Bass Enhancer - metadata
 struct bassenhancer_metadata: public plugin_metadata<bassenhancer_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out, param_amount, MONO_VU_METER_PARAMS, param_drive, param_blend, param_meter_drive,
            param_freq, param_listen, param_floor_active, param_floor, param_count };
     PLUGIN_NAME_ID_LABEL("bassenhancer", "bassenhancer", "Bass Enhancer")
@@ -739,7 +750,7 @@ struct mono_metadata: public plugin_metadata<mono_metadata>
 /// Markus's  multibandenhancer - metadata
 struct multibandenhancer_metadata: public plugin_metadata<multibandenhancer_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS,
            param_freq0, param_freq1, param_freq2,
@@ -780,7 +791,7 @@ struct analyzer_metadata: public plugin_metadata<analyzer_metadata>
 /// Markus's and Chrischi's Transient Designer
 struct transientdesigner_metadata: public plugin_metadata<transientdesigner_metadata>
 {
-    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false };
+    enum { in_count = 2, out_count = 2, ins_optional = 1, outs_optional = 1, support_midi = false, require_midi = false, rt_capable = true, require_instance_access = false, has_latency = true };
     enum { param_bypass, param_level_in, param_level_out,
            STEREO_VU_METER_PARAMS, param_mix,
            param_attack_time, param_attack_boost,
@@ -902,7 +913,7 @@ public:
 struct fluidsynth_metadata: public plugin_metadata<fluidsynth_metadata>
 {
     enum { par_master, par_interpolation, par_reverb, par_chorus, param_count };
-    enum { in_count = 0, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = true, require_midi = true, rt_capable = false, require_instance_access = true };
+    enum { in_count = 0, out_count = 2, ins_optional = 0, outs_optional = 0, support_midi = true, require_midi = true, rt_capable = false, require_instance_access = true, has_threadsafe_configure = true };
     PLUGIN_NAME_ID_LABEL("fluidsynth", "fluidsynth", "Fluidsynth")
 
 public:
@@ -23,6 +23,7 @@
  
 #include "giface.h"
 #include <stdio.h>
+#include <vector>
 
 namespace dsp {
 
@@ -68,29 +69,51 @@ namespace calf_plugins {
 class mod_matrix_impl
 {
 protected:
+    /// Active row of the matrix, with the amount folded into the mapping polynomial
+    struct compiled_route
+    {
+        int src1, src2, dest;
+        float c0, c1, c2;
+    };
     dsp::modulation_entry *matrix;
     mod_matrix_metadata *metadata;
     unsigned int matrix_rows;
     /// Polynomials for different scaling modes (1, x, x^2)
     static const float scaling_coeffs[calf_plugins::mod_matrix_metadata::map_type_count][3];
+    /// Rows with a destination and a non-zero amount, the ones with a linear mapping first
+    std::vector<compiled_route> routes;
+    /// Number of routes in use and the number of linear ones among them
+    int route_count, linear_count;
+    /// Set when a cell changes, cleared when routes are rebuilt
+    int routes_dirty;
 
+    /// Rebuild the route list from the matrix rows
+    void compile_routes();
 public:
     mod_matrix_impl(dsp::modulation_entry *_matrix, calf_plugins::mod_matrix_metadata *_metadata);
+    virtual ~mod_matrix_impl() {}
 
+    /// Pick up matrix changes made by configure(). Call from the audio thread
+    /// before any calculate_modmatrix call of a processing run.
+    inline void update_modmatrix()
+    {
+        if (__atomic_load_n(&routes_dirty, __ATOMIC_ACQUIRE))
+            compile_routes();
+    }
     /// Process modulation matrix, calculate outputs from inputs
-    inline void calculate_modmatrix(float *moddest, int moddest_count, float *modsrc)
+    inline void calculate_modmatrix(float *moddest, int moddest_count, const float *modsrc) const
     {
         for (int i = 0; i < moddest_count; i++)
             moddest[i] = 0;
-        for (unsigned int i = 0; i < matrix_rows; ++i)
+        if (!route_count)
+            return;
+        const compiled_route *r = &routes[0];
+        for (int i = 0; i < linear_count; i++, r++)
+            moddest[r->dest] += (r->c0 + r->c1 * modsrc[r->src1]) * modsrc[r->src2];
+        for (int i = linear_count; i < route_count; i++, r++)
         {
-            dsp::modulation_entry &slot = matrix[i];
-            if (slot.dest) {
-                float value = modsrc[slot.src1];
-                const float *c = scaling_coeffs[slot.mapping];
-                value = c[0] + c[1] * value + c[2] * value * value;
-                moddest[slot.dest] += value * modsrc[slot.src2] * slot.amount;
-            }
+            float value = modsrc[r->src1];
+            moddest[r->dest] += (r->c0 + (r->c1 + r->c2 * value) * value) * modsrc[r->src2];
         }
     }
     void send_configures(send_configure_iface *);
@@ -18,6 +18,7 @@
     
     // Reverb
     PER_MODULE_ITEM(reverb,              false, "reverb")
+    PER_MODULE_ITEM(conv_reverb,         false, "convreverb")
     
     // Delay
     PER_MODULE_ITEM(vintage_delay,       false, "vintagedelay")
@@ -49,11 +49,16 @@ private:
     bool is_active;
     inline float output_level(float slope) const;
     inline float output_gain(float linSlope, bool rms) const;
+    void compute_gains(const float *slopes, float *gains, uint32_t count, bool rms) const;
 public:
     gain_reduction_audio_module();
     void set_params(float att, float rel, float thr, float rat, float kn, float mak, float det, float stl, float byp, float mu);
     void update_curve();
     void process(float &left, float &right, const float *det_left = NULL, const float *det_right = NULL);
+    /// Process a block of samples, output buffers may be the same as the input ones.
+    /// det_left/det_right feed the detector (sidechain), the inputs are used if NULL.
+    /// If gains is not NULL, it receives the gain reduction for every sample (for meters).
+    void process_block(const float *in_left, const float *in_right, float *out_left, float *out_right, uint32_t numsamples, const float *det_left = NULL, const float *det_right = NULL, float *gains = NULL);
     void activate();
     void deactivate();
     int id;
@@ -88,6 +93,9 @@ public:
     void set_params(float att, float rel, float thr, float rat, float kn, float mak, float byp, float mu);
     void update_curve();
     void process(float &left);
+    /// Process a block of samples, the output buffer may be the same as the input one.
+    /// If gains is not NULL, it receives the gain reduction for every sample (for meters).
+    void process_block(const float *in, float *out, uint32_t numsamples, float *gains = NULL);
     void activate();
     void deactivate();
     int id;
@@ -113,6 +121,7 @@ private:
     mutable bool redraw_graph;
     inline float output_level(float slope) const;
     inline float output_gain(float linSlope, bool rms) const;
+    void compute_gains(const float *slopes, float *gains, uint32_t count) const;
 public:
     uint32_t srate;
     bool is_active;
@@ -120,6 +129,10 @@ public:
     void set_params(float att, float rel, float thr, float rat, float kn, float mak, float det, float stl, float byp, float mu, float ran);
     void update_curve();
     void process(float &left, float &right, const float *det_left = NULL, const float *det_right = NULL);
+    /// Process a block of samples, output buffers may be the same as the input ones.
+    /// det_left/det_right feed the detector (sidechain), the inputs are used if NULL.
+    /// If gains is not NULL, it receives the gating gain for every sample (for meters).
+    void process_block(const float *in_left, const float *in_right, float *out_left, float *out_right, uint32_t numsamples, const float *det_left = NULL, const float *det_right = NULL, float *gains = NULL);
     void activate();
     void deactivate();
     int id;
@@ -418,7 +431,6 @@ class transientdesigner_audio_module:
     uint32_t srate;
     bool active;
     mutable bool redraw;
-    float meter_inL, meter_inR, meter_outL, meter_outR;
     dsp::transients transients;
     dsp::bypass bypass;
     dsp::biquad_d2 hp[3], lp[3];
@@ -444,6 +456,7 @@ public:
     void set_sample_rate(uint32_t sr);
     void deactivate();
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    uint32_t get_latency() { return transients.lookahead; }
     bool get_graph(int index, int subindex, int phase, float *data, int points, cairo_iface *context, int *mode) const;
     bool get_gridline(int index, int subindex, int phase, float &pos, bool &vertical, std::string &legend, cairo_iface *context) const;
     bool get_layers(int index, int generation, unsigned int &layers) const;
@@ -26,6 +26,8 @@
 #include <limits.h>
 #include "biquad.h"
 #include "bypass.h"
+#include "convolve.h"
+#include "delaymem.h"
 #include "inertia.h"
 #include "audio_fx.h"
 #include "giface.h"
@@ -60,6 +62,53 @@ public:
     void deactivate();
 };
 
+/**********************************************************************
+ * CONVOLUTION REVERB
+**********************************************************************/
+
+class conv_reverb_audio_module: public audio_module<conv_reverb_metadata>
+{
+public:
+    /// Longest impulse response used, in seconds (the rest is cut off)
+    enum { MAX_IR_TIME = 30 };
+    /// Impulse response prepared for the current sample rate
+    struct ir_set
+    {
+        dsp::convolver *conv[2];
+        float length;
+        /// Link in the list of sets waiting to be freed
+        ir_set *next;
+        ir_set() : length(0), next(NULL) { conv[0] = conv[1] = NULL; }
+        ~ir_set() { delete conv[0]; delete conv[1]; }
+    };
+    /// Set used by process()
+    ir_set *current;
+    /// Set prepared by configure(), taken over by the next process() call
+    ir_set *pending;
+    /// Sets replaced by process(), freed by the next configure() call
+    ir_set *retired;
+    std::string ir_file;
+    uint32_t srate;
+    /// Sample rate the impulse response was last loaded for (written by configure(), read by set_sample_rate())
+    uint32_t ir_srate;
+    dsp::bypass bypass;
+    vumeters meters;
+
+    conv_reverb_audio_module();
+    ~conv_reverb_audio_module();
+
+    void params_changed() {}
+    void activate();
+    void deactivate() {}
+    void set_sample_rate(uint32_t sr);
+    uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    char *configure(const char *key, const char *value);
+    void send_configures(send_configure_iface *sci);
+private:
+    char *load_ir();
+    void free_retired();
+};
+
 /**********************************************************************
  * VINTAGE DELAY by Krzysztof Foltman
 **********************************************************************/
@@ -67,13 +116,15 @@ public:
 class vintage_delay_audio_module: public audio_module<vintage_delay_metadata>, public frequency_response_line_graph
 {
 public:    
-    // 1MB of delay memory per channel... uh, RAM is cheap
-    enum { MAX_DELAY = 524288, ADDR_MASK = MAX_DELAY - 1 };
+    /// Longest delay in seconds the buffers are sized for (longer ones wrap around)
+    enum { MAX_DELAY_TIME = 10 };
     enum { MIXMODE_STEREO, MIXMODE_PINGPONG, MIXMODE_LR, MIXMODE_RL }; 
     enum { FRAG_PERIODIC, FRAG_PATTERN };
-    float buffers[2][MAX_DELAY];
+    dsp::delay_memory buffers[2];
+    /// buffer size (power of 2) and mask for wrapping the buffer position
+    int max_delay, addr_mask;
     int bufptr, deltime_l, deltime_r, mixmode, medium, old_medium;
-    /// number of table entries written (value is only important when it is less than MAX_DELAY, which means that the buffer hasn't been totally filled yet)
+    /// number of table entries written (value is only important when it is less than max_delay, which means that the buffer hasn't been totally filled yet)
     int age;
     
     dsp::gain_smoothing amt_left, amt_right, fb_left, fb_right, dry, chmix;
@@ -114,7 +165,7 @@ public:
 class comp_delay_audio_module: public audio_module<comp_delay_metadata>
 {
 public:
-    float *buffer;
+    dsp::delay_memory buffer;
     uint32_t srate;
     uint32_t buf_size; // guaranteed to be power of 2
     uint32_t delay;
@@ -123,7 +174,6 @@ public:
     vumeters meters;
 
     comp_delay_audio_module();
-    virtual ~comp_delay_audio_module();
 
     void params_changed();
     void activate();
@@ -140,7 +190,7 @@ public:
 class haas_enhancer_audio_module: public audio_module<haas_enhancer_metadata>
 {
 public:
-    float *buffer;
+    dsp::delay_memory buffer;
     uint32_t srate;
     uint32_t buf_size; // guaranteed to be power of 2
     uint32_t write_ptr;
@@ -152,7 +202,6 @@ public:
     float s_bal_l[2], s_bal_r[2];
 
     haas_enhancer_audio_module();
-    virtual ~haas_enhancer_audio_module();
 
     void params_changed();
     void activate();
@@ -168,8 +217,9 @@ public:
 class reverse_delay_audio_module: public audio_module<reverse_delay_metadata>
 {
 public:
-    enum { MAX_DELAY = 6144000, ADDR_MASK = MAX_DELAY - 1 };
-    float buffers[2][MAX_DELAY];
+    /// Longest delay in seconds: 16 beats at 30 bpm
+    enum { MAX_DELAY_TIME = 32 };
+    dsp::delay_memory buffers[2];
     int counters[2];
     dsp::overlap_window ow[2];
     int deltime_l, deltime_r;
@@ -22,6 +22,7 @@
 #define __CALF_MODULES_DEV_H
 
 #include <calf/metadata.h>
+#include <calf/utils.h>
 
 #if ENABLE_EXPERIMENTAL
 #include <fluidsynth.h>
@@ -34,6 +35,24 @@ namespace calf_plugins {
 /// Tiny wrapper for fluidsynth
 class fluidsynth_audio_module: public audio_module<fluidsynth_metadata>
 {
+    /// Loads the soundfont into a new synth outside the processing thread
+    struct load_job: public work_job
+    {
+        fluidsynth_audio_module *owner;
+        /// The new synth until apply(), the replaced one after it
+        fluid_synth_t *synth;
+        int sfid;
+        /// Name and presets of the new soundfont, handed over to the GUI side in cleanup()
+        std::string soundfont_name, preset_list;
+        std::map<uint32_t, std::string> preset_names;
+        /// Set by apply(), the soundfont information still has to be handed over
+        bool applied;
+        load_job() : owner(NULL), synth(NULL), sfid(-1), applied(false) {}
+        ~load_job() { applied = false; cleanup(); }
+        void work();
+        void apply();
+        void cleanup();
+    };
 protected:
     /// Current sample rate
     uint32_t srate;
@@ -58,13 +77,20 @@ protected:
     /// Preset number to set on next process() call
     volatile int set_presets[16];
     volatile bool soundfont_loaded;
+    /// Guards soundfont and the soundfont information sent to the GUI (configure() may run in a worker thread)
+    calf_utils::ptmutex mutex;
+    /// Incremented by configure() when the soundfont changes
+    volatile int soundfont_serial;
+    /// Value of soundfont_serial the load job was last scheduled for (processing thread)
+    int loaded_serial;
+    load_job loader;
 
     /// Update last_selected_preset based on synth object state
     void update_preset_num(int channel);
     /// Send a bank/program change sequence for a specific channel/preset combo
     void select_preset_in_channel(int ch, int new_preset);
-    /// Create a fluidsynth object and load the current soundfont
-    fluid_synth_t *create_synth(int &new_sfid);
+    /// Create a fluidsynth object and load a soundfont into it, the result is stored in the job
+    void create_synth(const std::string &file, load_job &result);
 public:
     /// Constructor to initialize handles to NULL
     fluidsynth_audio_module();
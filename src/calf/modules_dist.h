@@ -44,6 +44,7 @@ private:
     dsp::biquad_d2 lp[2][4], hp[2][4];
     dsp::biquad_d2 p[2];
     dsp::tap_distortion dist[2];
+    dsp::simple_delay<64, float> dry[2];
     dsp::bypass bypass;
     vumeters meters;
 public:
@@ -55,6 +56,7 @@ public:
     void params_changed();
     void set_sample_rate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    uint32_t get_latency() { return dist[0].get_latency(); }
 };
 
 /**********************************************************************
@@ -69,6 +71,7 @@ private:
     dsp::biquad_d2 hp[2][4];
     dsp::biquad_d2 lp[2][2];
     dsp::tap_distortion dist[2];
+    dsp::simple_delay<64, float> dry[2];
     dsp::bypass bypass;
     vumeters meters;
 public:
@@ -80,6 +83,7 @@ public:
     void params_changed();
     void set_sample_rate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    uint32_t get_latency() { return dist[0].get_latency(); }
 };
 
 /**********************************************************************
@@ -94,6 +98,7 @@ private:
     dsp::biquad_d2 lp[2][4];
     dsp::biquad_d2 hp[2][2];
     dsp::tap_distortion dist[2];
+    dsp::simple_delay<64, float> dry[2];
     dsp::bypass bypass;
     vumeters meters;
 public:
@@ -105,6 +110,7 @@ public:
     void params_changed();
     void set_sample_rate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    uint32_t get_latency() { return dist[0].get_latency(); }
 };
 
 /**********************************************************************
@@ -107,10 +107,27 @@ typedef equalizerNband_audio_module<equalizer12band_metadata, true>  equalizer12
 **********************************************************************/
 
 class equalizer30band_audio_module: public audio_module<equalizer30band_metadata> {
+    typedef std::vector<orfanidis_eq::eq2*> eq_array;
+    /// Builds the equalizers for a new sample rate outside the processing thread
+    struct rebuild_job: public work_job
+    {
+        equalizer30band_audio_module *owner;
+        uint32_t srate;
+        /// The new equalizers until apply(), the replaced ones after it
+        eq_array eqL, eqR;
+        rebuild_job() : owner(NULL), srate(0) {}
+        ~rebuild_job() { cleanup(); }
+        void work();
+        void apply();
+        void cleanup();
+    };
     orfanidis_eq::conversions conv;
     orfanidis_eq::freq_grid fg;
-    std::vector<orfanidis_eq::eq2*> eq_arrL;
-    std::vector<orfanidis_eq::eq2*> eq_arrR;
+    eq_array eq_arrL;
+    eq_array eq_arrR;
+    /// Sample rate eq_arrL and eq_arrR were built for
+    uint32_t eq_srate;
+    rebuild_job rebuild;
 
     orfanidis_eq::filter_type flt_type;
     orfanidis_eq::filter_type flt_type_old;
@@ -132,6 +149,12 @@ public:
     void params_changed();
     void set_sample_rate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
+    void post_instantiate(uint32_t sr);
+    /// Build a set of equalizers (one per filter type) for both channels
+    static void create_eqs(orfanidis_eq::freq_grid &fg, uint32_t sr, eq_array &eqL, eq_array &eqR);
+    static void delete_eqs(eq_array &eqs);
+    /// Schedule rebuilding the equalizers if they don't match the sample rate
+    void rebuild_eqs();
 };
 
 /**********************************************************************
@@ -416,7 +439,11 @@ public:
     uint32_t srate;
     bool is_active;
     static const int maxorder = 8;
-    dsp::biquad_d2 detector[2][maxorder][32], modulator[2][maxorder][32];
+    /// Band pass coefficients of each band
+    dsp::biquad_coeffs bandfilter[32];
+    /// Filter stages for all bands; lanes 0-31 filter the left modulator,
+    /// 32-63 the right modulator, 64-95 and 96-127 the carrier
+    dsp::biquad_d2_bank<128> filters[maxorder];
     dsp::bypass bypass;
     double env_mods[2][32];
     vumeters meters;
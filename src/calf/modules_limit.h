@@ -57,8 +57,11 @@ public:
     void deactivate();
     void params_changed();
     void set_srates();
+    void allocate_buffers(uint32_t sr);
+    void post_instantiate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
     void set_sample_rate(uint32_t sr);
+    uint32_t get_latency();
 };
 
 /**********************************************************************
@@ -82,6 +85,7 @@ private:
     unsigned int pos;
     unsigned int buffer_size;
     unsigned int overall_buffer_size;
+    unsigned int allocated_size;
     float *buffer;
     int channels;
     float striprel[strips];
@@ -102,8 +106,11 @@ public:
     void deactivate();
     void params_changed();
     void set_srates();
+    void allocate_buffers(uint32_t sr);
+    void post_instantiate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
     void set_sample_rate(uint32_t sr);
+    uint32_t get_latency();
     bool get_graph(int index, int subindex, int phase, float *data, int points, cairo_iface *context, int *mode) const;
     bool get_layers(int index, int generation, unsigned int &layers) const;
 };
@@ -125,6 +132,7 @@ private:
     unsigned int pos;
     unsigned int buffer_size;
     unsigned int overall_buffer_size;
+    unsigned int allocated_size;
     float *buffer;
     int channels;
     float striprel[strips];
@@ -145,8 +153,11 @@ public:
     void deactivate();
     void params_changed();
     void set_srates();
+    void allocate_buffers(uint32_t sr);
+    void post_instantiate(uint32_t sr);
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
     void set_sample_rate(uint32_t sr);
+    uint32_t get_latency();
     bool get_graph(int index, int subindex, int phase, float *data, int points, cairo_iface *context, int *mode) const;
     bool get_layers(int index, int generation, unsigned int &layers) const;
 };
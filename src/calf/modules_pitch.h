@@ -23,13 +23,14 @@ protected:
     typedef dsp::fft<float, 12> pfft;
     enum { BufferSize = 4096 };
     uint32_t srate;
-    pfft transform;
     float inputbuf[BufferSize];
-    pfft::complex waveform[2 * BufferSize], spectrum[2 * BufferSize], autocorr[2 * BufferSize];
+    float waveform[BufferSize], autocorr[BufferSize];
+    pfft::complex spectrum[BufferSize / 2 + 1];
     float magarr[BufferSize / 2];
     float sumsquares[BufferSize + 1], sumsquares_last;
     uint32_t write_ptr;
     
+    static const pfft &get_transform();
     void recompute();
 public:
     typedef pitch_audio_module AM;
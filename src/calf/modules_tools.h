@@ -49,7 +49,7 @@ class stereo_audio_module:
     uint32_t srate;
     bool active;
     dsp::bypass bypass;
-    float meter_inL, meter_inR, meter_outL, meter_outR, meter_phase;
+    float meter_phase;
     vumeters meters;
     
     float * buffer;
@@ -82,7 +82,6 @@ class mono_audio_module:
     uint32_t srate;
     bool active;
     dsp::bypass bypass;
-    float meter_in, meter_outL, meter_outR;
     vumeters meters;
     
     float * buffer;
@@ -160,6 +159,7 @@ private:
     dsp::bypass bypass;
     vumeters meters;
     dsp::tap_distortion dist[strips][2];
+    dsp::simple_delay<64, float> dry[strips][2];
 public:
     uint32_t srate;
     bool is_active;
@@ -170,6 +170,7 @@ public:
     void params_changed();
     uint32_t process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask);
     void set_sample_rate(uint32_t sr);
+    uint32_t get_latency() { return dist[0][0].get_latency(); }
     bool get_phase_graph(int index, float ** _buffer, int * _length, int * _mode, bool * _use_fade, float * _fade, int * _accuracy, bool * _display) const;
     bool get_graph(int index, int subindex, int phase, float *data, int points, cairo_iface *context, int *mode) const;
     bool get_layers(int index, int generation, unsigned int &layers) const;
@@ -190,7 +191,10 @@ class multispread_audio_module: public audio_module<multispread_metadata>,
 private:
     dsp::bypass bypass;
     vumeters meters;
-    dsp::biquad_d1 L[16], R[16];
+    /// Coefficients of the peak filters in both chains
+    dsp::biquad_coeffs L[16], R[16];
+    /// The filter chains, one stage per lane
+    dsp::biquad_d2_bank<16, double> bankL, bankR;
 public:
     uint32_t srate;
     bool is_active;
@@ -284,7 +284,7 @@ public:
     }
 };
 
-struct drawbar_organ: public dsp::basic_synth, public calf_plugins::organ_enums {
+struct drawbar_organ: public dsp::static_voice_synth<dsp::block_voice<organ_voice> >, public calf_plugins::organ_enums {
     organ_parameters *parameters;
     percussion_voice percussion;
     scanner_vibrato global_vibrato;
@@ -296,7 +296,7 @@ struct drawbar_organ: public dsp::basic_synth, public calf_plugins::organ_enums
         init_voices(36);
     }
     void render_separate(float *output[], int nsamples);
-    dsp::voice *alloc_voice();
+    void init_voice(dsp::block_voice<organ_voice> *v);
     virtual void percussion_note_on(int note, int vel);
     virtual void params_changed() = 0;
     virtual void setup(int sr);
@@ -24,6 +24,7 @@
 
 #include "fft.h"
 #include <map>
+#include <vector>
 
 namespace dsp
 {
@@ -76,9 +77,10 @@ template<int SIZE_BITS>
 struct bandlimiter
 {
     enum { SIZE = 1 << SIZE_BITS };
-    static dsp::fft<float, SIZE_BITS> &get_fft()
+    typedef dsp::fft<float, SIZE_BITS> fft_type;
+    static const fft_type &get_fft()
     {
-        static dsp::fft<float, SIZE_BITS> fft;
+        static fft_type fft;
         return fft;
     }
     
@@ -87,23 +89,29 @@ struct bandlimiter
     /// Import time domain waveform and calculate spectrum from it
     void compute_spectrum(float input[SIZE])
     {
-        dsp::fft<float, SIZE_BITS> &fft = get_fft();
-        std::complex<float> *data = new std::complex<float>[SIZE];
-        for (int i = 0; i < SIZE; i++)
-            data[i] = input[i];
-        fft.calculate(data, spectrum, false);
-        delete []data;
+        get_fft().rfft(SIZE_BITS, input, spectrum);
+        // mirror the upper half, some callers modify both halves
+        for (int i = 1; i < SIZE / 2; i++)
+            spectrum[SIZE - i] = std::conj(spectrum[i]);
     }
     
     /// Generate the waveform from the contained spectrum.
     void compute_waveform(float output[SIZE])
     {
-        dsp::fft<float, SIZE_BITS> &fft = get_fft();
-        std::complex<float> *data = new std::complex<float>[SIZE];
-        fft.calculate(spectrum, data, true);
-        for (int i = 0; i < SIZE; i++)
-            output[i] = data[i].real();
-        delete []data;
+        std::vector<std::complex<float> > half;
+        half.resize(SIZE / 2 + 1);
+        fold_spectrum(spectrum, &half.front());
+        get_fft().irfft(SIZE_BITS, &half.front(), output);
+    }
+    
+    /// Convert a full spectrum into the lower half of the Hermitian spectrum
+    /// that has the same real part of the inverse transform
+    static void fold_spectrum(const std::complex<float> *full, std::complex<float> *half)
+    {
+        half[0] = full[0].real();
+        half[SIZE / 2] = full[SIZE / 2].real();
+        for (int i = 1; i < SIZE / 2; i++)
+            half[i] = (full[i] + std::conj(full[SIZE - i])) * 0.5f;
     }
     
     /// remove DC offset of the spectrum (it usually does more harm than good!)
@@ -116,15 +124,12 @@ struct bandlimiter
     /// might need to be improved much in future!
     void make_waveform(float output[SIZE], int cutoff, bool foldover = false)
     {
-        dsp::fft<float, SIZE_BITS> &fft = get_fft();
-        std::vector<std::complex<float> > new_spec, iffted;
-        new_spec.resize(SIZE);
-        iffted.resize(SIZE);
+        std::vector<std::complex<float> > new_spec;
+        new_spec.resize(SIZE / 2 + 1);
         // Copy original harmonics up to cutoff point
-        new_spec[0] = spectrum[0];
-        for (int i = 1; i < cutoff; i++)
-            new_spec[i] = spectrum[i], 
-            new_spec[SIZE - i] = spectrum[SIZE - i];
+        new_spec[0] = spectrum[0].real();
+        for (int i = 1; i < cutoff && i < SIZE / 2; i++)
+            new_spec[i] = (spectrum[i] + std::conj(spectrum[SIZE - i])) * 0.5f;
         // Fill the rest with zeros, optionally folding over harmonics over the
         // cutoff point into the lower octaves while halving the amplitude.
         // (I think it is almost nice for bell type waveforms when the original
@@ -138,9 +143,7 @@ struct bandlimiter
             for (int i = SIZE / 2; i >= cutoff; i--)
             {
                 new_spec[i / 2] += new_spec[i] * fatt;
-                new_spec[SIZE - i / 2] += new_spec[SIZE - i] * fatt;
-                new_spec[i] = 0.f,
-                new_spec[SIZE - i] = 0.f;
+                new_spec[i] = 0.f;
             }
         }
         else
@@ -148,13 +151,10 @@ struct bandlimiter
             if (cutoff < 1)
                 cutoff = 1;
             for (int i = cutoff; i < SIZE / 2; i++)
-                new_spec[i] = 0.f,
-                new_spec[SIZE - i] = 0.f;
+                new_spec[i] = 0.f;
         }
-        // convert back to time domain (IFFT) and extract only real part
-        fft.calculate(&new_spec.front(), &iffted.front(), true);
-        for (int i = 0; i < SIZE; i++)
-            output[i] = iffted[i].real();
+        // convert back to time domain (real IFFT)
+        get_fft().irfft(SIZE_BITS, &new_spec.front(), output);
     }
 };
 
@@ -167,6 +167,10 @@ struct waveform_family: public std::map<uint32_t, float *>
     using std::map<uint32_t, float *>::end;
     using std::map<uint32_t, float *>::lower_bound;
     float original[SIZE];
+    /// False if the level tables are owned by someone else (e.g. a mapped cache file)
+    bool owns_levels;
+    
+    waveform_family() : owns_levels(true) {}
     
     /// Fill the family using specified bandlimiter and original waveform. Optionally apply foldover. 
     /// Does not produce harmonics over specified limit (limit = (SIZE / 2) / min_number_of_harmonics)
@@ -181,6 +185,10 @@ struct waveform_family: public std::map<uint32_t, float *>
     /// Does not produce harmonics over specified limit (limit = (SIZE / 2) / min_number_of_harmonics)
     void make_from_spectrum(bandlimiter<SIZE_BITS> &bl, bool foldover = false, uint32_t limit = SIZE / 2)
     {
+        if (!owns_levels) {
+            clear();
+            owns_levels = true;
+        }
         bl.remove_dc();
         
         uint32_t base = 1 << (32 - SIZE_BITS);
@@ -223,8 +231,9 @@ struct waveform_family: public std::map<uint32_t, float *>
     /// Destructor, deletes the waveforms and removes them from the map.
     ~waveform_family()
     {
-        for (iterator i = begin(); i != end(); i++)
-            delete []i->second;
+        if (owns_levels)
+            for (iterator i = begin(); i != end(); i++)
+                delete []i->second;
         clear();
     }
 };
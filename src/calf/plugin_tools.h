@@ -35,6 +35,8 @@ public:
     {
         int level_idx;
         int clip_idx;
+        /// Port numbers for the level and clip values, -1 if not used
+        int level_param, clip_param;
         dsp::vumeter meter;
     };
     
@@ -47,30 +49,55 @@ public:
             meter_data &md = meters[i];
             md.level_idx = lvls[i];
             md.clip_idx = clps[i];
+            md.level_param = lvls[i] != -1 ? abs(lvls[i]) : -1;
+            md.clip_param = clps[i] != -1 ? abs(clps[i]) : -1;
             md.meter.set_reverse(lvls[i] < -1);
             md.meter.set_falloff(1.f, srate);
         }
         params = prms;
     }
+    /// Update the meters with one value each
     void process(float *values) {
         for (size_t i = 0; i < meters.size(); ++i) {
             meter_data &md = meters[i];
-            if ((md.level_idx != -1 && params[(int)fabs(md.level_idx)] != NULL) || 
-                (md.clip_idx != -1 && params[(int)fabs(md.clip_idx)] != NULL))
+            if (is_connected(md))
             {
                 md.meter.process(values[i]);
-                if (md.level_idx != -1 && params[(int)fabs(md.level_idx)])
-                    *params[(int)fabs(md.level_idx)] = md.meter.level;
-                if (md.clip_idx != -1 && params[(int)fabs(md.clip_idx)])
-                    *params[(int)fabs(md.clip_idx)] = md.meter.clip > 0 ? 1.f : 0.f;
+                update_ports(md);
             }
         }
     }
+    /// Update the meters with a block of values each, and write the output ports once.
+    /// @arg data buffers of numsamples values for each meter; NULL for a meter that gets no signal
+    ///      in this block, or for the whole array (e.g. when bypassed)
+    /// @arg scale optional gain to apply to each of the buffers
+    void process(const float *const *data, uint32_t numsamples, const float *scale = NULL) {
+        for (size_t i = 0; i < meters.size(); ++i) {
+            meter_data &md = meters[i];
+            if (!is_connected(md))
+                continue;
+            if (data && data[i])
+                md.meter.process_block(data[i], numsamples, scale ? scale[i] : 1.f);
+            else
+                md.meter.process_neutral(numsamples);
+            update_ports(md);
+        }
+    }
     void fall(unsigned int numsamples) {
         for (size_t i = 0; i < meters.size(); ++i)
             if (meters[i].level_idx != -1)
                 meters[i].meter.fall(numsamples);
     }
+private:
+    inline bool is_connected(const meter_data &md) const {
+        return (md.level_param != -1 && params[md.level_param]) || (md.clip_param != -1 && params[md.clip_param]);
+    }
+    inline void update_ports(const meter_data &md) {
+        if (md.level_param != -1 && params[md.level_param])
+            *params[md.level_param] = md.meter.level;
+        if (md.clip_param != -1 && params[md.clip_param])
+            *params[md.clip_param] = md.meter.clip > 0 ? 1.f : 0.f;
+    }
 };
 
 struct debug_send_configure_iface: public send_configure_iface
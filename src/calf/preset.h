@@ -85,6 +85,17 @@ typedef std::vector<plugin_preset> preset_vector;
 /// A single list of presets (usually there are two - @see get_builtin_presets(), get_user_presets() )
 struct preset_list
 {
+    /// Input of a rack plugin fed directly by an output of another plugin
+    struct input_link
+    {
+        /// Index of the input
+        int input;
+        /// Index of the feeding plugin in the rack
+        int plugin;
+        /// Index of the feeding plugin's output
+        int output;
+    };
+
     /// Plugin list item
     struct plugin_snapshot
     {
@@ -102,6 +113,8 @@ struct preset_list
         int midi_index;
         /// Automation assignments for this plugin
         std::vector<std::pair<std::string, std::string> > automation_entries;
+        /// Inputs linked to other plugins
+        std::vector<input_link> links;
         
         /// Reset to initial values
         void reset();
@@ -118,6 +131,7 @@ struct preset_list
         PLUGIN, ///< Inside plugin element (calfjackhost snapshots only)
         RACK, ///< Inside rack element (calfjackhost snapshots only)
         AUTOMATION_ENTRY, ///< inside automation element (calfjackhost snapshots only, always an empty element)
+        LINK_ENTRY, ///< inside link element (calfjackhost snapshots only, always an empty element)
     } state;
 
     /// Contained presets (usually for all plugins)
@@ -25,6 +25,7 @@
 #include <stdint.h>
 #include <stdio.h>
 #include <string.h>
+#include <algorithm>
 #include <cmath>
 #include <cstdlib>
 #include <map>
@@ -492,6 +493,63 @@ inline float hermite_interpolation(float x, float x0, float x1, float p0, float
     //return (2*t3 - 3*t2 + 1) * p0 + (t3 - 2*t2 + t) * m0 + (-2*t3 + 3*t2) * p1 + (t3-t2) * m1;
 }
 
+/// Fast base 2 logarithm of a positive, normal value (absolute error below 4e-5).
+/// Written without branches, so that loops using it can be vectorized.
+inline float fast_log2(float value)
+{
+    int32_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    float exponent = (float)((bits >> 23) - 127);
+    bits = (bits & 0x007FFFFF) | 0x3F800000;
+    float m;
+    memcpy(&m, &bits, sizeof(m));
+    m -= 1.f;
+    return exponent + m * (1.4418255f + m * (-0.70867891f + m * (0.41541119f + m * (-0.19440832f + m * 0.045878950f))));
+}
+
+/// Fast 2^value (relative error below 5e-6), value is clamped to the normal float range.
+/// Written without branches, so that loops using it can be vectorized.
+inline float fast_exp2(float value)
+{
+    value = std::max(-126.f, std::min(126.f, value));
+    int32_t ipart = (int32_t)value;
+    ipart -= (float)ipart > value ? 1 : 0;
+    float f = value - (float)ipart;
+    float result = 1.f + f * (0.69301863f + f * (0.24140477f + f * (0.052073936f + f * 0.013493475f)));
+    int32_t bits;
+    memcpy(&bits, &result, sizeof(bits));
+    bits += ipart << 23;
+    memcpy(&result, &bits, sizeof(result));
+    return result;
+}
+
+/// Find the first value in a buffer that is a NaN, an infinity or larger than 2^32 in magnitude.
+/// Works on the bit patterns, so that it is not affected by -ffast-math; the common case
+/// (all values sane) is a single max reduction that the compiler can vectorize.
+/// @return index of the first questionable value, or count if there are none
+inline uint32_t find_questionable(const float *data, uint32_t count)
+{
+    // 2^32; NaNs and infinities have all exponent bits set, so they compare above it as well
+    const uint32_t limit = 0x4F800000;
+    uint32_t peak = 0;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bits;
+        memcpy(&bits, data + i, sizeof(bits));
+        peak = std::max(peak, bits & 0x7FFFFFFF);
+    }
+    if (peak <= limit)
+        return count;
+    for (uint32_t i = 0; i < count; i++)
+    {
+        uint32_t bits;
+        memcpy(&bits, data + i, sizeof(bits));
+        if ((bits & 0x7FFFFFFF) > limit)
+            return i;
+    }
+    return count;
+}
+
 /// convert amplitude value to dB
 inline float amp2dB(float amp)
 {
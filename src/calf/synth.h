@@ -26,9 +26,14 @@
 #include <math.h>
 #include <memory.h>
 #include <stdint.h>
+#include <stdlib.h>
+#include <pthread.h>
+#include <semaphore.h>
 #include <bitset>
 #include <list>
+#include <new>
 #include <stack>
+#include <vector>
 
 namespace dsp {
 
@@ -264,11 +269,62 @@ struct basic_pool {
             return NULL;
     }
 
+    void clear()
+    {
+        while(count)
+            items[--count] = T();
+    }
+
     ~basic_pool()
     {
         delete []items;
     }
 };
+
+/// Small pool of worker threads rendering the voices of one synth in
+/// parallel. The voice list is cut into one slice per thread, each slice is
+/// rendered into its own buffer and the buffers are summed in slice order,
+/// so the result does not depend on which thread rendered which slice. The
+/// calling (audio) thread takes part in the work, so a cycle completes even
+/// if the workers are not woken in time.
+class voice_render_pool
+{
+public:
+    /// Longest block rendered at once (same as calf_plugins::MAX_SAMPLE_RUN)
+    enum { MaxSamples = 256 };
+private:
+    struct worker
+    {
+        voice_render_pool *owner;
+        pthread_t thread;
+        sem_t wakeup;
+    };
+    std::vector<worker *> workers;
+    float (*buffers)[MaxSamples][2];
+    voice **job_voices;
+    int job_count, job_samples, job_slices;
+    /// Next slice to be claimed and number of slices finished
+    int next_slice, done_slices;
+    /// Set while render() is running, number of workers looking at the job
+    int running, active;
+    volatile bool quit;
+    bool sched_copied;
+    static int default_threads;
+
+    static void *worker_thread(void *arg);
+    void work();
+public:
+    /// Start threads - 1 worker threads
+    voice_render_pool(int threads);
+    ~voice_render_pool();
+    int get_thread_count() const { return workers.size() + 1; }
+    /// Add the output of count voices to output. Called from the audio thread.
+    void render(voice **voices, int count, float (*output)[2], int nsamples);
+    /// Number of threads synths set up from now on render their voices with (1 = no pool)
+    static void set_default_threads(int threads) { default_threads = threads; }
+    static int get_default_threads() { return default_threads; }
+};
+
 /// Base class for all kinds of polyphonic instruments, provides
 /// somewhat reasonable voice management, pedal support - and 
 /// little else. It's implemented as a base class with virtual
@@ -294,17 +350,15 @@ protected:
     std::bitset<128> gate;
     /// Maximum allocated number of channels
     unsigned int polyphony_limit;
+    /// Worker threads rendering the voices, NULL to render them serially
+    voice_render_pool *render_pool;
 
     void init_voices(int count);
     void kill_note(int note, int vel, bool just_one);
     virtual dsp::voice *alloc_voice() = 0;
 public:
-    virtual void setup(int sr) {
-        sample_rate = sr;
-        hold = false;
-        sostenuto = false;
-        polyphony_limit = (unsigned)-1;
-    }
+    basic_synth() : render_pool(NULL) {}
+    virtual void setup(int sr);
     virtual void trim_voices();
     virtual dsp::voice *give_voice();
     virtual void steal_voice();
@@ -320,6 +374,74 @@ public:
     virtual ~basic_synth();
 };
 
+/// basic_synth with a single voice type known at compile time. All voices
+/// are constructed in one allocation, each starting on its own cache line
+/// (so that voices rendered by different threads never share one), and the
+/// render loop calls them directly instead of through the vtable.
+template<class V>
+class static_voice_synth: public basic_synth {
+    enum { CacheLine = 64 };
+    char *voice_block;
+    size_t voice_stride;
+    int block_size, block_used;
+protected:
+    V *get_voice(int i) { return (V *)(voice_block + i * voice_stride); }
+    /// Construct count voices in a single block, init_voice is called for each of them
+    void init_voices(int count)
+    {
+        assert(!voice_block);
+        size_t align = std::max<size_t>(CacheLine, __alignof__(V));
+        voice_stride = (sizeof(V) + align - 1) & ~(align - 1);
+        void *mem = NULL;
+        if (posix_memalign(&mem, align, voice_stride * count))
+            throw std::bad_alloc();
+        voice_block = (char *)mem;
+        for (int i = 0; i < count; i++)
+            new (get_voice(i)) V;
+        block_size = count;
+        basic_synth::init_voices(count);
+    }
+    /// Set up a newly constructed voice (pointers to parameters etc.)
+    virtual void init_voice(V *v) {}
+    dsp::voice *alloc_voice()
+    {
+        assert(block_used < block_size);
+        V *v = get_voice(block_used++);
+        init_voice(v);
+        return v;
+    }
+public:
+    static_voice_synth() : voice_block(NULL), voice_stride(0), block_size(0), block_used(0) {}
+    virtual void render_to(float (*output)[2], int nsamples)
+    {
+        if (render_pool && active_voices.size() > 1) {
+            basic_synth::render_to(output, nsamples);
+            return;
+        }
+        // render voices, eliminate ones that aren't sounding anymore
+        for (dsp::voice **i = active_voices.begin(); i != active_voices.end(); ) {
+            V *v = static_cast<V *>(*i);
+            v->V::render_to(output, nsamples);
+            if (!v->V::get_active()) {
+                i = active_voices.erase(i);
+                unused_voices.add(v);
+                continue;
+            }
+            i++;
+        }
+    }
+    virtual ~static_voice_synth()
+    {
+        // the voices are not basic_synth's to delete
+        allocated_voices.clear();
+        active_voices.clear();
+        unused_voices.clear();
+        for (int i = 0; i < block_size; i++)
+            get_voice(i)->~V();
+        free(voice_block);
+    }
+};
+
 }
 
 #endif
@@ -22,6 +22,7 @@
 #define __CALF_VUMETER_H
 
 #include <math.h>
+#include <algorithm>
 
 namespace dsp {
 
@@ -53,6 +54,7 @@ struct vumeter
     {
         level = reverse ? 1 : 0;
         clip = 0;
+        count_over = 0;
     }
     
     /// Set falloff so that the meter falls 20dB in time_20dB seconds, assuming sample rate of sample_rate
@@ -109,6 +111,57 @@ struct vumeter
         if (count_over >= 3)
             clip = 1.f;
     }
+    /// Update peak meter with a block of values multiplied by scale, same as calling process() for each of them.
+    /// The common case (no clipping) is a single min/max reduction.
+    inline void process_block(const float *src, unsigned int len, float scale = 1.f)
+    {
+        if (!len)
+            return;
+        scale = fabs(scale);
+        if (reverse)
+        {
+            float peak = fabs(src[0]);
+            for (unsigned int i = 1; i < len; i++)
+                peak = std::min(peak, (float)fabs(src[i]));
+            // the level can only go down, so it stays within range if it starts there
+            if (level <= 1.f)
+            {
+                level = std::min(level, peak * scale);
+                count_over = 0;
+                return;
+            }
+        }
+        else
+        {
+            float peak = 0.f;
+            for (unsigned int i = 0; i < len; i++)
+                peak = std::max(peak, (float)fabs(src[i]));
+            if (level <= 1.f && peak * scale <= 1.f)
+            {
+                level = std::max(level, peak * scale);
+                count_over = 0;
+                return;
+            }
+        }
+        // over 0dB somewhere in the block - count the samples exactly
+        for (unsigned int i = 0; i < len; i++)
+            process(src[i] * scale);
+    }
+    /// Same as process_block() with a block of zeros (or of ones for a reverse meter)
+    inline void process_neutral(unsigned int len)
+    {
+        if (!len)
+            return;
+        if (reverse)
+            level = std::min(level, 1.f);
+        if (level > 1.f) {
+            count_over += len;
+            if (count_over >= 3)
+                clip = 1.f;
+        }
+        else
+            count_over = 0;
+    }
     void fall(unsigned int len) {
         // "Age" the old level by falloff^length
         if (reverse)
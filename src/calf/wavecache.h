@@ -0,0 +1,107 @@
+/* Calf DSP Library
+ * Persistent cache of precalculated waveform tables
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+#ifndef CALF_WAVECACHE_H
+#define CALF_WAVECACHE_H
+
+#include "primitives.h"
+#include "osc.h"
+#include <stdint.h>
+#include <string.h>
+#include <string>
+#include <vector>
+
+namespace dsp
+{
+
+/**
+ * Binary cache of waveform families, stored in $XDG_CACHE_HOME/calf (or
+ * ~/.cache/calf). The file is written once by whoever calculates the
+ * tables first and memory mapped read-only afterwards, so the level tables
+ * are shared between all instances and processes through the page cache.
+ *
+ * A file is identified by its name and a table version, which has to be
+ * bumped whenever the code producing the tables changes. Byte order, table
+ * sizes and a checksum over the whole contents are verified on open().
+ *
+ * Families loaded from the cache point into the mapping, which is never
+ * unmapped - they are meant to be static anyway.
+ */
+class wave_cache
+{
+public:
+    wave_cache(const char *name, uint32_t version);
+    /// Map and verify the cache file, false if it is missing, stale or corrupt
+    bool open();
+    /// Fill count families from the next records, false if they don't match
+    template<int BITS>
+    bool load(waveform_family<BITS> *families, int count)
+    {
+        if (!check_records(BITS, count))
+            return false;
+        for (int i = 0; i < count; i++) {
+            waveform_family<BITS> &wf = families[i];
+            uint32_t levels = read_record_header();
+            memcpy(wf.original, data + pos, sizeof(wf.original));
+            pos += sizeof(wf.original);
+            wf.clear();
+            for (uint32_t l = 0; l < levels; l++) {
+                uint32_t key;
+                memcpy(&key, data + pos, sizeof(key));
+                wf[key] = (float *)(data + pos + sizeof(key));
+                pos += sizeof(key) + (wf.SIZE + 1) * sizeof(float);
+            }
+            wf.owns_levels = false;
+        }
+        return true;
+    }
+    /// Queue count families for writing by save()
+    template<int BITS>
+    void store(const waveform_family<BITS> *families, int count)
+    {
+        for (int i = 0; i < count; i++) {
+            const waveform_family<BITS> &wf = families[i];
+            write_record_header(BITS, wf.size());
+            append(wf.original, sizeof(wf.original));
+            for (typename waveform_family<BITS>::const_iterator l = wf.begin(); l != wf.end(); ++l) {
+                append(&l->first, sizeof(l->first));
+                append(l->second, (wf.SIZE + 1) * sizeof(float));
+            }
+        }
+    }
+    /// Write the stored families (atomically replacing an older file)
+    bool save();
+private:
+    std::string name;
+    uint32_t version;
+    const char *data;
+    size_t size, pos;
+    std::vector<char> pending;
+
+    std::string get_path() const;
+    bool check_records(uint32_t bits, int count) const;
+    uint32_t read_record_header();
+    void write_record_header(uint32_t bits, uint32_t levels);
+    void append(const void *src, size_t bytes);
+};
+
+};
+
+#endif
@@ -2,6 +2,9 @@
 #define __CALF_WAVETABLE_H
 
 #include <assert.h>
+#include <pthread.h>
+#include <semaphore.h>
+#include <string.h>
 #include "biquad.h"
 #include "onepole.h"
 #include "audio_fx.h"
@@ -17,29 +20,94 @@ namespace calf_plugins {
 
 class wavetable_audio_module;
     
+/// Oscillator reading a set of 129 waveform slices (the last one is only
+/// used for interpolation). Each output sample is the average of 8 linearly
+/// interpolated points spread over the sample's phase increment, which takes
+/// the edge off aliasing, and the result is interpolated between the two
+/// slices around the slice position.
 struct wavetable_oscillator: public dsp::simple_oscillator
 {
-    enum { SIZE = 1 << 8, MASK = SIZE - 1, SCALE = 1 << (32 - 8) };
-    int16_t (*tables)[256];
-    inline float get(uint16_t slice)
+    enum { SIZE = 1 << 8, MASK = SIZE - 1, SCALE = 1 << (32 - 8), SubSteps = 8 };
+    /// One waveform in the -1..1 range, the first point repeated at the end
+    typedef float waveform[SIZE + 1];
+    const waveform *tables;
+    /// Write count (a multiple of 4) samples for per-sample slice positions
+    /// (8.8 fixed point, at most 128 * 256 - 1), four samples at a time
+    void render(float *output, const int *slices, int count)
     {
-        float fracslice = (slice & 255) * (1.0 / 256.0);
-        slice = slice >> 8;
-        int16_t *waveform = tables[slice];
-        int16_t *waveform2 = tables[slice + 1];
-        float value1 = 0.f, value2 = 0.f;
-        uint32_t cphase = phase, cphasedelta = phasedelta >> 3;
-        for (int j = 0; j < 8; j++)
+        typedef uint32_t u32x4 __attribute__((vector_size(16)));
+        typedef int32_t i32x4 __attribute__((vector_size(16)));
+        typedef float f32x4 __attribute__((vector_size(16)));
+        uint32_t dph = phasedelta, sub = phasedelta / SubSteps;
+        u32x4 ph = { phase, phase + dph, phase + 2 * dph, phase + 3 * dph };
+        for (int i = 0; i < count; i += 4)
         {
-            uint32_t wpos = cphase >> (32 - 8);
-            uint32_t wpos2 = (wpos + 1) & MASK;
-            float frac = (cphase & (SCALE - 1)) * (1.0f / SCALE);
-            value1 += dsp::lerp((float)waveform[wpos], (float)waveform[wpos2], frac);
-            value2 += dsp::lerp((float)waveform2[wpos], (float)waveform2[wpos2], frac);
-            cphase += cphasedelta;
+            const float *w1[4], *w2[4];
+            f32x4 fracslice;
+            for (int l = 0; l < 4; l++)
+            {
+                int slice = slices[i + l];
+                w1[l] = tables[slice >> 8];
+                w2[l] = tables[(slice >> 8) + 1];
+                fracslice[l] = (slice & 255) * (1.0f / 256.0f);
+            }
+            f32x4 value1 = {}, value2 = {};
+            u32x4 cph = ph;
+            for (int j = 0; j < SubSteps; j++)
+            {
+                u32x4 wpos = cph >> (32 - 8);
+                f32x4 frac = __builtin_convertvector((i32x4)(cph & (SCALE - 1)), f32x4) * (1.0f / SCALE);
+                f32x4 a1 = { w1[0][wpos[0]], w1[1][wpos[1]], w1[2][wpos[2]], w1[3][wpos[3]] };
+                f32x4 b1 = { w1[0][wpos[0] + 1], w1[1][wpos[1] + 1], w1[2][wpos[2] + 1], w1[3][wpos[3] + 1] };
+                f32x4 a2 = { w2[0][wpos[0]], w2[1][wpos[1]], w2[2][wpos[2]], w2[3][wpos[3]] };
+                f32x4 b2 = { w2[0][wpos[0] + 1], w2[1][wpos[1] + 1], w2[2][wpos[2] + 1], w2[3][wpos[3] + 1] };
+                value1 += a1 + (b1 - a1) * frac;
+                value2 += a2 + (b2 - a2) * frac;
+                cph += sub;
+            }
+            f32x4 value = (value1 + (value2 - value1) * fracslice) * (1.0f / SubSteps);
+            memcpy(output + i, &value, sizeof(value));
+            ph += 4 * dph;
         }
-        phase += phasedelta;
-        return dsp::lerp(value1, value2, fracslice) * (1.0 / 8.0) * (1.0 / 32768.0);;
+        phase += dph * count;
+    }
+};
+
+/// Wavetables of the wavetable synth, shared by all instances in the process.
+/// A table is calculated the first time it is asked for and never changes
+/// afterwards. Tables requested from the audio thread are calculated by a
+/// helper thread, so they may take a few milliseconds to show up.
+class wavetable_bank
+{
+    typedef wavetable_oscillator::waveform waveform;
+    /// 129 slices per table
+    waveform *tables[wavetable_metadata::wt_count];
+    /// Tables requested with request()
+    int wanted[wavetable_metadata::wt_count];
+    int refcount;
+    bool quit;
+    pthread_mutex_t mutex;
+    pthread_t builder;
+    sem_t requests;
+
+    wavetable_bank();
+    ~wavetable_bank();
+    static void *builder_thread(void *arg);
+public:
+    /// Get the shared bank, creating it if needed
+    static wavetable_bank *acquire();
+    /// Drop a reference obtained by acquire(), the last one frees the bank
+    void release();
+    /// Table with the given index, calculated in the calling thread if needed
+    const waveform *get(int index);
+    /// Table with the given index if it is ready, otherwise NULL (and the
+    /// table is queued for the helper thread). Real time safe.
+    const waveform *request(int index)
+    {
+        const waveform *t = __atomic_load_n(&tables[index], __ATOMIC_ACQUIRE);
+        if (!t && !__atomic_exchange_n(&wanted[index], 1, __ATOMIC_RELAXED))
+            sem_post(&requests);
+        return t;
     }
 };
 
@@ -75,7 +143,7 @@ public:
     void channel_pressure(int value);
     void steal();
     void render_block(int current_snapshot);
-    const int16_t *get_last_table(int osc) const;
+    const float *get_last_table(int osc) const;
     virtual int get_current_note() {
         return note;
     }
@@ -91,7 +159,7 @@ public:
     }
 };    
 
-class wavetable_audio_module: public audio_module<wavetable_metadata>, public dsp::basic_synth, public dsp::block_allvoices_base<wavetable_voice>, public line_graph_iface, public mod_matrix_impl
+class wavetable_audio_module: public audio_module<wavetable_metadata>, public dsp::static_voice_synth<dsp::block_voice<wavetable_voice> >, public dsp::block_allvoices_base<wavetable_voice>, public line_graph_iface, public mod_matrix_impl
 {
 public:
     using dsp::basic_synth::note_on;
@@ -104,7 +172,8 @@ protected:
     bool panic_flag;
 
 public:
-    int16_t tables[wt_count][129][256]; // one dummy level for interpolation
+    /// Shared tables
+    wavetable_bank *bank;
     /// Rows of the modulation matrix
     dsp::modulation_entry mod_matrix_data[mod_matrix_slots];
     /// Smoothed pitch bend value
@@ -123,11 +192,11 @@ public:
 
 public:
     wavetable_audio_module();
+    ~wavetable_audio_module();
+    void activate();
 
-    dsp::voice *alloc_voice() {
-        dsp::block_voice<wavetable_voice> *v = new dsp::block_voice<wavetable_voice>();
+    void init_voice(dsp::block_voice<wavetable_voice> *v) {
         v->set_params_ptr(this, sample_rate);
-        return v;
     }
     
     uint32_t get_crate() const { return crate; }
@@ -135,6 +204,7 @@ public:
     /// process function copied from Organ (will probably need some adjustments as well as implementing the panic flag elsewhere
     uint32_t process(uint32_t offset, uint32_t nsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
         float *o[2] = { outs[0] + offset, outs[1] + offset };
+        update_modmatrix();
         if (panic_flag)
         {
             control_change(120, 0); // stop all sounds
@@ -145,7 +215,7 @@ public:
         fill_snapshots(nsamples);
         float buf[MAX_SAMPLE_RUN][2];
         dsp::zero(&buf[0][0], 2 * nsamples);
-        basic_synth::render_to(buf, nsamples);
+        render_to(buf, nsamples);
         if (!active_voices.empty())
             last_voice = (wavetable_voice *)*active_voices.begin();
         float gain = 1.0f;
@@ -170,7 +240,7 @@ public:
         inertia_pitchbend.ramp.set_length(crate / 30); // 1/30s    
         inertia_pressure.ramp.set_length(crate / 30); // 1/30s - XXXKF monosynth needs that too
     }
-    virtual void note_on(int /*channel*/, int note, int velocity) { dsp::basic_synth::note_on(note, velocity); }
+    virtual void note_on(int /*channel*/, int note, int velocity) { update_modmatrix(); dsp::basic_synth::note_on(note, velocity); }
     virtual void note_off(int /*channel*/, int note, int velocity) { dsp::basic_synth::note_off(note, velocity); }
     virtual void control_change(int /*channel*/, int controller, int value);
     /// Handle MIDI Channel Pressure
@@ -0,0 +1,340 @@
+/* Calf DSP Library
+ * Partitioned FFT convolution
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+#include <config.h>
+#include <calf/convolve.h>
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
+
+using namespace std;
+using namespace dsp;
+
+const convolver::fft_type &convolver::get_fft()
+{
+    // shared by all instances, the transforms don't modify it
+    static fft_type *shared_fft = new fft_type;
+    return *shared_fft;
+}
+
+static int log2_of(int value)
+{
+    int order = 0;
+    while ((1 << order) < value)
+        order++;
+    return order;
+}
+
+convolver::convolver(const float *ir, int length)
+: transform(get_fft())
+{
+    head.resize(BlockSize);
+    for (int i = 0; i < BlockSize; i++)
+        head[BlockSize - 1 - i] = i < length ? ir[i] : 0.f;
+    recent.resize(2 * BlockSize - 1);
+
+    // Partition sizes grow 4 times from group to group. A group has to
+    // start at least one partition size into the impulse response, so
+    // each group is made long enough for the next one to fit.
+    int pos = BlockSize, size = BlockSize, max_reach = BlockSize;
+    while (pos < length)
+    {
+        int remaining = (length - pos + size - 1) / size;
+        int next = std::min<int>(size * 4, MaxPartSize);
+        int parts = remaining;
+        if (size < MaxPartSize)
+            parts = std::min(remaining, std::max(4, (next - pos + size - 1) / size));
+        stages.push_back(stage());
+        stage &s = stages.back();
+        s.size = size;
+        s.order = log2_of(2 * size);
+        s.offset = pos;
+        s.parts = parts;
+        s.ir.resize(parts * (size + 1));
+        s.fdl.resize(parts * (size + 1));
+        s.accum.resize(size + 1);
+        s.parts_per_block = (parts - 1 + size / BlockSize - 1) / (size / BlockSize);
+        frame.resize(2 * size);
+        for (int p = 0; p < parts; p++)
+        {
+            std::fill(frame.begin(), frame.end(), 0.f);
+            int start = pos + p * size;
+            int count = std::min(size, length - start);
+            std::copy(ir + start, ir + start + count, frame.begin());
+            transform.rfft(s.order, &frame[0], &s.ir[p * (size + 1)]);
+        }
+        max_reach = pos;
+        pos += parts * size;
+        size = next;
+    }
+
+    uint32_t input_size = 2 * BlockSize, output_size = BlockSize;
+    for (size_t i = 0; i < stages.size(); i++)
+        while (input_size < 2 * (uint32_t)stages[i].size)
+            input_size <<= 1;
+    while (output_size < (uint32_t)max_reach + BlockSize)
+        output_size <<= 1;
+    input.resize(input_size);
+    output.resize(output_size);
+    input_mask = input_size - 1;
+    output_mask = output_size - 1;
+    reset();
+}
+
+void convolver::reset()
+{
+    std::fill(recent.begin(), recent.end(), 0.f);
+    std::fill(input.begin(), input.end(), 0.f);
+    std::fill(output.begin(), output.end(), 0.f);
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        stage &s = stages[i];
+        std::fill(s.fdl.begin(), s.fdl.end(), complex());
+        std::fill(s.accum.begin(), s.accum.end(), complex());
+        s.fdl_pos = 0;
+        s.parts_done = 1;
+    }
+    time = 0;
+}
+
+void convolver::process(const float *in, float *out, uint32_t nsamples)
+{
+    uint32_t done = 0;
+    while (done < nsamples)
+    {
+        uint32_t pos = time & (BlockSize - 1);
+        uint32_t len = std::min<uint32_t>(nsamples - done, BlockSize - pos);
+        float *cur = &recent[BlockSize - 1 + pos];
+        for (uint32_t i = 0; i < len; i++)
+        {
+            cur[i] = in[done + i];
+            input[(time + i) & input_mask] = in[done + i];
+        }
+        // the head of the impulse response, applied directly
+        const float *h = &head[0];
+        for (uint32_t i = 0; i < len; i++)
+        {
+            const float *x = &recent[pos + i];
+            float sum = 0.f;
+            for (int k = 0; k < BlockSize; k++)
+                sum += h[k] * x[k];
+            float &tail = output[(time + i) & output_mask];
+            out[done + i] = sum + tail;
+            tail = 0.f;
+        }
+        time += len;
+        done += len;
+        if (!(time & (BlockSize - 1)))
+            end_of_block();
+    }
+}
+
+void convolver::add_products(stage &s, int first, int last)
+{
+    int bins = s.size + 1;
+    float *acc = (float *)&s.accum[0];
+    for (int p = first; p < last; p++)
+    {
+        // input block p blocks older than the one to come
+        int slot = s.fdl_pos - p;
+        if (slot < 0)
+            slot += s.parts;
+        const float *x = (const float *)&s.fdl[slot * bins];
+        const float *h = (const float *)&s.ir[p * bins];
+        for (int i = 0; i < 2 * bins; i += 2)
+        {
+            acc[i] += x[i] * h[i] - x[i + 1] * h[i + 1];
+            acc[i + 1] += x[i] * h[i + 1] + x[i + 1] * h[i];
+        }
+    }
+}
+
+void convolver::end_of_block()
+{
+    std::copy(recent.begin() + BlockSize, recent.end(), recent.begin());
+    for (size_t i = 0; i < stages.size(); i++)
+    {
+        stage &s = stages[i];
+        int last = std::min(s.parts_done + s.parts_per_block, s.parts);
+        add_products(s, s.parts_done, last);
+        s.parts_done = last;
+        if (time & (s.size - 1))
+            continue;
+        // a whole partition of input is there, transform the last two
+        // (overlap-save) and add the newest block's contribution
+        int N = s.size;
+        add_products(s, s.parts_done, s.parts);
+        for (int j = 0; j < 2 * N; j++)
+            frame[j] = input[(time - 2 * N + j) & input_mask];
+        transform.rfft(s.order, &frame[0], &s.fdl[s.fdl_pos * (N + 1)]);
+        add_products(s, 0, 1);
+        transform.irfft(s.order, &s.accum[0], &frame[0]);
+        // the second half is the convolution of the newest block with the
+        // stage's part of the impulse response, which starts at offset
+        uint32_t start = time - N + s.offset;
+        for (int j = 0; j < N; j++)
+            output[(start + j) & output_mask] += frame[N + j];
+        std::fill(s.accum.begin(), s.accum.end(), complex());
+        s.parts_done = 1;
+        if (++s.fdl_pos == s.parts)
+            s.fdl_pos = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
+namespace {
+
+inline uint32_t read_le(const unsigned char *p, int bytes)
+{
+    uint32_t value = 0;
+    for (int i = bytes - 1; i >= 0; i--)
+        value = (value << 8) | p[i];
+    return value;
+}
+
+}
+
+bool impulse_response::load(const char *path, string &error)
+{
+    FILE *f = fopen(path, "rb");
+    if (!f)
+    {
+        error = string("Cannot open ") + path;
+        return false;
+    }
+    vector<unsigned char> file;
+    unsigned char buf[65536];
+    size_t n;
+    while ((n = fread(buf, 1, sizeof(buf), f)) > 0)
+        file.insert(file.end(), buf, buf + n);
+    fclose(f);
+
+    if (file.size() < 12 || memcmp(&file[0], "RIFF", 4) || memcmp(&file[8], "WAVE", 4))
+    {
+        error = "Not a WAVE file";
+        return false;
+    }
+    int format = -1, nchannels = 0, bits = 0;
+    sample_rate = 0;
+    const unsigned char *data = NULL;
+    size_t data_size = 0;
+    size_t pos = 12;
+    while (pos + 8 <= file.size())
+    {
+        const unsigned char *chunk = &file[pos];
+        size_t size = read_le(chunk + 4, 4);
+        size_t avail = std::min(size, file.size() - pos - 8);
+        if (!memcmp(chunk, "fmt ", 4) && avail >= 16)
+        {
+            format = read_le(chunk + 8, 2);
+            nchannels = read_le(chunk + 10, 2);
+            sample_rate = read_le(chunk + 12, 4);
+            bits = read_le(chunk + 22, 2);
+            // WAVE_FORMAT_EXTENSIBLE, the real format is in the subformat GUID
+            if (format == 0xFFFE && avail >= 26)
+                format = read_le(chunk + 32, 2);
+        }
+        else if (!memcmp(chunk, "data", 4))
+        {
+            data = chunk + 8;
+            data_size = avail;
+        }
+        pos += 8 + size + (size & 1);
+    }
+    bool pcm = format == 1 && bits >= 8 && bits <= 32 && !(bits & 7);
+    bool ieee = format == 3 && (bits == 32 || bits == 64);
+    if (!data || !nchannels || sample_rate <= 0 || !(pcm || ieee))
+    {
+        error = "Unsupported WAVE format (PCM or floating point expected)";
+        return false;
+    }
+
+    int bytes = bits / 8;
+    size_t frames = data_size / (bytes * nchannels);
+    channels.assign(nchannels, vector<float>(frames));
+    for (size_t i = 0; i < frames; i++)
+    {
+        for (int c = 0; c < nchannels; c++)
+        {
+            const unsigned char *p = data + (i * nchannels + c) * bytes;
+            float value;
+            if (ieee && bits == 32)
+            {
+                uint32_t v = read_le(p, 4);
+                memcpy(&value, &v, 4);
+            }
+            else if (ieee)
+            {
+                uint64_t v = read_le(p, 4) | ((uint64_t)read_le(p + 4, 4) << 32);
+                double d;
+                memcpy(&d, &v, 8);
+                value = d;
+            }
+            else if (bits == 8)
+                value = (p[0] - 128) * (1.0f / 128);
+            else
+            {
+                // sign extend from the top byte
+                int32_t v = (int32_t)(read_le(p, bytes) << (32 - bits));
+                value = v * (1.0f / 2147483648.0f);
+            }
+            channels[c][i] = value;
+        }
+    }
+    return true;
+}
+
+void impulse_response::resample(int new_rate)
+{
+    if (new_rate == sample_rate || channels.empty())
+        return;
+    // windowed sinc interpolation, with the cutoff lowered to the new
+    // Nyquist frequency when downsampling
+    const int zero_crossings = 16;
+    double ratio = (double)new_rate / sample_rate;
+    double cutoff = std::min(1.0, ratio);
+    double half_width = zero_crossings / cutoff;
+    size_t old_length = channels[0].size();
+    size_t new_length = (size_t)(old_length * ratio);
+    for (size_t c = 0; c < channels.size(); c++)
+    {
+        const vector<float> &src = channels[c];
+        vector<float> dest(new_length);
+        for (size_t n = 0; n < new_length; n++)
+        {
+            double t = n / ratio;
+            int first = std::max(0, (int)ceil(t - half_width));
+            int last = std::min((int)old_length - 1, (int)floor(t + half_width));
+            double sum = 0;
+            for (int k = first; k <= last; k++)
+            {
+                double x = (t - k) * cutoff;
+                double sinc = fabs(x) < 1e-9 ? 1.0 : sin(M_PI * x) / (M_PI * x);
+                double window = 0.5 + 0.5 * cos(M_PI * x / zero_crossings);
+                sum += src[k] * sinc * window;
+            }
+            dest[n] = sum * cutoff;
+        }
+        channels[c].swap(dest);
+    }
+    sample_rate = new_rate;
+}
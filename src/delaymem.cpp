@@ -0,0 +1,163 @@
+/* Calf DSP Library
+ * Delay line memory
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+#include <config.h>
+#include <calf/delaymem.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <map>
+#include <new>
+
+using namespace std;
+using namespace dsp;
+
+namespace {
+
+enum { huge_page_size = 2 << 20, max_free_blocks = 32 };
+
+/// Anonymous mappings no longer used by any delay line, by size. Their
+/// pages have been returned to the system, only the address space is kept.
+class delay_arena
+{
+    pthread_mutex_t mutex;
+    multimap<size_t, void *> free_blocks;
+    bool lazy;
+public:
+    delay_arena()
+    {
+        pthread_mutex_init(&mutex, NULL);
+        const char *env = getenv("CALF_DELAY_LAZY_COMMIT");
+        lazy = env && atoi(env) > 0;
+    }
+    bool is_lazy() const { return lazy; }
+    /// Round the request up to whole pages (or huge pages for large blocks)
+    static size_t block_size(size_t bytes)
+    {
+        size_t page = bytes >= (size_t)huge_page_size ? (size_t)huge_page_size : (size_t)sysconf(_SC_PAGESIZE);
+        return (bytes + page - 1) & ~(page - 1);
+    }
+    void *alloc(size_t size)
+    {
+        void *ptr = NULL;
+        pthread_mutex_lock(&mutex);
+        multimap<size_t, void *>::iterator i = free_blocks.find(size);
+        if (i != free_blocks.end()) {
+            ptr = i->second;
+            free_blocks.erase(i);
+        }
+        pthread_mutex_unlock(&mutex);
+        if (!ptr)
+            ptr = map(size);
+        if (!lazy)
+            memset(ptr, 0, size);
+        return ptr;
+    }
+    void free(void *ptr, size_t size)
+    {
+        madvise(ptr, size, MADV_DONTNEED);
+        pthread_mutex_lock(&mutex);
+        bool keep = free_blocks.size() < max_free_blocks;
+        if (keep)
+            free_blocks.insert(make_pair(size, ptr));
+        pthread_mutex_unlock(&mutex);
+        if (!keep)
+            munmap(ptr, size);
+    }
+    static void *map(size_t size)
+    {
+        if (size < huge_page_size) {
+            void *ptr = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (ptr == MAP_FAILED)
+                throw bad_alloc();
+            return ptr;
+        }
+        // map a bit more and cut it down to a huge page boundary
+        size_t len = size + huge_page_size;
+        char *base = (char *)mmap(NULL, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+        if (base == MAP_FAILED)
+            throw bad_alloc();
+        char *ptr = (char *)(((uintptr_t)base + huge_page_size - 1) & ~(uintptr_t)(huge_page_size - 1));
+        if (ptr > base)
+            munmap(base, ptr - base);
+        if (base + len > ptr + size)
+            munmap(ptr + size, base + len - (ptr + size));
+#ifdef MADV_HUGEPAGE
+        madvise(ptr, size, MADV_HUGEPAGE);
+#endif
+        return ptr;
+    }
+};
+
+/// Never destroyed, plugin instances may outlive static destructors
+delay_arena &get_arena()
+{
+    static delay_arena *arena = new delay_arena;
+    return *arena;
+}
+
+}
+
+void delay_memory::alloc(uint32_t min_size, bool pow2)
+{
+    uint32_t new_size = min_size ? min_size : 1;
+    if (pow2) {
+        new_size = 1;
+        while (new_size < min_size)
+            new_size <<= 1;
+    }
+    size_t new_mapped = delay_arena::block_size(new_size * sizeof(float));
+    if (data && new_mapped == mapped) {
+        size = new_size;
+        clear();
+        return;
+    }
+    free();
+    data = (float *)get_arena().alloc(new_mapped);
+    size = new_size;
+    mapped = new_mapped;
+}
+
+void delay_memory::free()
+{
+    if (!data)
+        return;
+    get_arena().free(data, mapped);
+    data = NULL;
+    size = 0;
+    mapped = 0;
+}
+
+void delay_memory::clear()
+{
+    if (!data)
+        return;
+    if (get_arena().is_lazy())
+        madvise(data, mapped, MADV_DONTNEED);
+    else
+        memset(data, 0, mapped);
+}
+
+bool delay_memory::lazy_commit()
+{
+    return get_arena().is_lazy();
+}
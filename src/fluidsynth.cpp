@@ -22,6 +22,7 @@
 #include <calf/modules_dev.h>
 #include <calf/utils.h>
 #include <string.h>
+#include <unistd.h>
 
 #if ENABLE_EXPERIMENTAL
 
@@ -34,6 +35,8 @@ fluidsynth_audio_module::fluidsynth_audio_module()
     settings = NULL;
     synth = NULL;
     status_serial = 1;
+    soundfont_serial = loaded_serial = 0;
+    loader.owner = this;
     std::fill(set_presets, set_presets + 16, -1);
     std::fill(last_selected_presets, last_selected_presets + 16, -1);
 }
@@ -42,8 +45,14 @@ void fluidsynth_audio_module::post_instantiate(uint32_t sr)
 {
     srate = sr;
     settings = new_fluid_settings();
-    synth = create_synth(sfid);
+    create_synth(soundfont, loader);
+    synth = loader.synth;
+    sfid = loader.sfid;
+    loader.synth = NULL;
     soundfont_loaded = sfid != -1;
+    soundfont_name.swap(loader.soundfont_name);
+    soundfont_preset_list.swap(loader.preset_list);
+    sf_preset_names.swap(loader.preset_names);
 }
 
 void fluidsynth_audio_module::activate()
@@ -54,27 +63,31 @@ void fluidsynth_audio_module::deactivate()
 {
 }
 
-fluid_synth_t *fluidsynth_audio_module::create_synth(int &new_sfid)
+void fluidsynth_audio_module::create_synth(const std::string &file, load_job &result)
 {
-    std::fill(set_presets, set_presets + 16, -1);
+    result.synth = NULL;
+    result.sfid = -1;
+    result.soundfont_name.clear();
+    result.preset_list.clear();
+    result.preset_names.clear();
     fluid_settings_t *new_settings = new_fluid_settings();
     fluid_settings_setnum(new_settings, "synth.sample-rate", srate);
     fluid_synth_t *s = new_fluid_synth(new_settings);
-    if (!soundfont.empty())
+    if (!file.empty())
     {
-        int sid = fluid_synth_sfload(s, soundfont.c_str(), 1);
+        int sid = fluid_synth_sfload(s, file.c_str(), 1);
         if (sid == -1)
         {
             delete_fluid_synth(s);
-            return NULL;
+            return;
         }
         assert(sid >= 0);
         printf("sid=%d\n", sid);
         fluid_synth_sfont_select(s, 0, sid);
-        new_sfid = sid;
+        result.sfid = sid;
 
         fluid_sfont_t* sfont = fluid_synth_get_sfont(s, 0);
-        soundfont_name = (*sfont->get_name)(sfont);
+        result.soundfont_name = (*sfont->get_name)(sfont);
 
         sfont->iteration_start(sfont);
         
@@ -87,7 +100,7 @@ fluid_synth_t *fluidsynth_audio_module::create_synth(int &new_sfid)
             int bank = tmp.get_banknum(&tmp);
             int num = tmp.get_num(&tmp);
             int id = num + 128 * bank;
-            sf_preset_names[id] = pname;
+            result.preset_names[id] = pname;
             preset_list += calf_utils::i2s(id) + "\t" + pname + "\n";
             if (first_preset == -1)
                 first_preset = id;
@@ -97,11 +110,56 @@ fluid_synth_t *fluidsynth_audio_module::create_synth(int &new_sfid)
             fluid_synth_bank_select(s, 0, first_preset >> 7);
             fluid_synth_program_change(s, 0, first_preset & 127);        
         }
-        soundfont_preset_list = preset_list;
+        result.preset_list = preset_list;
     }
-    else
-        new_sfid = -1;
-    return s;
+    result.synth = s;
+}
+
+void fluidsynth_audio_module::load_job::work()
+{
+    std::string file;
+    {
+        calf_utils::ptlock lock(owner->mutex);
+        file = owner->soundfont;
+    }
+    owner->create_synth(file, *this);
+    if (!synth)
+        fprintf(stderr, "Cannot load soundfont %s\n", file.c_str());
+}
+
+void fluidsynth_audio_module::load_job::apply()
+{
+    // a soundfont that could not be loaded leaves the current synth in place
+    if (!synth)
+        return;
+    std::swap(synth, owner->synth);
+    owner->sfid = sfid;
+    owner->soundfont_loaded = sfid != -1;
+    std::fill(owner->set_presets, owner->set_presets + 16, -1);
+    for (int i = 0; i < 16; ++i)
+        owner->update_preset_num(i);
+    applied = true;
+}
+
+void fluidsynth_audio_module::load_job::cleanup()
+{
+    if (applied)
+    {
+        calf_utils::ptlock lock(owner->mutex);
+        owner->soundfont_name.swap(soundfont_name);
+        owner->soundfont_preset_list.swap(preset_list);
+        owner->sf_preset_names.swap(preset_names);
+        owner->status_serial++;
+        applied = false;
+    }
+    if (synth)
+    {
+        delete_fluid_synth(synth);
+        synth = NULL;
+    }
+    soundfont_name.clear();
+    preset_list.clear();
+    preset_names.clear();
 }
 
 void fluidsynth_audio_module::note_on(int channel, int note, int vel)
@@ -150,6 +208,9 @@ void fluidsynth_audio_module::select_preset_in_channel(int channel, int new_pres
 uint32_t fluidsynth_audio_module::process(uint32_t offset, uint32_t nsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     static const int interp_lens[] = { 0, 1, 4, 7 };
+    int serial = soundfont_serial;
+    if (serial != loaded_serial && schedule_work(&loader))
+        loaded_serial = serial;
     for (int i = 0; i < 16; ++i)
     {
         int new_preset = set_presets[i];
@@ -186,42 +247,35 @@ char *fluidsynth_audio_module::configure(const char *key, const char *value)
     }
     if (!strcmp(key, "soundfont"))
     {
-        if (value && *value)
-        {
-            printf("Loading %s\n", value);
-            soundfont = value;
-        }
-        else
-        {
-            printf("Creating a blank synth\n");
-            soundfont.clear();
-        }
-        // First synth not yet created - defer creation up to post_instantiate
-        if (!synth)
-            return NULL;
-        int newsfid = -1;
-        fluid_synth_t *new_synth = create_synth(newsfid);
-        soundfont_loaded = newsfid != -1;
-
-        status_serial++;
-        
-        if (new_synth)
+        if (value && *value && access(value, R_OK))
+            return strdup("Cannot load a soundfont");
         {
-            synth = new_synth;
-            sfid = newsfid;
-            for (int i = 0; i < 16; ++i)
-                update_preset_num(i);
+            calf_utils::ptlock lock(mutex);
+            if (value && *value)
+            {
+                printf("Loading %s\n", value);
+                soundfont = value;
+            }
+            else
+            {
+                printf("Creating a blank synth\n");
+                soundfont.clear();
+            }
         }
-        else
-            return strdup("Cannot load a soundfont");
-        // XXXKF memory leak
+        // First synth not yet created - defer creation up to post_instantiate,
+        // otherwise the next process() call has the synth built by the load job
+        if (synth)
+            __atomic_add_fetch(&soundfont_serial, 1, __ATOMIC_RELEASE);
     }
     return NULL;
 }
 
 void fluidsynth_audio_module::send_configures(send_configure_iface *sci)
 {
-    sci->send_configure("soundfont", soundfont.c_str());
+    {
+        calf_utils::ptlock lock(mutex);
+        sci->send_configure("soundfont", soundfont.c_str());
+    }
     sci->send_configure("preset_key_set", calf_utils::i2s(last_selected_presets[0]).c_str());
     for (int i = 1; i < 16; ++i)
     {
@@ -235,6 +289,7 @@ int fluidsynth_audio_module::send_status_updates(send_updates_iface *sui, int la
     int cur_serial = status_serial;
     if (cur_serial != last_serial)
     {
+        calf_utils::ptlock lock(mutex);
         sui->send_status("sf_name", soundfont_name.c_str());
         sui->send_status("preset_list", soundfont_preset_list.c_str());
         for (int i = 0; i < 16; ++i)
@@ -31,7 +31,7 @@ using namespace calf_plugins;
 
 static const char automation_key_prefix[] = "automation_v1_";
 
-void automation_range::send_configure(const plugin_metadata_iface *metadata, uint32_t from_controller, send_configure_iface *sci)
+void automation_range::send_configure(const plugin_metadata_iface *metadata, uint32_t from_controller, send_configure_iface *sci) const
 {
     std::stringstream ss1, ss2;
     ss1 << automation_key_prefix << from_controller << "_to_" << metadata->get_param_props(param_no)->short_name;
@@ -0,0 +1,335 @@
+/* Calf DSP Library Utility Application - calfjackhost
+ * Parallel scheduler for the plugin graph
+ *
+ * Copyright (C) 2007-2011 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation; either version 2, or (at your option)
+ * any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA
+ * 02110-1301, USA.
+ */
+
+#include <assert.h>
+#include <errno.h>
+#include <sched.h>
+#include <stdio.h>
+#include <unistd.h>
+#include <algorithm>
+#include <set>
+#include <jack/thread.h>
+#include <calf/graph_scheduler.h>
+
+using namespace std;
+using namespace calf_plugins;
+
+/// Spins before a thread without work gives up its core to others
+static const int max_idle_spins = 64;
+
+static inline void spin_pause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void work_stealing_queue::init(int capacity)
+{
+    int size = 1;
+    while(size < capacity)
+        size <<= 1;
+    items.resize(size);
+    mask = size - 1;
+    top = bottom = 0;
+}
+
+void work_stealing_queue::push(int item)
+{
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED);
+    __atomic_store_n(&items[b & mask], item, __ATOMIC_RELAXED);
+    __atomic_store_n(&bottom, b + 1, __ATOMIC_RELEASE);
+}
+
+bool work_stealing_queue::pop(int &item)
+{
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_RELAXED) - 1;
+    __atomic_store_n(&bottom, b, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t t = __atomic_load_n(&top, __ATOMIC_RELAXED);
+    if (t > b)
+    {
+        // empty
+        __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+        return false;
+    }
+    item = __atomic_load_n(&items[b & mask], __ATOMIC_RELAXED);
+    if (t < b)
+        return true;
+    // last item - race against the thieves
+    bool ok = __atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+    __atomic_store_n(&bottom, b + 1, __ATOMIC_RELAXED);
+    return ok;
+}
+
+bool work_stealing_queue::steal(int &item)
+{
+    int64_t t = __atomic_load_n(&top, __ATOMIC_ACQUIRE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    int64_t b = __atomic_load_n(&bottom, __ATOMIC_ACQUIRE);
+    if (t >= b)
+        return false;
+    item = __atomic_load_n(&items[t & mask], __ATOMIC_RELAXED);
+    return __atomic_compare_exchange_n(&top, &t, t + 1, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED);
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+graph_scheduler::graph_scheduler()
+{
+    graph = NULL;
+    cycle_func = NULL;
+    cycle_arg = NULL;
+    remaining = 0;
+    running = 0;
+    active = 0;
+    quit = false;
+}
+
+graph_scheduler::~graph_scheduler()
+{
+    stop();
+    delete graph;
+}
+
+void graph_scheduler::start(jack_client_t *client, int thread_count)
+{
+    assert(workers.empty());
+    int cpus = sysconf(_SC_NPROCESSORS_ONLN);
+    if (cpus < 1)
+        cpus = 1;
+    if (thread_count <= 0 || thread_count > cpus)
+        thread_count = cpus;
+    int priority = jack_client_real_time_priority(client);
+    quit = false;
+    for (int i = 1; i < thread_count; i++)
+    {
+        worker *w = new worker;
+        w->owner = this;
+        w->index = i;
+        sem_init(&w->wakeup, 0, 0);
+        if (jack_client_create_thread(client, &w->thread, priority, priority >= 0, worker_thread, w))
+        {
+            fprintf(stderr, "Could not create worker thread %d, using %d threads\n", i, i);
+            sem_destroy(&w->wakeup);
+            delete w;
+            break;
+        }
+#ifdef CPU_SET
+        // keep the worker on one core, so that its caches stay warm
+        cpu_set_t cpuset;
+        CPU_ZERO(&cpuset);
+        CPU_SET(i % cpus, &cpuset);
+        pthread_setaffinity_np(w->thread, sizeof(cpuset), &cpuset);
+#endif
+        workers.push_back(w);
+    }
+}
+
+void graph_scheduler::stop()
+{
+    quit = true;
+    for (size_t i = 0; i < workers.size(); i++)
+        sem_post(&workers[i]->wakeup);
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        pthread_join(workers[i]->thread, NULL);
+        sem_destroy(&workers[i]->wakeup);
+        delete workers[i];
+    }
+    workers.clear();
+}
+
+schedule_graph *graph_scheduler::create_graph(const std::vector<jack_host *> &plugins, const std::multimap<int, int> &run_before) const
+{
+    int count = plugins.size();
+    schedule_graph *g = new schedule_graph;
+    g->nodes.resize(count);
+    vector<set<int> > deps(count);
+    for (multimap<int, int>::const_iterator i = run_before.begin(); i != run_before.end(); ++i)
+    {
+        if (i->first != i->second)
+            deps[i->first].insert(i->second);
+    }
+    vector<int> indegree(count);
+    for (int i = 0; i < count; i++)
+    {
+        g->nodes[i].plugin = plugins[i];
+        indegree[i] = deps[i].size();
+        for (set<int>::const_iterator j = deps[i].begin(); j != deps[i].end(); ++j)
+            g->nodes[*j].successors.push_back(i);
+    }
+
+    // Topological sort, used only to find and break feedback loops: when no
+    // node is ready, the first remaining plugin loses its unresolved inputs
+    // (and gets the previous cycle's data there, like in serial mode)
+    vector<bool> done(count);
+    set<int> ready;
+    for (int i = 0; i < count; i++)
+        if (!indegree[i])
+            ready.insert(i);
+    for (int processed = 0; processed < count; processed++)
+    {
+        if (ready.empty())
+        {
+            int first = find(done.begin(), done.end(), false) - done.begin();
+            for (set<int>::const_iterator j = deps[first].begin(); j != deps[first].end(); ++j)
+            {
+                if (done[*j])
+                    continue;
+                vector<int> &succ = g->nodes[*j].successors;
+                succ.erase(remove(succ.begin(), succ.end(), first), succ.end());
+            }
+            indegree[first] = 0;
+            ready.insert(first);
+        }
+        int item = *ready.begin();
+        ready.erase(ready.begin());
+        done[item] = true;
+        const vector<int> &succ = g->nodes[item].successors;
+        for (size_t j = 0; j < succ.size(); j++)
+            if (!--indegree[succ[j]])
+                ready.insert(succ[j]);
+    }
+
+    for (int i = 0; i < count; i++)
+        g->nodes[i].dependency_count = g->nodes[i].pending = 0;
+    for (int i = 0; i < count; i++)
+    {
+        const vector<int> &succ = g->nodes[i].successors;
+        for (size_t j = 0; j < succ.size(); j++)
+            g->nodes[succ[j]].dependency_count++;
+    }
+    for (int i = 0; i < count; i++)
+        if (!g->nodes[i].dependency_count)
+            g->roots.push_back(i);
+
+    g->queues.resize(get_thread_count());
+    for (size_t i = 0; i < g->queues.size(); i++)
+        g->queues[i].init(count);
+    return g;
+}
+
+schedule_graph *graph_scheduler::swap_graph(schedule_graph *new_graph)
+{
+    // workers only look at the graph while running is set, and run() waits
+    // for all of them to leave before returning
+    assert(!running);
+    schedule_graph *old = graph;
+    graph = new_graph;
+    return old;
+}
+
+void graph_scheduler::run(process_func func, void *arg)
+{
+    schedule_graph *g = graph;
+    if (!g || g->nodes.empty())
+        return;
+    int nq = g->queues.size();
+    if (workers.empty() || nq != get_thread_count())
+    {
+        for (size_t i = 0; i < g->nodes.size(); i++)
+            func(arg, g->nodes[i].plugin);
+        return;
+    }
+    for (size_t i = 0; i < g->nodes.size(); i++)
+        g->nodes[i].pending = g->nodes[i].dependency_count;
+    for (int i = g->roots.size() - 1; i >= 0; i--)
+        g->queues[0].push(g->roots[i]);
+    cycle_func = func;
+    cycle_arg = arg;
+    __atomic_store_n(&remaining, (int)g->nodes.size(), __ATOMIC_SEQ_CST);
+    __atomic_store_n(&running, 1, __ATOMIC_SEQ_CST);
+    for (size_t i = 0; i < workers.size(); i++)
+        sem_post(&workers[i]->wakeup);
+
+    work(0);
+
+    __atomic_store_n(&running, 0, __ATOMIC_SEQ_CST);
+    for (int idle = 0; __atomic_load_n(&active, __ATOMIC_SEQ_CST); idle++)
+    {
+        if (idle < max_idle_spins)
+            spin_pause();
+        else
+            sched_yield();
+    }
+}
+
+void graph_scheduler::work(int thread)
+{
+    schedule_graph *g = graph;
+    int nq = g->queues.size();
+    work_stealing_queue &own = g->queues[thread];
+    int idle = 0;
+    while(__atomic_load_n(&remaining, __ATOMIC_ACQUIRE) > 0)
+    {
+        int item;
+        if (!own.pop(item))
+        {
+            bool found = false;
+            for (int i = 1; i < nq && !found; i++)
+                found = g->queues[(thread + i) % nq].steal(item);
+            if (!found)
+            {
+                // the threads share the JACK priority, so a waiting thread that
+                // keeps its core would starve any other thread placed on it
+                // (including the JACK thread itself) until the cycle ends
+                if (++idle < max_idle_spins)
+                    spin_pause();
+                else
+                    sched_yield();
+                continue;
+            }
+        }
+        idle = 0;
+        schedule_graph::node &n = g->nodes[item];
+        cycle_func(cycle_arg, n.plugin);
+        for (size_t i = 0; i < n.successors.size(); i++)
+        {
+            int s = n.successors[i];
+            if (!__atomic_sub_fetch(&g->nodes[s].pending, 1, __ATOMIC_ACQ_REL))
+                own.push(s);
+        }
+        __atomic_sub_fetch(&remaining, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void *graph_scheduler::worker_thread(void *arg)
+{
+    worker *w = (worker *)arg;
+    graph_scheduler *self = w->owner;
+    while(true)
+    {
+        while(sem_wait(&w->wakeup) && errno == EINTR)
+            ;
+        if (self->quit)
+            break;
+        // a worker woken too late for its cycle must not touch the graph,
+        // which may have been replaced in the meantime
+        __atomic_add_fetch(&self->active, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&self->running, __ATOMIC_SEQ_CST))
+            self->work(w->index);
+        __atomic_sub_fetch(&self->active, 1, __ATOMIC_SEQ_CST);
+    }
+    return NULL;
+}
@@ -883,6 +883,12 @@ gboolean gtk_main_window::on_idle(void *data)
     if (!self->refresh_controller.check_redraw(GTK_WIDGET(self->toplevel)))
         return TRUE;
 
+    // processing times are averaged anyway, refreshing them once a second is plenty
+    static int timing_counter = 0;
+    bool update_timing = ++timing_counter >= 30;
+    if (update_timing)
+        timing_counter = 0;
+
     for (std::map<plugin_ctl_iface *, plugin_strip *>::iterator i = self->plugins.begin(); i != self->plugins.end(); ++i)
     {
         if (i->second)
@@ -907,6 +913,11 @@ gboolean gtk_main_window::on_idle(void *data)
             if (plugin->get_metadata_iface()->get_midi()) {
                 calf_led_set_value (CALF_LED (strip->midi_in), plugin->get_level(idx++));
             }
+            if (update_timing && strip->plugin) {
+                char buf[64];
+                snprintf(buf, sizeof(buf), "DSP time: %0.1f us", strip->plugin->get_process_time());
+                gtk_widget_set_tooltip_text(strip->name, buf);
+            }
         }
     }
     return TRUE;
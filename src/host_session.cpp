@@ -25,6 +25,7 @@
 #include <calf/preset.h>
 #include <getopt.h>
 #include <sys/stat.h>
+#include <algorithm>
 
 using namespace std;
 using namespace calf_utils;
@@ -46,6 +47,7 @@ host_session::host_session(session_environment_iface *se)
     save_file_on_next_idle_call = false;
     quit_on_next_idle_call = 0;
     handle_event_on_next_idle_call = NULL;
+    thread_count = 1;
 
     main_win = session_env->create_main_window();
     main_win->set_owner(this);
@@ -130,6 +132,8 @@ void host_session::open()
     
     client.open(client_name.c_str(), !jack_session_id.empty() ? jack_session_id.c_str() : NULL);
     jack_set_session_callback(client.client, session_callback, this);
+    if (thread_count != 1)
+        client.start_scheduler(thread_count);
     main_win->add_condition("jackhost");
     main_win->add_condition("directlink");
     main_win->add_condition("configure");
@@ -234,6 +238,45 @@ void host_session::remove_all_plugins()
     instances.clear();
 }
 
+void host_session::apply_links(int plugin_no, const std::vector<preset_list::input_link> &links)
+{
+    jack_host *to = plugins[plugin_no];
+    for (unsigned int i = 0; i < links.size(); i++)
+    {
+        const preset_list::input_link &link = links[i];
+        if (link.plugin < 0 || link.plugin >= (int)plugins.size() || link.output < 0 || link.output >= plugins[link.plugin]->out_count
+            || link.input < 0 || link.input >= to->in_count)
+        {
+            fprintf(stderr, "Cannot link input %d of plugin %s - no such port\n", link.input + 1, to->instance_name.c_str());
+            continue;
+        }
+        try {
+            client.link(plugins[link.plugin], link.output, to, link.input);
+        }
+        catch(text_exception &e)
+        {
+            fprintf(stderr, "%s\n", e.what());
+        }
+    }
+}
+
+void host_session::get_links(int plugin_no, std::vector<preset_list::input_link> &links)
+{
+    links.clear();
+    jack_host *to = plugins[plugin_no];
+    for (int i = 0; i < to->in_count; i++)
+    {
+        jack_host::port *src = to->get_inputs()[i].source;
+        if (!src)
+            continue;
+        preset_list::input_link link;
+        link.input = i;
+        link.plugin = std::find(plugins.begin(), plugins.end(), src->owner) - plugins.begin();
+        link.output = src - src->owner->get_outputs();
+        links.push_back(link);
+    }
+}
+
 bool host_session::activate_preset(int plugin_no, const std::string &preset, bool builtin)
 {
     string cur_plugin = plugins[plugin_no]->metadata->get_id();
@@ -277,8 +320,9 @@ void host_session::connect()
                         fprintf(stderr, "Cannot connect plugins %s and %s - incompatible ports\n", plugins[i - 1]->name.c_str(), plugins[i]->name.c_str());
                     }
                     else {
-                        client.connect(cnp + plugins[i - 1]->get_outputs()[0].name, cnp + plugins[i]->get_inputs()[0].name);
-                        client.connect(cnp + plugins[i - 1]->get_outputs()[1].name, cnp + plugins[i]->get_inputs()[1].name);
+                        // plugins inside the chain are linked directly, only its ends are JACK ports
+                        client.link(plugins[i - 1], 0, plugins[i], 0);
+                        client.link(plugins[i - 1], 1, plugins[i], 1);
                     }
                 }
             }
@@ -392,6 +436,9 @@ char *host_session::open_file(const char *name)
                 main_win->refresh_plugin(plugins[i]);
             }
         }
+        // the plugins feeding the links may come later in the file
+        for (unsigned int i = 0; i < pl.plugins.size() && i < plugins.size(); i++)
+            apply_links(i, pl.plugins[i].links);
     }
     catch(preset_exception &e)
     {
@@ -451,6 +498,14 @@ char *host_session::save_file(const char *name)
         data << preset.to_xml();
         gather_automation_params gap(data);
         p->send_automation_configures(&gap);
+        vector<preset_list::input_link> links;
+        get_links(i, links);
+        for (unsigned int j = 0; j < links.size(); j++)
+        {
+            data << "<link" << to_xml_attr("input", i2s(links[j].input));
+            data << to_xml_attr("plugin", i2s(links[j].plugin));
+            data << to_xml_attr("output", i2s(links[j].output)) << " />" << endl;
+        }
         data << "</plugin>" << endl;
     }
     data << "</rack>" << endl;
@@ -474,6 +529,7 @@ void host_session::load(session_load_iface *stream)
     // printf("!!!Restore data set!!!\n");
     remove_all_plugins();
     string key, data;
+    map<int, vector<preset_list::input_link> > links;
     while(stream->get_next_item(key, data)) {
         if (key == "global")
         {
@@ -506,9 +562,27 @@ void host_session::load(session_load_iface *stream)
                 main_win->refresh_plugin(plugins[nplugin]);
                 for(dictionary::const_iterator i = automation.begin(); i != automation.end(); ++i)
                     plugins[nplugin]->configure(i->first.c_str(), i->second.c_str());
+                if (dict.count("links"))
+                {
+                    // input -> plugin:output
+                    dictionary ldict;
+                    decode_map(ldict, dict["links"]);
+                    for(dictionary::const_iterator i = ldict.begin(); i != ldict.end(); ++i)
+                    {
+                        preset_list::input_link link;
+                        link.input = atoi(i->first.c_str());
+                        if (sscanf(i->second.c_str(), "%d:%d", &link.plugin, &link.output) == 2)
+                            links[nplugin].push_back(link);
+                    }
+                }
             }
         }
     }
+    for (map<int, vector<preset_list::input_link> >::const_iterator i = links.begin(); i != links.end(); ++i)
+    {
+        if (i->first < (int)plugins.size())
+            apply_links(i->first, i->second);
+    }
 }
 
 void host_session::save(session_save_iface *stream)
@@ -545,6 +619,15 @@ void host_session::save(session_save_iface *stream)
         gather_automation_params gap(automation);
         p->send_automation_configures(&gap);
         tmp["automation"] = encode_map(automation);
+        vector<preset_list::input_link> links;
+        get_links(i, links);
+        if (!links.empty())
+        {
+            dictionary ldict;
+            for (unsigned int j = 0; j < links.size(); j++)
+                ldict[i2s(links[j].input)] = i2s(links[j].plugin) + ":" + i2s(links[j].output);
+            tmp["links"] = encode_map(ldict);
+        }
 
         pstr = encode_map(tmp);
         stream->write_next_item(ss, pstr);
@@ -567,6 +650,9 @@ void host_session::signal_handler(int signum)
 
 void host_session::on_idle()
 {
+    client.check_schedule();
+    client.check_latency();
+
     if (save_file_on_next_idle_call)
     {
         save_file_on_next_idle_call = false;
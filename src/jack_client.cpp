@@ -24,12 +24,181 @@
 #include <jack/midiport.h>
 #include <calf/giface.h>
 #include <calf/jackhost.h>
+#include <algorithm>
 #include <set>
 
 using namespace std;
 using namespace calf_utils;
 using namespace calf_plugins;
 
+bool job_queue::ring::is_full() const
+{
+    return head - __atomic_load_n(&tail, __ATOMIC_ACQUIRE) == ring_size;
+}
+
+bool job_queue::ring::push(work_job *job)
+{
+    if (is_full())
+        return false;
+    items[head % ring_size] = job;
+    __atomic_store_n(&head, head + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+bool job_queue::ring::pop(work_job *&job)
+{
+    if (__atomic_load_n(&head, __ATOMIC_ACQUIRE) == tail)
+        return false;
+    job = items[tail % ring_size];
+    __atomic_store_n(&tail, tail + 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+job_queue::~job_queue()
+{
+    owner->remove_queue(this);
+    // nothing is processed any more, finish what is left here
+    work_job *job;
+    while (from_worker.pop(job))
+        job->set_state(work_job::JOB_IDLE);
+    while (to_worker.pop(job))
+    {
+        if (job->state == work_job::JOB_APPLIED)
+            job->cleanup();
+        job->set_state(work_job::JOB_IDLE);
+    }
+}
+
+bool job_queue::schedule_work(work_job *job)
+{
+    job->set_state(work_job::JOB_QUEUED);
+    if (!to_worker.push(job))
+    {
+        job->set_state(work_job::JOB_IDLE);
+        return false;
+    }
+    owner->notify();
+    return true;
+}
+
+void job_queue::apply_finished()
+{
+    bool queued = false;
+    work_job *job;
+    // leave the finished jobs alone if there is no room to send them back
+    while (!to_worker.is_full() && from_worker.pop(job))
+    {
+        job->apply();
+        job->set_state(work_job::JOB_APPLIED);
+        to_worker.push(job);
+        queued = true;
+    }
+    if (queued)
+        owner->notify();
+}
+
+void job_queue::run_queued()
+{
+    work_job *job;
+    while (to_worker.pop(job))
+    {
+        if (job->state == work_job::JOB_QUEUED)
+        {
+            job->work();
+            // each job is in one of the rings at most, so this only fails
+            // if a module has more than ring_size jobs - drop the result then
+            if (!from_worker.push(job))
+                job->set_state(work_job::JOB_IDLE);
+        }
+        else
+        {
+            job->cleanup();
+            job->set_state(work_job::JOB_IDLE);
+        }
+    }
+}
+
+job_thread::job_thread()
+{
+    sem_init(&wakeup, 0, 0);
+    running = false;
+    quit = false;
+}
+
+job_thread::~job_thread()
+{
+    stop();
+    sem_destroy(&wakeup);
+}
+
+void job_thread::start()
+{
+    assert(!running);
+    quit = false;
+    if (pthread_create(&thread, NULL, thread_func, this))
+        throw calf_utils::text_exception("Could not create the worker thread");
+    running = true;
+}
+
+void job_thread::stop()
+{
+    if (!running)
+        return;
+    quit = true;
+    sem_post(&wakeup);
+    pthread_join(thread, NULL);
+    running = false;
+}
+
+void *job_thread::thread_func(void *arg)
+{
+    job_thread *self = (job_thread *)arg;
+    while(true)
+    {
+        sem_wait(&self->wakeup);
+        if (self->quit)
+            break;
+        // the lock is only contended by adding and removing plugins
+        ptlock lock(self->mutex);
+        for (size_t i = 0; i < self->queues.size(); i++)
+            self->queues[i]->run_queued();
+    }
+    return NULL;
+}
+
+job_queue *job_thread::create_queue()
+{
+    job_queue *queue = new job_queue(this);
+    ptlock lock(mutex);
+    queues.push_back(queue);
+    return queue;
+}
+
+void job_thread::remove_queue(job_queue *queue)
+{
+    ptlock lock(mutex);
+    queues.erase(std::remove(queues.begin(), queues.end(), queue), queues.end());
+}
+
+////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
+
+void compensation_delay::process(float *data, uint32_t len)
+{
+    uint32_t size = buffer.size();
+    if (!size)
+        return;
+    for (uint32_t i = 0; i < len; i++)
+    {
+        float sample = buffer[pos];
+        buffer[pos] = data[i];
+        data[i] = sample;
+        if (++pos == size)
+            pos = 0;
+    }
+}
+
+///////////////////////////////////////////////////////////////////////////////////////
+
 jack_client::jack_client()
 {
     input_nr = output_nr = midi_nr = 1;
@@ -39,26 +208,36 @@ jack_client::jack_client()
     sample_rate = 0;
     client = NULL;
     automation_port = NULL;
+    schedule_dirty = false;
+    latency_dirty = false;
+    cycle_nframes = 0;
+    buffer_size = 0;
 }
 
 void jack_client::add(jack_host *plugin)
 {
-    calf_utils::ptlock lock(mutex);
-    plugins.push_back(plugin);
+    {
+        calf_utils::ptlock lock(mutex);
+        plugins.push_back(plugin);
+    }
+    update_schedule();
 }
 
 void jack_client::del(jack_host *plugin)
 {
-    calf_utils::ptlock lock(mutex);
-    for (unsigned int i = 0; i < plugins.size(); i++)
+    unlink_all(plugin);
     {
-        if (plugins[i] == plugin)
+        calf_utils::ptlock lock(mutex);
+        vector<jack_host *>::iterator i = std::find(plugins.begin(), plugins.end(), plugin);
+        if (i == plugins.end())
         {
-            plugins.erase(plugins.begin()+i);
+            assert(0);
             return;
         }
+        plugins.erase(i);
     }
-    assert(0);
+    // the old graph still refers to the plugin, it must be gone before the caller deletes it
+    update_schedule();
 }
 
 void jack_client::open(const char *client_name, const char *jack_session_id)
@@ -71,9 +250,13 @@ void jack_client::open(const char *client_name, const char *jack_session_id)
     if (!client)
         throw calf_utils::text_exception("Could not initialize JACK subsystem");
     sample_rate = jack_get_sample_rate(client);
+    buffer_size = jack_get_buffer_size(client);
     jack_set_process_callback(client, do_jack_process, this);
     jack_set_buffer_size_callback(client, do_jack_bufsize, this);
+    jack_set_graph_order_callback(client, do_jack_graph_order, this);
+    jack_set_latency_callback(client, do_jack_latency, this);
     name = get_name();
+    jobs.start();
 }
 
 std::string jack_client::get_name()
@@ -99,7 +282,9 @@ void jack_client::connect(const std::string &p1, const std::string &p2)
 
 void jack_client::close()
 {
+    scheduler.stop();
     jack_client_close(client);
+    jobs.stop();
 }
 
 const char **jack_client::get_ports(const char *name_re, const char *type_re, unsigned long flags)
@@ -111,50 +296,52 @@ namespace {
 
 class jack_automation: public automation_iface
 {
-    int event_pos;
     int event_count;
     jack_host *plugin;
     void *midi_data;
-    jack_midi_event_t event;
-    
-    void process_event()
-    {
-        if (event.size == 3 && ((event.buffer[0] & 0xF0) == 0xB0))
-        {
-            int designator = ((event.buffer[0] & 0xF) << 8) | event.buffer[1];
-            plugin->handle_automation_cc(designator, event.buffer[2]);
-        }
-    }
 public:
     jack_automation(jack_port_t *automation_port, int nframes, jack_host *_plugin)
     {
-        event_pos = 0;
         plugin = _plugin;
         midi_data = jack_port_get_buffer(automation_port, nframes);
         event_count = jack_midi_get_event_count(midi_data NFRAMES_MAYBE(nframes));
     }
     
-    uint32_t apply_and_adjust(uint32_t start, uint32_t time)
-    {
-        while(event_pos < event_count) {
-            jack_midi_event_get(&event, midi_data, event_pos NFRAMES_MAYBE(nframes));
-            if (event.time > start && event.time < time)
-                return event.time;
-            event_pos++;
-            process_event();
+    void schedule_events()
+    {
+        jack_midi_event_t event;
+        for (int i = 0; i < event_count; i++) {
+            jack_midi_event_get(&event, midi_data, i NFRAMES_MAYBE(nframes));
+            if (event.size == 3 && ((event.buffer[0] & 0xF0) == 0xB0))
+            {
+                int designator = ((event.buffer[0] & 0xF) << 8) | event.buffer[1];
+                plugin->handle_automation_cc(designator, event.buffer[2], event.time);
+            }
         }
-        return time;
     }
 };
 
 }
 
+void jack_client::process_plugin(void *p, jack_host *plugin)
+{
+    jack_client *self = (jack_client *)p;
+    jack_automation au(self->automation_port, self->cycle_nframes, plugin);
+    plugin->process(self->cycle_nframes, au);
+}
+
 int jack_client::do_jack_process(jack_nframes_t nframes, void *p)
 {
     jack_client *self = (jack_client *)p;
     pttrylock lock(self->mutex);
     if (lock.is_locked())
     {
+        if (self->scheduler.is_parallel())
+        {
+            self->cycle_nframes = nframes;
+            self->scheduler.run(process_plugin, self);
+            return 0;
+        }
         for(unsigned int i = 0; i < self->plugins.size(); i++)
         {
             jack_automation au(self->automation_port, nframes, self->plugins[i]);
@@ -164,10 +351,142 @@ int jack_client::do_jack_process(jack_nframes_t nframes, void *p)
     return 0;
 }
 
+int jack_client::do_jack_graph_order(void *p)
+{
+    // called from the JACK notification thread - leave the work to the GUI thread
+    jack_client *self = (jack_client *)p;
+    self->schedule_dirty = true;
+    self->latency_dirty = true;
+    return 0;
+}
+
+namespace {
+
+typedef map<jack_host *, jack_latency_range_t> latency_cache;
+
+void get_port_latency(jack_host::port *port, jack_latency_callback_mode_t mode, latency_cache &cache, jack_latency_range_t &range);
+
+/// The widest range over the ports on the far side of a plugin, plus the plugin's latency
+void get_plugin_latency(jack_host *plugin, jack_latency_callback_mode_t mode, latency_cache &cache, jack_latency_range_t &range)
+{
+    latency_cache::const_iterator cached = cache.find(plugin);
+    if (cached != cache.end())
+    {
+        range = cached->second;
+        return;
+    }
+    vector<jack_host::port *> from;
+    if (mode == JackCaptureLatency)
+        plugin->get_all_input_ports(from);
+    else
+        plugin->get_all_output_ports(from);
+    range.min = from.empty() ? 0 : 0xFFFFFFFF;
+    range.max = 0;
+    for (unsigned int j = 0; j < from.size(); j++)
+    {
+        jack_latency_range_t r;
+        get_port_latency(from[j], mode, cache, r);
+        // the delay of the port is on the way, to the outputs for an input and back for an output
+        r.min += from[j]->delay.get_delay();
+        r.max += from[j]->delay.get_delay();
+        range.min = std::min(range.min, r.min);
+        range.max = std::max(range.max, r.max);
+    }
+    range.min += plugin->compensated_latency;
+    range.max += plugin->compensated_latency;
+    cache[plugin] = range;
+}
+
+/// Latency range at a port; the linked ports are not known to JACK, so the
+/// range is worked out through the plugins on the other side of the link
+void get_port_latency(jack_host::port *port, jack_latency_callback_mode_t mode, latency_cache &cache, jack_latency_range_t &range)
+{
+    if (port->handle)
+    {
+        jack_port_get_latency_range(port->handle, mode, &range);
+        return;
+    }
+    if (port->source)
+    {
+        // linked input: capture latency of the feeding output, playback latency of the own plugin
+        if (mode == JackCaptureLatency)
+        {
+            get_plugin_latency(port->source->owner, mode, cache, range);
+            range.min += port->source->delay.get_delay();
+            range.max += port->source->delay.get_delay();
+        }
+        else
+        {
+            get_plugin_latency(port->owner, mode, cache, range);
+            range.min += port->delay.get_delay();
+            range.max += port->delay.get_delay();
+        }
+        return;
+    }
+    // linked output: capture latency of the own plugin, playback latency of the inputs fed
+    if (mode == JackCaptureLatency)
+    {
+        get_plugin_latency(port->owner, mode, cache, range);
+        range.min += port->delay.get_delay();
+        range.max += port->delay.get_delay();
+        return;
+    }
+    range.min = port->sinks.empty() ? 0 : 0xFFFFFFFF;
+    range.max = 0;
+    for (unsigned int i = 0; i < port->sinks.size(); i++)
+    {
+        jack_latency_range_t r;
+        get_plugin_latency(port->sinks[i]->owner, mode, cache, r);
+        r.min += port->sinks[i]->delay.get_delay();
+        r.max += port->sinks[i]->delay.get_delay();
+        range.min = std::min(range.min, r.min);
+        range.max = std::max(range.max, r.max);
+    }
+}
+
+}
+
+void jack_client::do_jack_latency(jack_latency_callback_mode_t mode, void *p)
+{
+    // called from the JACK notification thread, while the GUI thread may be
+    // waiting for the JACK server with the lock held - don't block, keep the
+    // latencies published last and have the idle handler ask for a new round
+    jack_client *self = (jack_client *)p;
+    pttrylock lock(self->mutex);
+    if (!lock.is_locked())
+    {
+        self->latency_dirty = true;
+        return;
+    }
+    latency_cache cache;
+    for (unsigned int i = 0; i < self->plugins.size(); i++)
+    {
+        jack_host *plugin = self->plugins[i];
+        vector<jack_host::port *> inputs, outputs;
+        plugin->get_all_input_ports(inputs);
+        plugin->get_all_output_ports(outputs);
+        if (inputs.empty() || outputs.empty())
+            continue;
+        vector<jack_host::port *> &to = mode == JackCaptureLatency ? outputs : inputs;
+        jack_latency_range_t range;
+        get_plugin_latency(plugin, mode, cache, range);
+        for (unsigned int j = 0; j < to.size(); j++)
+        {
+            if (!to[j]->handle)
+                continue;
+            jack_latency_range_t r = range;
+            r.min += to[j]->delay.get_delay();
+            r.max += to[j]->delay.get_delay();
+            jack_port_set_latency_range(to[j]->handle, mode, &r);
+        }
+    }
+}
+
 int jack_client::do_jack_bufsize(jack_nframes_t numsamples, void *p)
 {
     jack_client *self = (jack_client *)p;
     ptlock lock(self->mutex);
+    self->buffer_size = numsamples;
     for(unsigned int i = 0; i < self->plugins.size(); i++)
         self->plugins[i]->cache_ports();
     return 0;
@@ -180,6 +499,7 @@ void jack_client::delete_plugins()
         delete plugins[i];
     }
     plugins.clear();
+    delete scheduler.swap_graph(NULL);
 }
 
 void jack_client::create_automation_input()
@@ -195,16 +515,18 @@ void jack_client::destroy_automation_input()
         jack_port_unregister(client, automation_port);
 }
 
-void jack_client::calculate_plugin_order(std::vector<int> &indices)
+void jack_client::calculate_plugin_dependencies(std::multimap<int, int> &run_before)
 {
     map<string, int> port_to_plugin;
-    multimap<int, int> run_before;
+    map<jack_host *, int> plugin_index;
+    run_before.clear();
     for (unsigned int i = 0; i < plugins.size(); i++)
     {
         vector<jack_host::port *> ports;
         plugins[i]->get_all_input_ports(ports);
         for (unsigned int j = 0; j < ports.size(); j++)
             port_to_plugin[ports[j]->nice_name] = i;
+        plugin_index[plugins[i]] = i;
     }
     
     for (unsigned int i = 0; i < plugins.size(); i++)
@@ -213,6 +535,10 @@ void jack_client::calculate_plugin_order(std::vector<int> &indices)
         plugins[i]->get_all_output_ports(ports);
         for (unsigned int j = 0; j < ports.size(); j++)
         {
+            for (unsigned int k = 0; k < ports[j]->sinks.size(); k++)
+                run_before.insert(make_pair(plugin_index[ports[j]->sinks[k]->owner], (int)i));
+            if (!ports[j]->handle)
+                continue;
             const char **conns = jack_port_get_connections(ports[j]->handle);
             if (!conns)
                 continue;
@@ -232,6 +558,12 @@ void jack_client::calculate_plugin_order(std::vector<int> &indices)
             jack_free(conns);
         }
     }
+}
+
+void jack_client::calculate_plugin_order(std::vector<int> &indices)
+{
+    multimap<int, int> run_before;
+    calculate_plugin_dependencies(run_before);
     
     struct deptracker
     {
@@ -271,8 +603,11 @@ void jack_client::apply_plugin_order(const std::vector<int> &indices)
     assert(indices.size() == plugins.size());
     for (unsigned int i = 0; i < indices.size(); i++)
         plugins_new.push_back(plugins[indices[i]]);
-    ptlock lock(mutex);
-    plugins.swap(plugins_new);
+    {
+        ptlock lock(mutex);
+        plugins.swap(plugins_new);
+    }
+    update_schedule();
     
     string s;
     for (unsigned int i = 0; i < plugins.size(); i++)    
@@ -283,3 +618,271 @@ void jack_client::apply_plugin_order(const std::vector<int> &indices)
     }
     printf("Order: %s\n", s.c_str());
 }
+
+void jack_client::start_scheduler(int thread_count)
+{
+    scheduler.start(client, thread_count);
+    printf("Processing threads: %d\n", scheduler.get_thread_count());
+    update_schedule();
+}
+
+void jack_client::update_schedule()
+{
+    schedule_dirty = false;
+    if (!scheduler.is_parallel())
+        return;
+    multimap<int, int> run_before;
+    calculate_plugin_dependencies(run_before);
+    schedule_graph *graph = scheduler.create_graph(plugins, run_before);
+    {
+        // the process callback holds the lock for the whole cycle
+        ptlock lock(mutex);
+        graph = scheduler.swap_graph(graph);
+    }
+    delete graph;
+}
+
+void jack_client::check_schedule()
+{
+    if (schedule_dirty)
+        update_schedule();
+}
+
+void jack_client::update_latency()
+{
+    latency_dirty = false;
+    vector<int> order;
+    calculate_plugin_order(order);
+    map<string, int> port_to_plugin;
+    map<string, jack_host::port *> output_by_name;
+    map<jack_host *, int> plugin_index;
+    for (unsigned int i = 0; i < plugins.size(); i++)
+    {
+        vector<jack_host::port *> ports;
+        plugins[i]->get_all_input_ports(ports);
+        for (unsigned int j = 0; j < ports.size(); j++)
+            port_to_plugin[ports[j]->nice_name] = i;
+        ports.clear();
+        plugins[i]->get_all_output_ports(ports);
+        for (unsigned int j = 0; j < ports.size(); j++)
+            output_by_name[ports[j]->nice_name] = ports[j];
+        plugin_index[plugins[i]] = i;
+    }
+
+    // Latency at the inputs of each plugin and at the ports outside the rack
+    // that plugins feed, the highest one of all the signals arriving there.
+    // Producers come before their consumers in the order.
+    vector<uint32_t> arrival(plugins.size(), 0), out_arrival(plugins.size(), 0);
+    map<string, uint32_t> external_arrival;
+    // the ports each output is connected to, as (plugin, port name) with plugin -1 outside the rack
+    vector<vector<vector<pair<int, string> > > > sinks(plugins.size());
+    int cnlen = name.length();
+    for (unsigned int n = 0; n < order.size(); n++)
+    {
+        int i = order[n];
+        jack_host *plugin = plugins[i];
+        plugin->compensated_latency = plugin->latency;
+        out_arrival[i] = arrival[i] + plugin->compensated_latency;
+        vector<jack_host::port *> ports;
+        plugin->get_all_output_ports(ports);
+        sinks[i].resize(ports.size());
+        for (unsigned int j = 0; j < ports.size(); j++)
+        {
+            for (unsigned int k = 0; k < ports[j]->sinks.size(); k++)
+            {
+                int target = plugin_index[ports[j]->sinks[k]->owner];
+                arrival[target] = std::max(arrival[target], out_arrival[i]);
+                sinks[i][j].push_back(make_pair(target, string()));
+            }
+            const char **conns = ports[j]->handle ? jack_port_get_connections(ports[j]->handle) : NULL;
+            if (!conns)
+                continue;
+            for (const char **k = conns; *k; k++)
+            {
+                int target = -1;
+                if (!strncmp(*k, name.c_str(), cnlen) && (*k)[cnlen] == ':')
+                {
+                    map<string, int>::const_iterator p = port_to_plugin.find((*k) + cnlen + 1);
+                    if (p != port_to_plugin.end())
+                        target = p->second;
+                }
+                if (target != -1)
+                    arrival[target] = std::max(arrival[target], out_arrival[i]);
+                else
+                    external_arrival[*k] = std::max(external_arrival[*k], out_arrival[i]);
+                sinks[i][j].push_back(make_pair(target, string(*k)));
+            }
+            jack_free(conns);
+        }
+    }
+
+    // A signal can only be delayed, never advanced, and an output may feed
+    // destinations that need different delays. So each output is delayed by
+    // the least any of its destinations needs and each input makes up the
+    // rest for its own plugin; ports outside the rack have no delay of their own.
+    vector<pair<jack_host::port *, compensation_delay> > changes;
+    map<jack_host::port *, uint32_t> output_delay;
+    for (unsigned int i = 0; i < plugins.size(); i++)
+    {
+        vector<jack_host::port *> ports;
+        plugins[i]->get_all_output_ports(ports);
+        for (unsigned int j = 0; j < ports.size(); j++)
+        {
+            uint32_t delay = sinks[i][j].empty() ? 0 : 0xFFFFFFFF;
+            for (unsigned int k = 0; k < sinks[i][j].size(); k++)
+            {
+                const pair<int, string> &sink = sinks[i][j][k];
+                uint32_t target = sink.first != -1 ? arrival[sink.first] : external_arrival[sink.second];
+                delay = std::min(delay, target - out_arrival[i]);
+            }
+            output_delay[ports[j]] = delay;
+            if (delay != ports[j]->delay.get_delay())
+            {
+                changes.push_back(make_pair(ports[j], compensation_delay()));
+                changes.back().second.set_delay(delay);
+            }
+        }
+    }
+    for (unsigned int i = 0; i < plugins.size(); i++)
+    {
+        jack_host *plugin = plugins[i];
+        for (int j = 0; j < plugin->in_count; j++)
+        {
+            jack_host::port *input = &plugin->inputs[j];
+            // the signals come in already delayed by the outputs feeding them, the ones
+            // from outside the rack are treated as arriving without latency
+            vector<uint32_t> incoming;
+            if (input->source)
+            {
+                int source = plugin_index[input->source->owner];
+                incoming.push_back(out_arrival[source] + output_delay[input->source]);
+            }
+            const char **conns = input->handle ? jack_port_get_connections(input->handle) : NULL;
+            for (const char **k = conns; k && *k; k++)
+            {
+                map<string, jack_host::port *>::const_iterator p = output_by_name.end();
+                if (!strncmp(*k, name.c_str(), cnlen) && (*k)[cnlen] == ':')
+                    p = output_by_name.find((*k) + cnlen + 1);
+                if (p != output_by_name.end())
+                    incoming.push_back(out_arrival[plugin_index[p->second->owner]] + output_delay[p->second]);
+                else
+                    incoming.push_back(0);
+            }
+            if (conns)
+                jack_free(conns);
+            // when several signals are mixed in one input, the latest decides
+            uint32_t latest = incoming.empty() ? arrival[i] : *std::max_element(incoming.begin(), incoming.end());
+            uint32_t delay = arrival[i] - std::min(latest, arrival[i]);
+            if (delay != input->delay.get_delay())
+            {
+                changes.push_back(make_pair(input, compensation_delay()));
+                changes.back().second.set_delay(delay);
+            }
+        }
+    }
+    if (!changes.empty())
+    {
+        ptlock lock(mutex);
+        for (unsigned int i = 0; i < changes.size(); i++)
+            changes[i].first->delay.swap(changes[i].second);
+        // delayed inputs need buffers of their own
+        for (unsigned int i = 0; i < plugins.size(); i++)
+            plugins[i]->cache_ports();
+    }
+    jack_recompute_total_latencies(client);
+}
+
+void jack_client::check_latency()
+{
+    bool changed = latency_dirty;
+    for (unsigned int i = 0; i < plugins.size() && !changed; i++)
+        changed = plugins[i]->latency != plugins[i]->compensated_latency;
+    if (changed)
+        update_latency();
+}
+
+namespace {
+
+/// Whether a plugin feeds another one through links, directly or through other plugins
+bool feeds_through_links(jack_host *from, jack_host *to)
+{
+    if (from == to)
+        return true;
+    vector<jack_host::port *> ports;
+    from->get_all_output_ports(ports);
+    for (unsigned int i = 0; i < ports.size(); i++)
+    {
+        for (unsigned int j = 0; j < ports[i]->sinks.size(); j++)
+        {
+            if (feeds_through_links(ports[i]->sinks[j]->owner, to))
+                return true;
+        }
+    }
+    return false;
+}
+
+}
+
+void jack_client::link(jack_host *from, int output, jack_host *to, int input)
+{
+    assert(output >= 0 && output < from->out_count && input >= 0 && input < to->in_count);
+    jack_host::port &src = from->outputs[output], &dest = to->inputs[input];
+    if (dest.source == &src)
+        return;
+    // the latency calculation follows the links, they can't form a loop
+    if (feeds_through_links(to, from))
+        throw text_exception("Cannot link " + src.nice_name + " to " + dest.nice_name + " - the plugins would feed each other");
+    // the ports stop being JACK ports, which would silently drop their JACK connections
+    if ((src.handle && jack_port_connected(src.handle)) || (dest.handle && jack_port_connected(dest.handle)))
+        throw text_exception("Cannot link " + src.nice_name + " to " + dest.nice_name + " - the ports are connected in JACK");
+    unlink(to, input);
+    {
+        // the process callback holds the lock for the whole cycle
+        ptlock lock(mutex);
+        dest.source = &src;
+        src.sinks.push_back(&dest);
+        from->cache_ports();
+    }
+    // neither port is used by the process callback any more
+    to->unregister_port(dest);
+    from->unregister_port(src);
+    update_schedule();
+    latency_dirty = true;
+}
+
+void jack_client::unlink(jack_host *to, int input)
+{
+    jack_host::port &dest = to->inputs[input];
+    jack_host::port *src = dest.source;
+    if (!src)
+        return;
+    // the ports have to be there before the process callback goes back to them
+    if (src->sinks.size() == 1)
+        src->owner->register_port(*src, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
+    to->register_port(dest, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput);
+    {
+        ptlock lock(mutex);
+        dest.source = NULL;
+        src->sinks.erase(std::remove(src->sinks.begin(), src->sinks.end(), &dest), src->sinks.end());
+        src->owner->cache_ports();
+    }
+    if (src->sinks.empty())
+        vector<float>().swap(src->buffer);
+    update_schedule();
+    latency_dirty = true;
+}
+
+void jack_client::unlink_all(jack_host *plugin)
+{
+    for (int i = 0; i < plugin->in_count; i++)
+        unlink(plugin, i);
+    for (int i = 0; i < plugin->out_count; i++)
+    {
+        jack_host::port &src = plugin->outputs[i];
+        while (!src.sinks.empty())
+        {
+            jack_host::port *dest = src.sinks.back();
+            unlink(dest->owner, dest - dest->owner->get_inputs());
+        }
+    }
+}
@@ -23,7 +23,9 @@
 #include <calf/preset.h>
 #include <calf/gtk_session_env.h>
 #include <calf/plugin_tools.h>
+#include <calf/synth.h>
 #include <getopt.h>
+#include <time.h>
 
 using namespace std;
 using namespace calf_utils;
@@ -50,7 +52,7 @@ jack_host::jack_host(jack_client *_client, audio_module_iface *_module, const st
     instance_name = _instance_name;
     
     client = _client;
-    cc_mappings = NULL;
+    cc_table = cc_table_seen = NULL;
     changed = true;
 
     module->get_port_arrays(ins, outs, params);
@@ -60,6 +62,11 @@ jack_host::jack_host(jack_client *_client, audio_module_iface *_module, const st
     param_count = metadata->get_param_count();
     inputs.resize(in_count);
     outputs.resize(out_count);
+    for (int i = 0; i < in_count; i++)
+        inputs[i].owner = this;
+    for (int i = 0; i < out_count; i++)
+        outputs[i].owner = this;
+    midi_port.owner = this;
     param_values = new float[param_count];
     write_serials.resize(param_count);
     fill(write_serials.begin(), write_serials.end(), 0);
@@ -70,14 +77,25 @@ jack_host::jack_host(jack_client *_client, audio_module_iface *_module, const st
     clear_preset();
     midi_meter = 0;
     last_designator = 0xFFFFFFFF;
+    process_time = 0.f;
+    latency = compensated_latency = 0;
     module->set_progress_report_iface(_priface);
+    jobs = client->create_job_queue();
+    module->set_worker_iface(jobs);
     module->post_instantiate(client->sample_rate);
 }
 
 jack_host::~jack_host()
 {
-    delete cc_mappings;
-    cc_mappings = NULL;
+    // not processed any more, nothing is using the tables
+    for (unsigned int i = 0; i < retired_tables.size(); i++)
+        delete retired_tables[i];
+    retired_tables.clear();
+    delete cc_table;
+    cc_table = NULL;
+    // the host is not processed any more, any job left is finished here
+    delete jobs;
+    module->set_worker_iface(NULL);
     delete []param_values;
     if (client)
         destroy();
@@ -95,7 +113,6 @@ void jack_host::create()
 void jack_host::create_ports() {
     char buf[64];
     char buf2[64];
-    string prefix = client->name + ":";
     port *inputs = get_inputs();
     port *outputs = get_outputs();
     int in_count = metadata->get_input_count(), out_count = metadata->get_output_count();
@@ -104,36 +121,52 @@ void jack_host::create_ports() {
         snprintf(buf2, sizeof(buf2), client->input_name.c_str(), client->input_nr++);
         inputs[i].nice_name = buf;
         inputs[i].name = buf2;
-        inputs[i].handle = jack_port_register(client->client, buf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput , 0);
         inputs[i].data = NULL;
         inputs[i].meter.set_falloff(0.f, client->sample_rate);
-        if (!inputs[i].handle)
-            throw text_exception("Could not create JACK input port");
-        jack_port_set_alias(inputs[i].handle, (prefix + buf2).c_str());
+        register_port(inputs[i], JACK_DEFAULT_AUDIO_TYPE, JackPortIsInput);
     }
     if (metadata->get_midi()) {
         snprintf(buf, sizeof(buf), "%s MIDI In", instance_name.c_str());
         snprintf(buf2, sizeof(buf2), client->midi_name.c_str(), client->midi_nr++);
         midi_port.nice_name = buf;
         midi_port.name = buf2;
-        midi_port.handle = jack_port_register(client->client, buf, JACK_DEFAULT_MIDI_TYPE, JackPortIsInput, 0);
-        if (!midi_port.handle)
-            throw text_exception("Could not create JACK MIDI port");
-        jack_port_set_alias(midi_port.handle, (prefix + buf2).c_str());
+        register_port(midi_port, JACK_DEFAULT_MIDI_TYPE, JackPortIsInput);
     }
     for (int i=0; i<out_count; i++) {
         snprintf(buf, sizeof(buf), "%s Out #%d", instance_name.c_str(), i+1);
         snprintf(buf2, sizeof(buf2), client->output_name.c_str(), client->output_nr++);
         outputs[i].nice_name = buf;
         outputs[i].name = buf2;
-        outputs[i].handle = jack_port_register(client->client, buf, JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput , 0);
         outputs[i].data = NULL;
-        if (!outputs[i].handle)
-            throw text_exception("Could not create JACK output port");
-        jack_port_set_alias(outputs[i].handle, (prefix + buf2).c_str());
+        register_port(outputs[i], JACK_DEFAULT_AUDIO_TYPE, JackPortIsOutput);
     }
 }
 
+void jack_host::register_port(port &p, const char *type, unsigned long flags)
+{
+    if (p.handle)
+        return;
+    jack_port_t *handle = jack_port_register(client->client, p.nice_name.c_str(), type, flags, 0);
+    if (!handle)
+        throw text_exception("Could not create JACK port " + p.nice_name);
+    jack_port_set_alias(handle, (client->name + ":" + p.name).c_str());
+    // the JACK callbacks read the handle under the lock, JACK itself is called outside of it
+    ptlock lock(client->mutex);
+    p.handle = handle;
+}
+
+void jack_host::unregister_port(port &p)
+{
+    if (!p.handle)
+        return;
+    jack_port_t *handle = p.handle;
+    {
+        ptlock lock(client->mutex);
+        p.handle = NULL;
+    }
+    jack_port_unregister(client->client, handle);
+}
+
 void jack_host::rename_ports() {
     char buf[64];
     port *inputs = get_inputs();
@@ -142,7 +175,8 @@ void jack_host::rename_ports() {
     for (int i=0; i<in_count; i++) {
         snprintf(buf, sizeof(buf), "%s In #%d", instance_name.c_str(), i+1);
         inputs[i].nice_name = buf;
-        jack_port_set_name(inputs[i].handle, buf);
+        if (inputs[i].handle)
+            jack_port_set_name(inputs[i].handle, buf);
     }
     if (metadata->get_midi()) {
         snprintf(buf, sizeof(buf), "%s MIDI In", instance_name.c_str());
@@ -152,7 +186,8 @@ void jack_host::rename_ports() {
     for (int i=0; i<out_count; i++) {
         snprintf(buf, sizeof(buf), "%s Out #%d", instance_name.c_str(), i+1);
         outputs[i].nice_name = buf;
-        jack_port_set_name(outputs[i].handle, buf);
+        if (outputs[i].handle)
+            jack_port_set_name(outputs[i].handle, buf);
     }
 }
 
@@ -161,19 +196,22 @@ void jack_host::rename(std::string name) {
     rename_ports();
 }
 
-void jack_host::handle_automation_cc(uint32_t designator, int value)
+void jack_host::handle_automation_cc(uint32_t designator, int value, uint32_t time)
 {
     last_designator = designator;
-    if (!cc_mappings)
+    const automation_table *table = __atomic_load_n(&cc_table, __ATOMIC_ACQUIRE);
+    if (!table || designator >= (uint32_t)automation_table::designator_count)
         return;
-    automation_map::const_iterator i = cc_mappings->find(designator);
-    while (i != cc_mappings->end() && i->first == designator)
+    for (uint32_t i = table->first[designator]; i < table->first[designator + 1]; i++)
     {
-        const automation_range &r = i->second;
+        const automation_range &r = table->routes[i];
         const parameter_properties *props = metadata->get_param_props(r.param_no);
-        set_param_value(r.param_no, props->from_01(r.min_value + value * (r.max_value - r.min_value)/ 127.0));
+        float new_value = props->from_01(r.min_value + value * (r.max_value - r.min_value)/ 127.0);
+        // the module ramps to the value inside its block loop; if its queue is full and holds no
+        // changes of the parameter, the value is set for the whole cycle
+        if (!module->schedule_param_change(time, r.param_no, new_value))
+            set_param_value(r.param_no, new_value);
         write_serials[r.param_no] = ++last_modify_serial;
-        ++i;
     }
 }
 
@@ -219,15 +257,15 @@ void jack_host::destroy()
     port *inputs = get_inputs(), *outputs = get_outputs();
     int input_count = metadata->get_input_count(), output_count = metadata->get_output_count();
     for (int i = 0; i < input_count; i++) {
-        jack_port_unregister(client->client, inputs[i].handle);
+        unregister_port(inputs[i]);
         inputs[i].data = NULL;
     }
     for (int i = 0; i < output_count; i++) {
-        jack_port_unregister(client->client, outputs[i].handle);
+        unregister_port(outputs[i]);
         outputs[i].data = NULL;
     }
     if (metadata->get_midi())
-        jack_port_unregister(client->client, midi_port.handle);
+        unregister_port(midi_port);
     client = NULL;
 }
 
@@ -268,13 +306,34 @@ float jack_host::get_level(unsigned int port)
 
 int jack_host::process(jack_nframes_t nframes, automation_iface &automation)
 {
+    // This may run on one of the scheduler's worker threads. Getting port
+    // buffers from there is fine, because the JACK process thread is waiting
+    // for the workers inside the process callback.
+    struct timespec ts_start, ts_end;
+    clock_gettime(CLOCK_MONOTONIC, &ts_start);
     for (int i=0; i<in_count; i++) {
-        ins[i] = inputs[i].data = (float *)jack_port_get_buffer(inputs[i].handle, nframes);
+        // a linked input reads the buffer of the output feeding it, which has been processed already
+        float *data;
+        if (inputs[i].source)
+            data = inputs[i].source->data;
+        else
+            data = (float *)jack_port_get_buffer(inputs[i].handle, nframes);
+        // other ports may read the same buffer, so a delayed input works on a copy
+        if (inputs[i].delay.get_delay())
+        {
+            std::copy(data, data + nframes, inputs[i].buffer.begin());
+            data = &inputs[i].buffer[0];
+            inputs[i].delay.process(data, nframes);
+        }
+        ins[i] = inputs[i].data = data;
     }
     if (metadata->get_midi())
         midi_port.data = (float *)jack_port_get_buffer(midi_port.handle, nframes);
+    jobs->apply_finished();
+    // automation doesn't split the cycle, the module applies the changes at their time
+    automation.schedule_events();
     if (changed) {
-        module->params_changed();
+        module->check_params();
         changed = false;
     }
 
@@ -286,9 +345,7 @@ int jack_host::process(jack_nframes_t nframes, automation_iface &automation)
         for (int i = 0; i < count; i++)
         {
             jack_midi_event_get(&event, midi_port.data, i NFRAMES_MAYBE(nframes));
-            uint32_t endtime = automation.apply_and_adjust(time, event.time);
-            unsigned int len = endtime - time;
-            process_part(time, len);
+            process_part(time, event.time - time);
             
             midi_meter = 1.f;
             handle_event(event.buffer, event.size);
@@ -296,13 +353,16 @@ int jack_host::process(jack_nframes_t nframes, automation_iface &automation)
             time = event.time;
         }
     }
-    while(time < nframes)
-    {
-        uint32_t endtime = automation.apply_and_adjust(time, nframes);
-        process_part(time, endtime - time);
-        time = endtime;
-    }
+    process_part(time, nframes - time);
     module->params_reset();
+    for (int i = 0; i < out_count; i++)
+        outputs[i].delay.process(outs[i], nframes);
+    latency = module->get_latency();
+    // the automation tables replaced before this one are not in use any more
+    __atomic_store_n(&cc_table_seen, __atomic_load_n(&cc_table, __ATOMIC_ACQUIRE), __ATOMIC_RELEASE);
+    clock_gettime(CLOCK_MONOTONIC, &ts_end);
+    float usecs = (ts_end.tv_sec - ts_start.tv_sec) * 1000000.f + (ts_end.tv_nsec - ts_start.tv_nsec) * 0.001f;
+    process_time += (usecs - process_time) * 0.05f;
     return 0;
 }
 
@@ -315,8 +375,17 @@ void jack_host::init_module()
 
 void jack_host::cache_ports()
 {
+    for (int i=0; i<in_count; i++) {
+        if (inputs[i].delay.get_delay())
+            inputs[i].buffer.resize(client->buffer_size);
+    }
     for (int i=0; i<out_count; i++) {
-        outs[i] = outputs[i].data = (float *)jack_port_get_buffer(outputs[i].handle, 0);
+        if (!outputs[i].sinks.empty()) {
+            outputs[i].buffer.resize(client->buffer_size);
+            outs[i] = outputs[i].data = &outputs[i].buffer[0];
+        }
+        else
+            outs[i] = outputs[i].data = (float *)jack_port_get_buffer(outputs[i].handle, 0);
     }
 }
 
@@ -346,37 +415,76 @@ static void remove_mapping(automation_map &amap, uint32_t source, int param_no)
     }
 }
 
+automation_table::automation_table(const automation_map &_mappings)
+: mappings(_mappings)
+{
+    routes.reserve(mappings.size());
+    automation_map::const_iterator i = mappings.begin();
+    for (uint32_t d = 0; d < designator_count; d++)
+    {
+        first[d] = routes.size();
+        for (; i != mappings.end() && i->first == d; ++i)
+            routes.push_back(i->second);
+    }
+    // other sources are kept in the mappings, but nothing routes them
+    first[designator_count] = routes.size();
+}
+
 void jack_host::add_automation(uint32_t source, const automation_range &dest)
 {
-    automation_map *amap = new automation_map;
-    if (cc_mappings)
-        amap->insert(cc_mappings->begin(), cc_mappings->end());
-    remove_mapping(*amap, source, dest.param_no);
-    amap->insert(make_pair(source, dest));
+    automation_map amap;
+    if (cc_table)
+        amap = cc_table->mappings;
+    remove_mapping(amap, source, dest.param_no);
+    amap.insert(make_pair(source, dest));
     replace_automation_map(amap);
 }
 
 void jack_host::delete_automation(uint32_t source, int param_no)
 {
-    automation_map *amap = new automation_map;
-    if (cc_mappings)
-        amap->insert(cc_mappings->begin(), cc_mappings->end());
-    remove_mapping(*amap, source, param_no);
+    automation_map amap;
+    if (cc_table)
+        amap = cc_table->mappings;
+    remove_mapping(amap, source, param_no);
     replace_automation_map(amap);
 }
 
-void jack_host::replace_automation_map(automation_map *amap)
+void jack_host::replace_automation_map(const automation_map &amap)
+{
+    // No locking: the processing thread picks the new table up with its next
+    // event, the old one is freed once a cycle has ended with the new one.
+    automation_table *table = new automation_table(amap);
+    if (cc_table)
+        retired_tables.push_back(cc_table);
+    __atomic_store_n(&cc_table, table, __ATOMIC_RELEASE);
+    free_retired_tables();
+}
+
+void jack_host::free_retired_tables()
 {
-    client->atomic_swap(cc_mappings, amap);
-    delete amap;
+    automation_table *seen = __atomic_load_n(&cc_table_seen, __ATOMIC_ACQUIRE);
+    unsigned int unused = retired_tables.size();
+    if (seen != cc_table)
+    {
+        // only the tables replaced before the one seen last are safe to free
+        unused = 0;
+        while (unused < retired_tables.size() && retired_tables[unused] != seen)
+            unused++;
+        if (unused == retired_tables.size())
+            return;
+    }
+    for (unsigned int i = 0; i < unused; i++)
+        delete retired_tables[i];
+    retired_tables.erase(retired_tables.begin(), retired_tables.begin() + unused);
 }
 
 void jack_host::get_automation(int param_no, multimap<uint32_t, automation_range> &dests)
 {
     dests.clear();
-    if (!cc_mappings)
+    if (!cc_table)
         return;
-    for(automation_map::iterator i = cc_mappings->begin(); i != cc_mappings->end(); ++i)
+    const automation_map &mappings = cc_table->mappings;
+    for(automation_map::const_iterator i = mappings.begin(); i != mappings.end(); ++i)
     {
         if (param_no == -1 || param_no == i->second.param_no)
             dests.insert(*i);
@@ -385,9 +493,10 @@ void jack_host::get_automation(int param_no, multimap<uint32_t, automation_range
 
 void jack_host::send_automation_configures(send_configure_iface *sci)
 {
-    if (!cc_mappings)
+    if (!cc_table)
         return;
-    for(automation_map::iterator i = cc_mappings->begin(); i != cc_mappings->end(); ++i)
+    const automation_map &mappings = cc_table->mappings;
+    for(automation_map::const_iterator i = mappings.begin(); i != mappings.end(); ++i)
     {
         i->second.send_configure(metadata, i->first, sci);
     }
@@ -408,7 +517,7 @@ char *jack_host::configure(const char *key, const char *value)
 
 ////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////////
 
-static const char *short_options = "c:i:l:o:m:M:s:S:ehvL";
+static const char *short_options = "c:i:l:o:m:M:s:S:t:T:ehvL";
 
 static struct option long_options[] = {
     {"help", 0, 0, 'h'},
@@ -423,6 +532,8 @@ static struct option long_options[] = {
     {"connect-midi", 1, 0, 'M'},
     {"session-id", 1, 0, 'S'},
     {"list", 0, 0, 'L'},
+    {"threads", 1, 0, 't'},
+    {"voice-threads", 1, 0, 'T'},
     {0,0,0,0},
 };
 
@@ -430,7 +541,8 @@ void print_help(char *argv[])
 {
     printf("JACK host for Calf effects\n"
         "Syntax: %s [--client <name>] [--input <name>] [--output <name>] [--midi <name>] [--load|state <session>]\n"
-        "       [--connect-midi <name|capture-index>] [--help] [--version] [--list] [!] pluginname[:<preset>] [!] ...\n", 
+        "       [--connect-midi <name|capture-index>] [--threads <count, 0 = all CPUs>]\n"
+        "       [--voice-threads <count per synth>] [--help] [--version] [--list] [!] pluginname[:<preset>] [!] ...\n", 
         argv[0]);
 }
 
@@ -502,6 +614,12 @@ int main(int argc, char *argv[])
             case 'S':
                 sess.jack_session_id = optarg;
                 break;
+            case 't':
+                sess.thread_count = atoi(optarg);
+                break;
+            case 'T':
+                dsp::voice_render_pool::set_default_threads(atoi(optarg));
+                break;
             case 'l':
             case 's':
             {
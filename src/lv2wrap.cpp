@@ -17,8 +17,13 @@ lv2_instance::lv2_instance(audio_module_iface *_module)
     urid_map = NULL;
     event_in_data = NULL;
     event_out_data = NULL;
+    latency_port = NULL;
     progress_report_feature = NULL;
     options_feature = NULL;
+    worker_schedule = NULL;
+    applied_count = 0;
+    configures_pending = 0;
+    send_configures_pending = false;
     midi_event_type = 0xFFFFFFFF;
 
     srate_to_set = 44100;
@@ -46,6 +51,10 @@ void lv2_instance::lv2_instantiate(const LV2_Descriptor * Descriptor, double sam
         {
             options_feature = (LV2_Options_Interface *)((*features)->data);
         }
+        else if (!strcmp((*features)->URI, LV2_WORKER__schedule))
+        {
+            worker_schedule = (LV2_Worker_Schedule *)((*features)->data);
+        }
         features++;
     }
     post_instantiate();
@@ -55,6 +64,8 @@ void lv2_instance::post_instantiate()
 {
     if (progress_report_feature)
         module->set_progress_report_iface(this);
+    if (worker_schedule)
+        module->set_worker_iface(this);
     if (urid_map)
     {
         std::vector<std::string> varnames;
@@ -142,9 +153,18 @@ void lv2_instance::run(uint32_t SampleCount, bool has_simulate_stereo_input_flag
     if (set_srate) {
         module->set_sample_rate(srate_to_set);
         module->activate();
+        module->invalidate_params();
         set_srate = false;
     }
-    module->params_changed();
+    // jobs applied after the previous run go back to the worker for cleanup
+    while (applied_count > 0)
+    {
+        work_message msg = { work_message::JOB, applied_jobs[applied_count - 1], -1 };
+        if (worker_schedule->schedule_work(worker_schedule->handle, sizeof(msg), &msg) != LV2_WORKER_SUCCESS)
+            break;
+        applied_count--;
+    }
+    module->check_params();
     uint32_t offset = 0;
     if (event_out_data)
     {
@@ -158,28 +178,44 @@ void lv2_instance::run(uint32_t SampleCount, bool has_simulate_stereo_input_flag
     {
         process_events(offset);
     }
+    if (send_configures_pending && !__atomic_load_n(&configures_pending, __ATOMIC_ACQUIRE))
+    {
+        send_configures_pending = false;
+        output_configures();
+    }
     bool simulate_stereo_input = (in_count > 1) && has_simulate_stereo_input_flag && !ins[1];
     if (simulate_stereo_input)
         ins[1] = ins[0];
     module->process_slice(offset, SampleCount);
     if (simulate_stereo_input)
         ins[1] = NULL;
+    if (latency_port)
+        *latency_port = module->get_latency();
+}
+
+void lv2_instance::output_configures()
+{
+    struct sci: public send_configure_iface
+    {
+        lv2_instance *inst;
+        void send_configure(const char *key, const char *value)
+        {
+            inst->output_event_property(key, value);
+        }
+    } tmp;
+    tmp.inst = this;
+    send_configures(&tmp);
 }
 
 void lv2_instance::process_event_string(const char *str)
 {
     if (str[0] == '?' && str[1] == '\0')
     {
-        struct sci: public send_configure_iface
-        {
-            lv2_instance *inst;
-            void send_configure(const char *key, const char *value)
-            {
-                inst->output_event_property(key, value);
-            }
-        } tmp;
-        tmp.inst = this;
-        send_configures(&tmp);
+        // don't read the variables while the worker may be changing them
+        if (__atomic_load_n(&configures_pending, __ATOMIC_ACQUIRE))
+            send_configures_pending = true;
+        else
+            output_configures();
     }
 }
 
@@ -193,7 +229,7 @@ void lv2_instance::process_event_property(const LV2_Atom_Property *prop)
         else
             printf("Set property %s -> %s\n", vars[i->second].name.c_str(), (const char *)((&prop->body)+1));
 
-        if (i != uri_to_var.end())
+        if (i != uri_to_var.end() && !schedule_configure(i->second, (const char *)((&prop->body)+1)))
             configure(vars[i->second].name.c_str(), (const char *)((&prop->body)+1));
     }
     else
@@ -249,6 +285,100 @@ void lv2_instance::process_events(uint32_t &offset)
     }
 }
 
+bool lv2_instance::schedule_configure(int var, const char *value)
+{
+    enum { max_message_size = 4096 };
+    // the worker runs configure() alongside run(), which most modules aren't prepared for
+    if (!worker_schedule || !module->get_metadata_iface()->configure_is_threadsafe())
+        return false;
+    uint32_t len = strlen(value) + 1;
+    if (sizeof(work_message) + len > max_message_size)
+        return false;
+    char buf[max_message_size];
+    work_message msg = { work_message::CONFIGURE, NULL, var };
+    memcpy(buf, &msg, sizeof(msg));
+    memcpy(buf + sizeof(msg), value, len);
+    if (worker_schedule->schedule_work(worker_schedule->handle, sizeof(msg) + len, buf) != LV2_WORKER_SUCCESS)
+        return false;
+    __atomic_add_fetch(&configures_pending, 1, __ATOMIC_RELAXED);
+    return true;
+}
+
+bool lv2_instance::schedule_work(work_job *job)
+{
+    job->set_state(work_job::JOB_QUEUED);
+    work_message msg = { work_message::JOB, job, -1 };
+    if (worker_schedule->schedule_work(worker_schedule->handle, sizeof(msg), &msg) != LV2_WORKER_SUCCESS)
+    {
+        job->set_state(work_job::JOB_IDLE);
+        return false;
+    }
+    return true;
+}
+
+LV2_Worker_Status lv2_instance::work(LV2_Worker_Respond_Function respond, LV2_Worker_Respond_Handle handle, uint32_t size, const void *data)
+{
+    work_message msg;
+    if (size < sizeof(msg))
+        return LV2_WORKER_ERR_UNKNOWN;
+    memcpy(&msg, data, sizeof(msg));
+    if (msg.type == work_message::CONFIGURE)
+    {
+        std::string value((const char *)data + sizeof(msg), size - sizeof(msg) - 1);
+        char *error = module->configure(vars[msg.var].name.c_str(), value.c_str());
+        if (error)
+        {
+            fprintf(stderr, "Error setting %s: %s\n", vars[msg.var].name.c_str(), error);
+            free(error);
+        }
+        // let run() know the variables can be read again, directly if the response can't be sent
+        LV2_Worker_Status status = respond(handle, sizeof(msg), &msg);
+        if (status != LV2_WORKER_SUCCESS)
+            __atomic_sub_fetch(&configures_pending, 1, __ATOMIC_RELEASE);
+        return status;
+    }
+    if (msg.job->state == work_job::JOB_QUEUED)
+    {
+        msg.job->work();
+        LV2_Worker_Status status = respond(handle, sizeof(msg), &msg);
+        if (status != LV2_WORKER_SUCCESS)
+        {
+            // the result can't be applied, drop it so that the job can be scheduled again
+            msg.job->cleanup();
+            msg.job->set_state(work_job::JOB_IDLE);
+        }
+        return status;
+    }
+    msg.job->cleanup();
+    msg.job->set_state(work_job::JOB_IDLE);
+    return LV2_WORKER_SUCCESS;
+}
+
+LV2_Worker_Status lv2_instance::work_response(uint32_t size, const void *data)
+{
+    work_message msg;
+    if (size < sizeof(msg))
+        return LV2_WORKER_ERR_UNKNOWN;
+    memcpy(&msg, data, sizeof(msg));
+    if (msg.type == work_message::CONFIGURE)
+    {
+        __atomic_sub_fetch(&configures_pending, 1, __ATOMIC_RELEASE);
+        return LV2_WORKER_SUCCESS;
+    }
+    msg.job->apply();
+    msg.job->set_state(work_job::JOB_APPLIED);
+    if (applied_count < max_applied_jobs)
+        applied_jobs[applied_count++] = msg.job;
+    else
+    {
+        // more jobs than a module should ever have in flight, better
+        // clean up here than keep the job busy forever
+        msg.job->cleanup();
+        msg.job->set_state(work_job::JOB_IDLE);
+    }
+    return LV2_WORKER_SUCCESS;
+}
+
 LV2_State_Status lv2_instance::state_save(
     LV2_State_Store_Function store, LV2_State_Handle handle,
     uint32_t flags, const LV2_Feature *const * features)
@@ -27,6 +27,7 @@
 #include <calf/lv2_options.h>
 #include <calf/lv2_state.h>
 #include <calf/lv2_urid.h>
+#include <calf/lv2_worker.h>
 #endif
 #include <getopt.h>
 #include <string.h>
@@ -98,6 +99,30 @@ static void add_port(string &ports, const char *symbol, const char *name, const
     ports += ss.str();
 }
 
+/// Control output the plugin writes its current latency to, in samples
+static void add_latency_port(string &ports, int pidx)
+{
+    stringstream ss;
+    const char *ind = "        ";
+
+    if (ports != "") ports += " , ";
+    ss << "[\n";
+    ss << ind << "a lv2:OutputPort ;\n";
+    ss << ind << "a lv2:ControlPort ;\n";
+    ss << ind << "lv2:index " << pidx << " ;\n";
+    ss << ind << "lv2:symbol \"latency\" ;\n";
+    ss << ind << "lv2:name \"Latency\" ;\n";
+    ss << ind << "lv2:designation lv2:latency ;\n";
+    ss << ind << "lv2:portProperty lv2:reportsLatency ;\n";
+    ss << ind << "lv2:portProperty lv2:integer ;\n";
+    ss << ind << "lv2:portProperty epp:notOnGUI ;\n";
+    ss << ind << "ue:unit ue:frame ;\n";
+    ss << ind << "lv2:minimum 0 ;\n";
+    ss << ind << "lv2:default 0 ;\n";
+    ss << "    ]";
+    ports += ss.str();
+}
+
 static const char *units[] = { 
     "ue:db", 
     "ue:coef",
@@ -367,6 +392,10 @@ void make_ttl(string path_prefix, const string *data_dir)
             }
         }
         
+        // configure calls and module jobs go to the worker when the host has one
+        ttl += "    lv2:optionalFeature <" LV2_WORKER__schedule "> ;\n";
+        ttl += "    lv2:extensionData <" LV2_WORKER__interface "> ;\n";
+
         vector<string> configure_keys;
         pi->get_configure_vars(configure_keys);
         if (!configure_keys.empty())
@@ -410,6 +439,8 @@ void make_ttl(string path_prefix, const string *data_dir)
         if (needs_event_io) {
             add_port(ports, "events_out", "Events", "Output", pn++, "atom:AtomPort", true);
         }
+        if (pi->reports_latency())
+            add_latency_port(ports, pn++);
         if (!ports.empty())
             ttl += "    lv2:port " + ports + "\n";
         ttl += ".\n\n";
@@ -181,6 +181,26 @@ CALF_PLUGIN_INFO(reverb) = { 0x847e, "Reverb", "Calf Reverb", "Calf Studio Gear"
 
 ////////////////////////////////////////////////////////////////////////////
 
+CALF_PORT_NAMES(conv_reverb) = {"In L", "In R", "Out L", "Out R"};
+
+CALF_PORT_PROPS(conv_reverb) = {
+    BYPASS_AND_LEVEL_PARAMS
+    METERING_PARAMS
+    { 1.0,        0,    2,    0, PF_FLOAT | PF_SCALE_GAIN | PF_CTL_KNOB | PF_UNIT_COEF | PF_PROP_NOBOUNDS, NULL, "dry", "Dry Amount" },
+    { 0.25,       0,    2,    0, PF_FLOAT | PF_SCALE_GAIN | PF_CTL_KNOB | PF_UNIT_COEF | PF_PROP_NOBOUNDS, NULL, "wet", "Wet Amount" },
+    { 0,          0,   30,    0, PF_FLOAT | PF_SCALE_LINEAR | PF_CTL_LABEL | PF_UNIT_SEC | PF_PROP_OUTPUT | PF_PROP_OPTIONAL, NULL, "ir_length", "IR Length" },
+    {}
+};
+
+CALF_PLUGIN_INFO(conv_reverb) = { 0x8487, "ConvolutionReverb", "Calf Convolution Reverb", "Calf Studio Gear", calf_plugins::calf_copyright_info, "ReverbPlugin" };
+
+void conv_reverb_metadata::get_configure_vars(vector<string> &names) const
+{
+    names.push_back("ir_file");
+}
+
+////////////////////////////////////////////////////////////////////////////
+
 CALF_PORT_NAMES(filter) = {"In L", "In R", "Out L", "Out R"};
 
 const char *filter_choices[] = {
@@ -35,6 +35,38 @@ mod_matrix_impl::mod_matrix_impl(dsp::modulation_entry *_matrix, mod_matrix_meta
     matrix_rows = metadata->get_table_rows();
     for (unsigned int i = 0; i < matrix_rows; i++)
         matrix[i].reset();
+    routes.resize(matrix_rows);
+    route_count = linear_count = 0;
+    routes_dirty = 1;
+}
+
+void mod_matrix_impl::compile_routes()
+{
+    __atomic_store_n(&routes_dirty, 0, __ATOMIC_RELAXED);
+    int count = 0;
+    // two passes, so that the linear mappings end up in front
+    for (int pass = 0; pass < 2; pass++)
+    {
+        if (pass)
+            linear_count = count;
+        for (unsigned int i = 0; i < matrix_rows; i++)
+        {
+            const modulation_entry &slot = matrix[i];
+            if (!slot.dest || slot.amount == 0.f)
+                continue;
+            const float *c = scaling_coeffs[slot.mapping];
+            if ((c[2] != 0.f) != (pass == 1))
+                continue;
+            compiled_route &r = routes[count++];
+            r.src1 = slot.src1;
+            r.src2 = slot.src2;
+            r.dest = slot.dest;
+            r.c0 = c[0] * slot.amount;
+            r.c1 = c[1] * slot.amount;
+            r.c2 = c[2] * slot.amount;
+        }
+    }
+    route_count = count;
 }
 
 const float mod_matrix_impl::scaling_coeffs[mod_matrix_metadata::map_type_count][3] = {
@@ -149,6 +181,7 @@ char *mod_matrix_impl::configure(const char *key, const char *value)
                 case 3: slot.amount = src->amount; break;
                 case 4: slot.dest = src->dest; break;                    
                 }
+                __atomic_store_n(&routes_dirty, 1, __ATOMIC_RELEASE);
                 return NULL;
             }
             const table_column_info &ci = metadata->get_table_columns()[column];
@@ -160,6 +193,7 @@ char *mod_matrix_impl::configure(const char *key, const char *value)
             value = value_text.c_str();
         }
         set_cell(row, column, value, error);
+        __atomic_store_n(&routes_dirty, 1, __ATOMIC_RELEASE);
         if (!error.empty())
             return strdup(error.c_str());
     }
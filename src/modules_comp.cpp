@@ -18,6 +18,7 @@
  * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
  * Boston, MA  02110-1301  USA
  */
+#include <float.h>
 #include <limits.h>
 #include <memory.h>
 #include <calf/audio_fx.h>
@@ -89,40 +90,93 @@ void gain_reduction_audio_module::update_curve()
 }
 
 void gain_reduction_audio_module::process(float &left, float &right, const float *det_left, const float *det_right)
+{
+    process_block(&left, &right, &left, &right, 1, det_left, det_right);
+}
+
+void gain_reduction_audio_module::process_block(const float *in_left, const float *in_right, float *out_left, float *out_right, uint32_t numsamples, const float *det_left, const float *det_right, float *gains)
 {
     if(!det_left) {
-        det_left = &left;
+        det_left = in_left;
     }
     if(!det_right) {
-        det_right = &right;
-    }
-    float gain = 1.f;
-    if(bypass < 0.5f) {
-        // this routine is mainly copied from thor's compressor module
-        // greatest sounding compressor I've heard!
-        bool rms = (detection == 0);
-        bool average = (stereo_link == 0);
-        float attack_coeff = std::min(1.f, 1.f / (attack * srate / 4000.f));
-        float release_coeff = std::min(1.f, 1.f / (release * srate / 4000.f));
-
-        float absample = average ? (fabs(*det_left) + fabs(*det_right)) * 0.5f : std::max(fabs(*det_left), fabs(*det_right));
-        if(rms) absample *= absample;
+        det_right = in_right;
+    }
+    if(bypass >= 0.5f) {
+        if (out_left != in_left)
+            memcpy(out_left, in_left, numsamples * sizeof(float));
+        if (out_right != in_right)
+            memcpy(out_right, in_right, numsamples * sizeof(float));
+        if (gains)
+            std::fill(gains, gains + numsamples, 1.f);
+        return;
+    }
+    // this routine is mainly copied from thor's compressor module
+    // greatest sounding compressor I've heard!
+    bool rms = (detection == 0);
+    bool average = (stereo_link == 0);
+    float attack_coeff = std::min(1.f, 1.f / (attack * srate / 4000.f));
+    float release_coeff = std::min(1.f, 1.f / (release * srate / 4000.f));
+    float envelope[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
+    uint32_t count = 0;
+
+    for (uint32_t offset = 0; offset < numsamples; offset += count) {
+        count = std::min<uint32_t>(numsamples - offset, MAX_SAMPLE_RUN);
+        // the envelope follower depends on the previous sample, so it stays serial
+        float slope = linSlope;
+        for (uint32_t i = 0; i < count; i++) {
+            float l = fabs(det_left[offset + i]);
+            float r = fabs(det_right[offset + i]);
+            float absample = average ? (l + r) * 0.5f : std::max(l, r);
+            if(rms) absample *= absample;
+            dsp::sanitize(slope);
+            slope += (absample - slope) * (absample > slope ? attack_coeff : release_coeff);
+            envelope[i] = slope;
+        }
+        linSlope = slope;
 
-        dsp::sanitize(linSlope);
+        compute_gains(envelope, gain, count, rms);
 
-        linSlope += (absample - linSlope) * (absample > linSlope ? attack_coeff : release_coeff);
-        
-        if(linSlope > 0.f) {
-            gain = output_gain(linSlope, rms);
+        for (uint32_t i = 0; i < count; i++) {
+            out_left[offset + i] = in_left[offset + i] * gain[i] * makeup;
+            out_right[offset + i] = in_right[offset + i] * gain[i] * makeup;
         }
-        left *= gain * makeup;
-        right *= gain * makeup;
-        meter_out = std::max(fabs(left), fabs(right));;
-        meter_comp = gain;
+        if (gains)
+            memcpy(gains + offset, gain, count * sizeof(float));
+    }
+    if (numsamples) {
+        meter_out = std::max(fabs(out_left[numsamples - 1]), fabs(out_right[numsamples - 1]));
+        meter_comp = gain[count - 1];
         detected = rms ? sqrt(linSlope) : linSlope;
     }
 }
 
+void gain_reduction_audio_module::compute_gains(const float *slopes, float *gains, uint32_t count, bool rms) const
+{
+    // same curve as output_gain(), but without branches, so that the loop
+    // gets vectorized (the knee is a precomputed hermite polynomial)
+    float kneeThres = rms ? adjKneeStart : linKneeStart;
+    float delta = IS_FAKE_INFINITY(ratio) ? 0.f : 1.f / ratio;
+    float log_scale = rms ? 0.5f * (float)M_LN2 : (float)M_LN2;
+    float width = kneeStop - kneeStart;
+    float kneeLimit = knee > 1.f ? kneeStop : -FLT_MAX;
+    float invWidth = knee > 1.f ? 1.f / width : 0.f;
+    float ct0 = kneeStart;
+    float ct1 = width;
+    float ct2 = -3 * kneeStart - 2 * width + 3 * compressedKneeStop - delta * width;
+    float ct3 = 2 * kneeStart + width - 2 * compressedKneeStop + delta * width;
+    float x0 = kneeStart, th = thres;
+    for (uint32_t i = 0; i < count; i++) {
+        float slope = dsp::fast_log2(std::max(slopes[i], FLT_MIN)) * log_scale;
+        float gain = (slope - th) * delta + th;
+        float t = (slope - x0) * invWidth;
+        float kneeGain = ((ct3 * t + ct2) * t + ct1) * t + ct0;
+        gain = slope < kneeLimit ? kneeGain : gain;
+        float g = dsp::fast_exp2((gain - slope) * (float)M_LOG2E);
+        gains[i] = slopes[i] > kneeThres ? g : 1.f;
+    }
+}
+
 float gain_reduction_audio_module::output_level(float slope) const {
     return slope * output_gain(slope, false) * makeup;
 }
@@ -318,44 +372,66 @@ void gain_reduction2_audio_module::update_curve()
 
 void gain_reduction2_audio_module::process(float &left)
 {
-    if(bypass < 0.5f) {
-        float width=(knee-0.99f)*8.f;
-        float cdb=0.f;
-        float attack_coeff = exp(-1000.f/(attack * srate));
-        float release_coeff = exp(-1000.f/(release * srate));
-        float thresdb=20.f*log10(threshold);
-
-        float gain = 1.f;
-        float xg, xl, yg, yl, y1;
-        yg=0.f;
-        xg = (left==0.f) ? -160.f : 20.f*log10(fabs(left));
-
-        if (2.f*(xg-thresdb)<-width) {
-            yg = xg;
-        }
-        if (2.f*fabs(xg-thresdb)<=width) {
-            yg = xg + (1.f/ratio-1.f)*(xg-thresdb+width/2.f)*(xg-thresdb+width/2.f)/(2.f*width);
+    process_block(&left, &left, 1);
+}
+
+void gain_reduction2_audio_module::process_block(const float *in, float *out, uint32_t numsamples, float *gains)
+{
+    if(bypass >= 0.5f) {
+        if (out != in)
+            memcpy(out, in, numsamples * sizeof(float));
+        if (gains)
+            std::fill(gains, gains + numsamples, 1.f);
+        return;
+    }
+    float width=(knee-0.99f)*8.f;
+    float attack_coeff = exp(-1000.f/(attack * srate));
+    float release_coeff = exp(-1000.f/(release * srate));
+    float thresdb=20.f*log10(threshold);
+    // 20 * log10(x) = log2(x) * db_per_octave, 10^(x / 20) = 2^(x / db_per_octave)
+    const float db_per_octave = 20.f * log10(2.f);
+    float rat = ratio;
+    float xl[MAX_SAMPLE_RUN], yg[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
+    uint32_t count = 0;
+
+    for (uint32_t offset = 0; offset < numsamples; offset += count) {
+        count = std::min<uint32_t>(numsamples - offset, MAX_SAMPLE_RUN);
+        // gain computer - no dependencies between samples, gets vectorized
+        for (uint32_t i = 0; i < count; i++) {
+            float x = fabs(in[offset + i]);
+            float xg = x == 0.f ? -160.f : dsp::fast_log2(std::max(x, FLT_MIN)) * db_per_octave;
+            float knee_part = xg - thresdb + width/2.f;
+            float y = 0.f;
+            y = 2.f*(xg-thresdb)<-width ? xg : y;
+            y = 2.f*fabs(xg-thresdb)<=width ? xg + (1.f/rat-1.f)*knee_part*knee_part/(2.f*width) : y;
+            y = 2.f*(xg-thresdb)>width ? thresdb + (xg-thresdb)/rat : y;
+            yg[i] = y;
+            xl[i] = xg - y;
         }
-        if (2.f*(xg-thresdb)>width) {
-            yg = thresdb + (xg-thresdb)/ratio;
+        // level detector - serial
+        float y1 = old_y1, yl = old_yl;
+        for (uint32_t i = 0; i < count; i++) {
+            y1 = std::max(xl[i], release_coeff*y1+(1.f-release_coeff)*xl[i]);
+            yl = attack_coeff*yl+(1.f-attack_coeff)*y1;
+            gain[i] = -yl;
         }
-            
-        xl = xg - yg;
-            
-        y1 = std::max(xl, release_coeff*old_y1+(1.f-release_coeff)*xl);
-        yl = attack_coeff*old_yl+(1.f-attack_coeff)*y1;
-        
-        cdb = -yl;
-        gain = exp(cdb/20.f*log(10.f));
-
-    left *= gain * makeup;
-    meter_out = (fabs(left));
-        meter_comp = gain;
-    detected = (exp(yg/20.f*log(10.f))+old_detected)/2.f;
-    old_detected = detected;
-
-        old_yl = yl;
         old_y1 = y1;
+        old_yl = yl;
+        for (uint32_t i = 0; i < count; i++) {
+            gain[i] = dsp::fast_exp2(gain[i] / db_per_octave);
+            out[offset + i] = in[offset + i] * gain[i] * makeup;
+            yg[i] = dsp::fast_exp2(yg[i] / db_per_octave);
+        }
+        float det = old_detected;
+        for (uint32_t i = 0; i < count; i++)
+            det = (yg[i] + det) / 2.f;
+        detected = old_detected = det;
+        if (gains)
+            memcpy(gains + offset, gain, count * sizeof(float));
+    }
+    if (numsamples) {
+        meter_out = fabs(out[numsamples - 1]);
+        meter_comp = gain[count - 1];
     }
 }
 
@@ -558,35 +634,88 @@ void expander_audio_module::update_curve()
 }
 
 void expander_audio_module::process(float &left, float &right, const float *det_left, const float *det_right)
+{
+    process_block(&left, &right, &left, &right, 1, det_left, det_right);
+}
+
+void expander_audio_module::process_block(const float *in_left, const float *in_right, float *out_left, float *out_right, uint32_t numsamples, const float *det_left, const float *det_right, float *gains)
 {
     if(!det_left) {
-        det_left = &left;
+        det_left = in_left;
     }
     if(!det_right) {
-        det_right = &right;
-    }
-    if(bypass < 0.5f) {
-        // this routine is mainly copied from Damien's expander module based on Thor's compressor
-        bool rms = (detection == 0);
-        bool average = (stereo_link == 0);
-        float absample = average ? (fabs(*det_left) + fabs(*det_right)) * 0.5f : std::max(fabs(*det_left), fabs(*det_right));
-        if(rms) absample *= absample;
+        det_right = in_right;
+    }
+    if(bypass >= 0.5f) {
+        if (out_left != in_left)
+            memcpy(out_left, in_left, numsamples * sizeof(float));
+        if (out_right != in_right)
+            memcpy(out_right, in_right, numsamples * sizeof(float));
+        if (gains)
+            std::fill(gains, gains + numsamples, 1.f);
+        return;
+    }
+    // this routine is mainly copied from Damien's expander module based on Thor's compressor
+    bool rms = (detection == 0);
+    bool average = (stereo_link == 0);
+    float envelope[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
+    uint32_t count = 0;
+
+    for (uint32_t offset = 0; offset < numsamples; offset += count) {
+        count = std::min<uint32_t>(numsamples - offset, MAX_SAMPLE_RUN);
+        float slope = linSlope;
+        for (uint32_t i = 0; i < count; i++) {
+            float l = fabs(det_left[offset + i]);
+            float r = fabs(det_right[offset + i]);
+            float absample = average ? (l + r) * 0.5f : std::max(l, r);
+            if(rms) absample *= absample;
+            dsp::sanitize(slope);
+            slope += (absample - slope) * (absample > slope ? attack_coeff : release_coeff);
+            envelope[i] = slope;
+        }
+        linSlope = slope;
 
-        dsp::sanitize(linSlope);
+        compute_gains(envelope, gain, count);
 
-        linSlope += (absample - linSlope) * (absample > linSlope ? attack_coeff : release_coeff);
-        float gain = 1.f;
-        if(linSlope > 0.f) {
-            gain = output_gain(linSlope, rms);
+        for (uint32_t i = 0; i < count; i++) {
+            out_left[offset + i] = in_left[offset + i] * gain[i] * makeup;
+            out_right[offset + i] = in_right[offset + i] * gain[i] * makeup;
         }
-        left *= gain * makeup;
-        right *= gain * makeup;
-        meter_out = std::max(fabs(left), fabs(right));
-        meter_gate = gain;
+        if (gains)
+            memcpy(gains + offset, gain, count * sizeof(float));
+    }
+    if (numsamples) {
+        meter_out = std::max(fabs(out_left[numsamples - 1]), fabs(out_right[numsamples - 1]));
+        meter_gate = gain[count - 1];
         detected = linSlope;
     }
 }
 
+void expander_audio_module::compute_gains(const float *slopes, float *gains, uint32_t count) const
+{
+    // same curve as output_gain(), but without branches, so that the loop
+    // gets vectorized (the knee is a precomputed hermite polynomial)
+    float tratio = IS_FAKE_INFINITY(ratio) ? 1000.f : ratio;
+    float width = kneeStop - kneeStart;
+    float kneeLimit = knee > 1.f ? kneeStart : FLT_MAX;
+    float invWidth = knee > 1.f ? 1.f / width : 0.f;
+    float p0 = (kneeStart - thres) * tratio + thres;
+    float ct0 = p0;
+    float ct1 = tratio * width;
+    float ct2 = -3 * p0 - 2 * tratio * width + 3 * kneeStop - width;
+    float ct3 = 2 * p0 + tratio * width - 2 * kneeStop + width;
+    float x0 = kneeStart, th = thres, minGain = range, limit = linKneeStop;
+    for (uint32_t i = 0; i < count; i++) {
+        float slope = dsp::fast_log2(std::max(slopes[i], FLT_MIN)) * (float)M_LN2;
+        float gain = (slope - th) * tratio + th;
+        float t = (slope - x0) * invWidth;
+        float kneeGain = ((ct3 * t + ct2) * t + ct1) * t + ct0;
+        gain = slope > kneeLimit ? kneeGain : gain;
+        float g = std::max(minGain, dsp::fast_exp2((gain - slope) * (float)M_LOG2E));
+        gains[i] = (slopes[i] > 0.f && slopes[i] < limit) ? g : 1.f;
+    }
+}
+
 float expander_audio_module::output_level(float slope) const {
     bool rms = (detection == 0);
     return slope * output_gain(rms ? slope*slope : slope, rms) * makeup;
@@ -764,58 +893,55 @@ void compressor_audio_module::set_sample_rate(uint32_t sr)
 uint32_t compressor_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
         // displays, too
-    } else {
+    } else if (orig_numsamples) {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         compressor.update_curve();
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            float outR = 0.f;
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
-            float Lin = ins[0][offset];
-            float Rin = ins[1][offset];
-            
-            // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
+        float level_in = *params[param_level_in];
+        float mix = *params[param_mix];
+        float leftAC[MAX_SAMPLE_RUN], rightAC[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
+        float meter_in[MAX_SAMPLE_RUN], meter_out[MAX_SAMPLE_RUN];
 
-            float leftAC = inL;
-            float rightAC = inR;
+        // in level
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
+            leftAC[i] = ins[0][offset + i] * level_in;
+            rightAC[i] = ins[1][offset + i] * level_in;
+        }
 
-            compressor.process(leftAC, rightAC);
+        compressor.process_block(leftAC, rightAC, leftAC, rightAC, orig_numsamples, NULL, NULL, gain);
 
-            outL = leftAC;
-            outR = rightAC;
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float Lin = ins[0][offset];
+            float Rin = ins[1][offset];
+            float inL = Lin * level_in;
+            float inR = Rin * level_in;
 
             // mix
-            outL = outL * *params[param_mix] + Lin * (*params[param_mix] * -1 + 1);
-            outR = outR * *params[param_mix] + Rin * (*params[param_mix] * -1 + 1);
-                
+            float outL = leftAC[i] * mix + Lin * (mix * -1 + 1);
+            float outR = rightAC[i] * mix + Rin * (mix * -1 + 1);
+
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
 
-            float values[] = {std::max(inL, inR), std::max(outL, outR), compressor.get_comp_level()};
-            meters.process(values);
-            
-            // next sample
-            ++offset;
+            meter_in[i] = std::max(inL, inR);
+            meter_out[i] = std::max(outL, outR);
         } // cycle trough samples
+        const float *values[] = {meter_in, meter_out, gain};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     }
     meters.fall(numsamples);
@@ -1041,60 +1167,52 @@ void sidechaincompressor_audio_module::set_sample_rate(uint32_t sr)
 uint32_t sidechaincompressor_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 1};
-            meters.process(values);
             ++offset;
         }
-    } else {
+        meters.process(NULL, orig_numsamples);
+    } else if (orig_numsamples) {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         compressor.update_curve();
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            float outR = 0.f;
-            float inL  = ins[0][offset];
-            float inR  = ins[1][offset];
-            float Lin  = ins[0][offset];
-            float Rin  = ins[1][offset];
-            
-            float in2L = ins[2] ? ins[2][offset] : 0;
-            float in2R = ins[3] ? ins[3][offset] : 0;
-            
+        float level_in = *params[param_level_in];
+        float mix = *params[param_mix];
+        bool route = *params[param_sc_route] > 0.5;
+        float sc_level = *params[param_sc_level];
+        CalfScModes mode = (CalfScModes)*params[param_sc_mode];
+        bool split = mode == DEESSER_SPLIT || mode == DERUMBLER_SPLIT;
+        float leftAC[MAX_SAMPLE_RUN], rightAC[MAX_SAMPLE_RUN];
+        float leftSC[MAX_SAMPLE_RUN], rightSC[MAX_SAMPLE_RUN];
+        float leftMC[MAX_SAMPLE_RUN], rightMC[MAX_SAMPLE_RUN];
+        float gain[MAX_SAMPLE_RUN];
+        float meter_in[MAX_SAMPLE_RUN], meter_out[MAX_SAMPLE_RUN];
+
+        // filter the sidechain first, the compressor works on the whole block
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
             // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
-
-            float leftAC  = inL;
-            float rightAC = inR;
-            float leftSC  = inL;
-            float rightSC = inR;
-            float leftMC  = inL;
-            float rightMC = inR;
-            
-            if (*params[param_sc_route] > 0.5) {
-                leftAC  = inL;
-                rightAC = inR;
-                leftSC  = in2L * *params[param_sc_level];
-                rightSC = in2R * *params[param_sc_level];
-                leftMC  = inL;
-                rightMC = inR;
+            float inL = ins[0][offset + i] * level_in;
+            float inR = ins[1][offset + i] * level_in;
+
+            float lAC = inL;
+            float rAC = inR;
+            float lSC = inL;
+            float rSC = inR;
+
+            if (route) {
+                lSC = (ins[2] ? ins[2][offset + i] : 0) * sc_level;
+                rSC = (ins[3] ? ins[3][offset + i] : 0) * sc_level;
             }
-            
-            switch ((CalfScModes)*params[param_sc_mode]) {
+
+            switch (mode) {
                 default:
                 case WIDEBAND:
-                    compressor.process(leftAC, rightAC, &leftSC, &rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
                     break;
                 case DEESSER_WIDE:
                 case DERUMBLER_WIDE:
@@ -1102,64 +1220,70 @@ uint32_t sidechaincompressor_audio_module::process(uint32_t offset, uint32_t num
                 case WEIGHTED_2:
                 case WEIGHTED_3:
                 case BANDPASS_2:
-                    leftSC  = f2L.process(f1L.process(leftSC));
-                    rightSC = f2R.process(f1R.process(rightSC));
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    compressor.process(leftAC, rightAC, &leftSC, &rightSC);
+                    lSC = f2L.process(f1L.process(lSC));
+                    rSC = f2R.process(f1R.process(rSC));
                     break;
                 case DEESSER_SPLIT:
-                    leftSC  = f2L.process(leftSC);
-                    rightSC = f2R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    compressor.process(leftSC, rightSC, &leftSC, &rightSC);
-                    leftAC   = f1L.process(leftAC);
-                    rightAC  = f1R.process(rightAC);
-                    leftAC  += leftSC;
-                    rightAC += rightSC;
+                    lSC = f2L.process(lSC);
+                    rSC = f2R.process(rSC);
+                    lAC = f1L.process(lAC);
+                    rAC = f1R.process(rAC);
                     break;
                 case DERUMBLER_SPLIT:
-                    leftSC  = f1L.process(leftSC);
-                    rightSC = f1R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    compressor.process(leftSC, rightSC, &leftSC, &rightSC);
-                    leftAC   = f2L.process(leftAC);
-                    rightAC  = f2R.process(rightAC);
-                    leftAC  += leftSC;
-                    rightAC += rightSC;
+                    lSC = f1L.process(lSC);
+                    rSC = f1R.process(rSC);
+                    lAC = f2L.process(lAC);
+                    rAC = f2R.process(rAC);
                     break;
                 case BANDPASS_1:
-                    leftSC  = f1L.process(leftSC);
-                    rightSC = f1R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    compressor.process(leftAC, rightAC, &leftSC, &rightSC);
+                    lSC = f1L.process(lSC);
+                    rSC = f1R.process(rSC);
                     break;
             }
+            leftAC[i]  = lAC;
+            rightAC[i] = rAC;
+            leftSC[i]  = leftMC[i]  = lSC;
+            rightSC[i] = rightMC[i] = rSC;
+        }
 
-            if(*params[param_sc_listen] > 0.f) {
-                outL = leftMC;
-                outR = rightMC;
+        if (split) {
+            // compress the filtered band only and add it to the rest
+            compressor.process_block(leftSC, rightSC, leftSC, rightSC, orig_numsamples, NULL, NULL, gain);
+            for (uint32_t i = 0; i < orig_numsamples; i++) {
+                leftAC[i]  += leftSC[i];
+                rightAC[i] += rightSC[i];
+            }
+        } else
+            compressor.process_block(leftAC, rightAC, leftAC, rightAC, orig_numsamples, leftSC, rightSC, gain);
+
+        bool listen = *params[param_sc_listen] > 0.f;
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float outL = 0.f;
+            float outR = 0.f;
+            float Lin  = ins[0][offset];
+            float Rin  = ins[1][offset];
+            float inL  = Lin * level_in;
+            float inR  = Rin * level_in;
+
+            if(listen) {
+                outL = leftMC[i];
+                outR = rightMC[i];
             } else {
-                outL = leftAC;
-                outR = rightAC;
                 // mix
-                outL = outL * *params[param_mix] + Lin * (*params[param_mix] * -1 + 1);
-                outR = outR * *params[param_mix] + Rin * (*params[param_mix] * -1 + 1);
+                outL = leftAC[i] * mix + Lin * (mix * -1 + 1);
+                outR = rightAC[i] * mix + Rin * (mix * -1 + 1);
             }
 
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
-            
-            float values[] = {std::max(inL, inR), std::max(outL, outR), compressor.get_comp_level()};
-            meters.process(values);
-            
-            // next sample
-            ++offset;
+
+            meter_in[i] = std::max(inL, inR);
+            meter_out[i] = std::max(outL, outR);
         } // cycle trough samples
+        const float *values[] = {meter_in, meter_out, gain};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         f1L.sanitize();
         f1R.sanitize();
@@ -1312,6 +1436,8 @@ void multibandcompressor_audio_module::set_sample_rate(uint32_t sr)
 uint32_t multibandcompressor_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     
     for (int i = 0; i < strips; i++)
@@ -1321,60 +1447,82 @@ uint32_t multibandcompressor_audio_module::process(uint32_t offset, uint32_t num
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process all strips
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
-        while(offset < numsamples) {
-            // cycle through samples
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
+        float level_in = *params[param_level_in];
+        float level_out = *params[param_level_out];
+        float bandL[strips][MAX_SAMPLE_RUN], bandR[strips][MAX_SAMPLE_RUN], gain[strips][MAX_SAMPLE_RUN];
+        bool active[strips];
+        bool strip_bypass[] = {*params[param_bypass0] > 0.5f, *params[param_bypass1] > 0.5f, *params[param_bypass2] > 0.5f, *params[param_bypass3] > 0.5f};
+        for (int i = 0; i < strips; i++)
+            active[i] = solo[i] || no_solo;
+
+        // split into bands
+        for (uint32_t j = 0; j < orig_numsamples; j++) {
             // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
+            xin[0] = ins[0][offset + j] * level_in;
+            xin[1] = ins[1][offset + j] * level_in;
             // process crossover
-            xin[0] = inL;
-            xin[1] = inR;
             crossover.process(xin);
+            for (int i = 0; i < strips; i++) {
+                bandL[i][j] = crossover.get_value(0, i);
+                bandR[i][j] = crossover.get_value(1, i);
+            }
+        }
+
+        // process gain reduction of the unmuted strips
+        for (int i = 0; i < strips; i++) {
+            if (active[i])
+                strip[i].process_block(bandL[i], bandR[i], bandL[i], bandR[i], orig_numsamples, NULL, NULL, gain[i]);
+        }
+
+        float strip_out[strips][MAX_SAMPLE_RUN];
+        while(offset < numsamples) {
+            // cycle through samples
+            uint32_t j = offset - orig_offset;
             // out vars
             float outL = 0.f;
             float outR = 0.f;
             for (int i = 0; i < strips; i ++) {
                 // cycle trough strips
-                if (solo[i] || no_solo) {
-                    // strip unmuted
-                    float left  = crossover.get_value(0, i);
-                    float right = crossover.get_value(1, i);
-                    // process gain reduction
-                    strip[i].process(left, right);
+                if (active[i]) {
                     // sum up output
-                    outL += left;
-                    outR += right;
+                    outL += bandL[i][j];
+                    outR += bandR[i][j];
+                    strip_out[i][j] = std::max(fabs(bandL[i][j]), fabs(bandR[i][j]));
                 }
             } // process single strip
 
             // out level
-            outL *= *params[param_level_out];
-            outR *= *params[param_level_out];
+            outL *= level_out;
+            outR *= level_out;
 
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
-            
-            float values[] = {inL, inR, outL, outR,
-                *params[param_bypass0] > 0.5f ? 0 : strip[0].get_output_level(), *params[param_bypass0] > 0.5f ? 1 : strip[0].get_comp_level(),
-                *params[param_bypass1] > 0.5f ? 0 : strip[1].get_output_level(), *params[param_bypass1] > 0.5f ? 1 : strip[1].get_comp_level(),
-                *params[param_bypass2] > 0.5f ? 0 : strip[2].get_output_level(), *params[param_bypass2] > 0.5f ? 1 : strip[2].get_comp_level(),
-                *params[param_bypass3] > 0.5f ? 0 : strip[3].get_output_level(), *params[param_bypass3] > 0.5f ? 1 : strip[3].get_comp_level() };
-            meters.process(values);
                 
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[4 + 2 * strips] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[4 + 2 * strips];
+        dsp::fill(scale, 1.f, 4 + 2 * strips);
+        scale[0] = scale[1] = level_in;
+        for (int i = 0; i < strips; i++) {
+            if (strip_bypass[i])
+                continue;
+            if (!active[i]) {
+                // muted strips keep showing their last state
+                dsp::fill(strip_out[i], strip[i].get_output_level(), orig_numsamples);
+                dsp::fill(gain[i], strip[i].get_comp_level(), orig_numsamples);
+            }
+            values[4 + 2 * i] = strip_out[i];
+            values[5 + 2 * i] = gain[i];
+        }
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process all strips (no bypass)
     meters.fall(numsamples);
@@ -1500,56 +1648,44 @@ void monocompressor_audio_module::set_sample_rate(uint32_t sr)
 uint32_t monocompressor_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
-            float values[] = {0, 0, 1};
-            meters.process(values);
             ++offset;
         }
-    } else {
+        meters.process(NULL, orig_numsamples);
+    } else if (orig_numsamples) {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         monocompressor.update_curve();
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            //float outR = 0.f;
-            float inL = ins[0][offset];
-            //float inR = ins[1][offset];
-            float Lin = ins[0][offset];
-            //float Rin = ins[1][offset];
-            
-            // in level
-            //inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
+        float level_in = *params[param_level_in];
+        float mix = *params[param_mix];
+        float leftAC[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
 
-            float leftAC = inL;
-            //float rightAC = inR;
+        // in level
+        for (uint32_t i = 0; i < orig_numsamples; i++)
+            leftAC[i] = ins[0][offset + i] * level_in;
 
-            monocompressor.process(leftAC);
+        monocompressor.process_block(leftAC, leftAC, orig_numsamples, gain);
+
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float Lin = ins[0][offset];
 
-            outL = leftAC;
-            //outR = rightAC;
-            
             // mix
-            outL = outL * *params[param_mix] + Lin * (*params[param_mix] * -1 + 1);
-            //outR = outR * *params[param_mix] + Rin * (*params[param_mix] * -1 + 1);
-                
+            float outL = leftAC[i] * mix + Lin * (mix * -1 + 1);
+
             // send to output
             outs[0][offset] = outL;
-            //outs[1][offset] = 0.f;
-            
-            float values[] = {inL, outL, monocompressor.get_comp_level()};
-            meters.process(values);
-            
-            // next sample
-            ++offset;
+
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, outs[0] + orig_offset, gain};
+        float scale[] = {level_in, 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 1, orig_offset, orig_numsamples);
     }
     meters.fall(numsamples);
@@ -1661,6 +1797,8 @@ void deesser_audio_module::set_sample_rate(uint32_t sr)
 uint32_t deesser_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     detected_led -= std::min(detected_led,  numsamples);
     float gain = 1.f;
@@ -1669,77 +1807,65 @@ uint32_t deesser_audio_module::process(uint32_t offset, uint32_t numsamples, uin
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 1};
-            meters.process(values);
             ++offset;
         }
-    } else {
+        meters.process(NULL, orig_numsamples);
+    } else if (orig_numsamples) {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         compressor.update_curve();
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            float outR = 0.f;
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
-
-
-            float leftAC = inL;
-            float rightAC = inR;
-            float leftSC = inL;
-            float rightSC = inR;
-            float leftRC = inL;
-            float rightRC = inR;
-            float leftMC = inL;
-            float rightMC = inR;
-
-            leftSC = pL.process(hpL.process(leftSC));
-            rightSC = pR.process(hpR.process(rightSC));
-            leftMC = leftSC;
-            rightMC = rightSC;
-
-            switch ((int)*params[param_mode]) {
-                default:
-                case WIDE:
-                    compressor.process(leftAC, rightAC, &leftSC, &rightSC);
-                    break;
-                case SPLIT:
-                    hpL.sanitize();
-                    hpR.sanitize();
-                    leftRC = hpL.process(leftRC);
-                    rightRC = hpR.process(rightRC);
-                    compressor.process(leftRC, rightRC, &leftSC, &rightSC);
-                    leftAC = lpL.process(leftAC);
-                    rightAC = lpR.process(rightAC);
-                    leftAC += leftRC;
-                    rightAC += rightRC;
-                    break;
+        bool split = (int)*params[param_mode] == SPLIT;
+        float leftAC[MAX_SAMPLE_RUN], rightAC[MAX_SAMPLE_RUN];
+        float leftSC[MAX_SAMPLE_RUN], rightSC[MAX_SAMPLE_RUN];
+        float leftRC[MAX_SAMPLE_RUN], rightRC[MAX_SAMPLE_RUN];
+        float comp[MAX_SAMPLE_RUN], meter_detected[MAX_SAMPLE_RUN];
+
+        // filters first, the compressor works on the whole block
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
+            float inL = ins[0][offset + i];
+            float inR = ins[1][offset + i];
+
+            leftSC[i] = pL.process(hpL.process(inL));
+            rightSC[i] = pR.process(hpR.process(inR));
+
+            if (split) {
+                hpL.sanitize();
+                hpR.sanitize();
+                leftRC[i] = hpL.process(inL);
+                rightRC[i] = hpR.process(inR);
+                leftAC[i] = lpL.process(inL);
+                rightAC[i] = lpR.process(inR);
+            } else {
+                leftAC[i] = inL;
+                rightAC[i] = inR;
             }
+        }
 
-            if(*params[param_sc_listen] > 0.f) {
-                outL = leftMC;
-                outR = rightMC;
-            } else {
-                outL = leftAC;
-                outR = rightAC;
+        if (split) {
+            compressor.process_block(leftRC, rightRC, leftRC, rightRC, orig_numsamples, leftSC, rightSC, comp);
+            for (uint32_t i = 0; i < orig_numsamples; i++) {
+                leftAC[i] += leftRC[i];
+                rightAC[i] += rightRC[i];
             }
+        } else
+            compressor.process_block(leftAC, rightAC, leftAC, rightAC, orig_numsamples, leftSC, rightSC, comp);
+
+        bool listen = *params[param_sc_listen] > 0.f;
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float leftMC = leftSC[i];
+            float rightMC = rightSC[i];
 
             // send to output
-            outs[0][offset] = outL;
-            outs[1][offset] = outR;
+            outs[0][offset] = listen ? leftMC : leftAC[i];
+            outs[1][offset] = listen ? rightMC : rightAC[i];
 
             detected = std::max(fabs(leftMC), fabs(rightMC));
-            
-            float comp = compressor.get_comp_level();
-            float values[] = {detected, comp};
-            meters.process(values);
-            gain = std::min(comp, gain);
-            // next sample
-            ++offset;
+            meter_detected[i] = detected;
+            gain = std::min(comp[i], gain);
         } // cycle trough samples
+        const float *values[] = {meter_detected, comp};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         hpL.sanitize();
         hpR.sanitize();
@@ -1796,49 +1922,49 @@ void gate_audio_module::set_sample_rate(uint32_t sr)
 uint32_t gate_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 1};
-            meters.process(values);
             ++offset;
         }
-    } else {
+        meters.process(NULL, orig_numsamples);
+    } else if (orig_numsamples) {
         // process
         gate.update_curve();
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            float outR = 0.f;
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
-            // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
 
-            float leftAC = inL;
-            float rightAC = inR;
+        float level_in = *params[param_level_in];
+        float leftAC[MAX_SAMPLE_RUN], rightAC[MAX_SAMPLE_RUN], gain[MAX_SAMPLE_RUN];
+        float meter_in[MAX_SAMPLE_RUN], meter_out[MAX_SAMPLE_RUN];
 
-            gate.process(leftAC, rightAC);
+        // in level
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
+            leftAC[i] = ins[0][offset + i] * level_in;
+            rightAC[i] = ins[1][offset + i] * level_in;
+        }
 
-            outL = leftAC;
-            outR = rightAC;
+        gate.process_block(leftAC, rightAC, leftAC, rightAC, orig_numsamples, NULL, NULL, gain);
+
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float inL = ins[0][offset] * level_in;
+            float inR = ins[1][offset] * level_in;
+            float outL = leftAC[i];
+            float outR = rightAC[i];
 
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
             
-            float values[] = {std::max(inL, inR), std::max(outL, outR), gate.get_expander_level()};
-            meters.process(values);
-            
-            // next sample
-            ++offset;
+            meter_in[i] = std::max(inL, inR);
+            meter_out[i] = std::max(outL, outR);
         } // cycle trough samples
+        const float *values[] = {meter_in, meter_out, gain};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     }
     meters.fall(numsamples);
@@ -2058,58 +2184,51 @@ void sidechaingate_audio_module::set_sample_rate(uint32_t sr)
 uint32_t sidechaingate_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 1};
-            meters.process(values);
             ++offset;
         }
-    } else {
+        meters.process(NULL, orig_numsamples);
+    } else if (orig_numsamples) {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         gate.update_curve();
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float outL = 0.f;
-            float outR = 0.f;
-            float inL  = ins[0][offset];
-            float inR  = ins[1][offset];
-            
-            float in2L = ins[2] ? ins[2][offset] : 0;
-            float in2R = ins[3] ? ins[3][offset] : 0;
-            
+        float level_in = *params[param_level_in];
+        bool route = *params[param_sc_route] > 0.5;
+        float sc_level = *params[param_sc_level];
+        CalfScModes mode = (CalfScModes)*params[param_sc_mode];
+        bool split = mode == HIGHGATE_SPLIT || mode == LOWGATE_SPLIT;
+        float leftAC[MAX_SAMPLE_RUN], rightAC[MAX_SAMPLE_RUN];
+        float leftSC[MAX_SAMPLE_RUN], rightSC[MAX_SAMPLE_RUN];
+        float leftMC[MAX_SAMPLE_RUN], rightMC[MAX_SAMPLE_RUN];
+        float gain[MAX_SAMPLE_RUN];
+        float meter_in[MAX_SAMPLE_RUN], meter_out[MAX_SAMPLE_RUN];
+
+        // filter the sidechain first, the gate works on the whole block
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
             // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
-            
-            float leftAC  = inL;
-            float rightAC = inR;
-            float leftSC  = inL;
-            float rightSC = inR;
-            float leftMC  = inL;
-            float rightMC = inR;
-            
-            if (*params[param_sc_route] > 0.5) {
-                leftAC  = inL;
-                rightAC = inR;
-                leftSC  = in2L * *params[param_sc_level];
-                rightSC = in2R * *params[param_sc_level];
-                leftMC  = inL;
-                rightMC = inR;
+            float inL = ins[0][offset + i] * level_in;
+            float inR = ins[1][offset + i] * level_in;
+
+            float lAC = inL;
+            float rAC = inR;
+            float lSC = inL;
+            float rSC = inR;
+
+            if (route) {
+                lSC = (ins[2] ? ins[2][offset + i] : 0) * sc_level;
+                rSC = (ins[3] ? ins[3][offset + i] : 0) * sc_level;
             }
-            
-            switch ((CalfScModes)*params[param_sc_mode]) {
+
+            switch (mode) {
                 default:
                 case WIDEBAND:
-                    gate.process(leftAC, rightAC, &leftSC, &rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
                     break;
                 case HIGHGATE_WIDE:
                 case LOWGATE_WIDE:
@@ -2117,61 +2236,67 @@ uint32_t sidechaingate_audio_module::process(uint32_t offset, uint32_t numsample
                 case WEIGHTED_2:
                 case WEIGHTED_3:
                 case BANDPASS_2:
-                    leftSC  = f2L.process(f1L.process(leftSC));
-                    rightSC = f2R.process(f1R.process(rightSC));
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    gate.process(leftAC, rightAC, &leftSC, &rightSC);
+                    lSC = f2L.process(f1L.process(lSC));
+                    rSC = f2R.process(f1R.process(rSC));
                     break;
                 case HIGHGATE_SPLIT:
-                    leftSC  = f2L.process(leftSC);
-                    rightSC = f2R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    gate.process(leftSC, rightSC, &leftSC, &rightSC);
-                    leftAC   = f1L.process(leftAC);
-                    rightAC  = f1R.process(rightAC);
-                    leftAC  += leftSC;
-                    rightAC += rightSC;
+                    lSC = f2L.process(lSC);
+                    rSC = f2R.process(rSC);
+                    lAC = f1L.process(lAC);
+                    rAC = f1R.process(rAC);
                     break;
                 case LOWGATE_SPLIT:
-                    leftSC  = f1L.process(leftSC);
-                    rightSC = f1R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    gate.process(leftSC, rightSC, &leftSC, &rightSC);
-                    leftAC   = f2L.process(leftAC);
-                    rightAC  = f2R.process(rightAC);
-                    leftAC  += leftSC;
-                    rightAC += rightSC;
+                    lSC = f1L.process(lSC);
+                    rSC = f1R.process(rSC);
+                    lAC = f2L.process(lAC);
+                    rAC = f2R.process(rAC);
                     break;
                 case BANDPASS_1:
-                    leftSC  = f1L.process(leftSC);
-                    rightSC = f1R.process(rightSC);
-                    leftMC  = leftSC;
-                    rightMC = rightSC;
-                    gate.process(leftAC, rightAC, &leftSC, &rightSC);
+                    lSC = f1L.process(lSC);
+                    rSC = f1R.process(rSC);
                     break;
             }
+            leftAC[i]  = lAC;
+            rightAC[i] = rAC;
+            leftSC[i]  = leftMC[i]  = lSC;
+            rightSC[i] = rightMC[i] = rSC;
+        }
+
+        if (split) {
+            // gate the filtered band only and add it to the rest
+            gate.process_block(leftSC, rightSC, leftSC, rightSC, orig_numsamples, NULL, NULL, gain);
+            for (uint32_t i = 0; i < orig_numsamples; i++) {
+                leftAC[i]  += leftSC[i];
+                rightAC[i] += rightSC[i];
+            }
+        } else
+            gate.process_block(leftAC, rightAC, leftAC, rightAC, orig_numsamples, leftSC, rightSC, gain);
 
-            if(*params[param_sc_listen] > 0.f) {
-                outL = leftMC;
-                outR = rightMC;
+        bool listen = *params[param_sc_listen] > 0.f;
+        for (uint32_t i = 0; i < orig_numsamples; i++, offset++) {
+            // cycle through samples
+            float outL = 0.f;
+            float outR = 0.f;
+            float inL  = ins[0][offset] * level_in;
+            float inR  = ins[1][offset] * level_in;
+
+            if(listen) {
+                outL = leftMC[i];
+                outR = rightMC[i];
             } else {
-                outL = leftAC;
-                outR = rightAC;
+                outL = leftAC[i];
+                outR = rightAC[i];
             }
 
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
-            
-            float values[] = {std::max(inL, inR), std::max(outL, outR), gate.get_expander_level()};
-            meters.process(values);
-            
-            // next sample
-            ++offset;
+
+            meter_in[i] = std::max(inL, inR);
+            meter_out[i] = std::max(outL, outR);
         } // cycle trough samples
+        const float *values[] = {meter_in, meter_out, gain};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         f1L.sanitize();
         f1R.sanitize();
@@ -2324,7 +2449,10 @@ void multibandgate_audio_module::set_sample_rate(uint32_t sr)
 uint32_t multibandgate_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
+    
     for (int i = 0; i < strips; i++)
         gate[i].update_curve();
     if(bypassed) {
@@ -2332,59 +2460,82 @@ uint32_t multibandgate_audio_module::process(uint32_t offset, uint32_t numsample
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 0, 1, 0, 1, 0, 1, 0, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process all strips
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
-        while(offset < numsamples) {
-            // cycle through samples
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
+        float level_in = *params[param_level_in];
+        float level_out = *params[param_level_out];
+        float bandL[strips][MAX_SAMPLE_RUN], bandR[strips][MAX_SAMPLE_RUN], gain[strips][MAX_SAMPLE_RUN];
+        bool active[strips];
+        bool strip_bypass[] = {*params[param_bypass0] > 0.5f, *params[param_bypass1] > 0.5f, *params[param_bypass2] > 0.5f, *params[param_bypass3] > 0.5f};
+        for (int i = 0; i < strips; i++)
+            active[i] = solo[i] || no_solo;
+
+        // split into bands
+        for (uint32_t j = 0; j < orig_numsamples; j++) {
             // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
+            xin[0] = ins[0][offset + j] * level_in;
+            xin[1] = ins[1][offset + j] * level_in;
             // process crossover
-            xin[0] = inL;
-            xin[1] = inR;
             crossover.process(xin);
+            for (int i = 0; i < strips; i++) {
+                bandL[i][j] = crossover.get_value(0, i);
+                bandR[i][j] = crossover.get_value(1, i);
+            }
+        }
+
+        // gate the unmuted strips
+        for (int i = 0; i < strips; i++) {
+            if (active[i])
+                gate[i].process_block(bandL[i], bandR[i], bandL[i], bandR[i], orig_numsamples, NULL, NULL, gain[i]);
+        }
+
+        float strip_out[strips][MAX_SAMPLE_RUN];
+        while(offset < numsamples) {
+            // cycle through samples
+            uint32_t j = offset - orig_offset;
             // out vars
             float outL = 0.f;
             float outR = 0.f;
             for (int i = 0; i < strips; i ++) {
                 // cycle trough strips
-                if (solo[i] || no_solo) {
-                    // strip unmuted
-                    float left  = crossover.get_value(0, i);
-                    float right = crossover.get_value(1, i);
-                    gate[i].process(left, right);
+                if (active[i]) {
                     // sum up output
-                    outL += left;
-                    outR += right;
+                    outL += bandL[i][j];
+                    outR += bandR[i][j];
+                    strip_out[i][j] = std::max(fabs(bandL[i][j]), fabs(bandR[i][j]));
                 }
             } // process single strip
 
             // out level
-            outL *= *params[param_level_out];
-            outR *= *params[param_level_out];
+            outL *= level_out;
+            outR *= level_out;
 
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
-
-            float values[] = {inL, inR, outL, outR,
-                *params[param_bypass0] > 0.5f ? 0 : gate[0].get_output_level(), *params[param_bypass0] > 0.5f ? 1 : gate[0].get_expander_level(),
-                *params[param_bypass1] > 0.5f ? 0 : gate[1].get_output_level(), *params[param_bypass1] > 0.5f ? 1 : gate[1].get_expander_level(),
-                *params[param_bypass2] > 0.5f ? 0 : gate[2].get_output_level(), *params[param_bypass2] > 0.5f ? 1 : gate[2].get_expander_level(),
-                *params[param_bypass3] > 0.5f ? 0 : gate[3].get_output_level(), *params[param_bypass3] > 0.5f ? 1 : gate[3].get_expander_level() };
-            meters.process(values);
-            
+                
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[4 + 2 * strips] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[4 + 2 * strips];
+        dsp::fill(scale, 1.f, 4 + 2 * strips);
+        scale[0] = scale[1] = level_in;
+        for (int i = 0; i < strips; i++) {
+            if (strip_bypass[i])
+                continue;
+            if (!active[i]) {
+                // muted strips keep showing their last state
+                dsp::fill(strip_out[i], gate[i].get_output_level(), orig_numsamples);
+                dsp::fill(gain[i], gate[i].get_expander_level(), orig_numsamples);
+            }
+            values[4 + 2 * i] = strip_out[i];
+            values[5 + 2 * i] = gain[i];
+        }
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
 
     } // process all strips (no bypass)
@@ -2541,13 +2692,10 @@ void transientdesigner_audio_module::params_changed() {
 uint32_t transientdesigner_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
     uint32_t orig_offset = offset;
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    float meter_outL[MAX_SAMPLE_RUN], meter_outR[MAX_SAMPLE_RUN];
     for(uint32_t i = offset; i < offset + numsamples; i++) {
         float L = ins[0][i];
         float R = ins[1][i];
-        meter_inL   = 0.f;
-        meter_inR   = 0.f;
-        meter_outL  = 0.f;
-        meter_outR  = 0.f;
         float s = (fabs(L) + fabs(R)) / 2;
         if(bypassed) {
             outs[0][i]  = ins[0][i];
@@ -2558,10 +2706,6 @@ uint32_t transientdesigner_audio_module::process(uint32_t offset, uint32_t numsa
             L *= *params[param_level_in];
             R *= *params[param_level_in];
             
-            // GUI stuff
-            meter_inL = L;
-            meter_inR = R;
-            
             // transient designer
             float s = (L + R) / 2.f;
             for (int k = 0; k < *params[param_hp_mode]; k ++)
@@ -2587,8 +2731,8 @@ uint32_t transientdesigner_audio_module::process(uint32_t offset, uint32_t numsa
                 outs[0][i] = L;
                 outs[1][i] = R;
             }
-            meter_outL = L;
-            meter_outR = R;
+            meter_outL[i - orig_offset] = L;
+            meter_outR[i - orig_offset] = R;
         }
         // fill pixel buffer (pbuffer)
         //
@@ -2655,11 +2799,14 @@ uint32_t transientdesigner_audio_module::process(uint32_t offset, uint32_t numsa
             attack_pos = (pbuffer_pos - diff * 5 + pbuffer_size) % pbuffer_size;
             attcount = 0;
         }
-        float mval[] = {meter_inL, meter_inR, meter_outL, meter_outR};
-        meters.process(mval);
     }
-    if (!bypassed)
+    if (!bypassed) {
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, meter_outL, meter_outR};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
+    } else
+        meters.process(NULL, numsamples);
     meters.fall(numsamples);
     return outputs_mask;
 }
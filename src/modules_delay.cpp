@@ -22,6 +22,9 @@
 #include <limits.h>
 #include <memory.h>
 #include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
 #include <calf/giface.h>
 #include <calf/modules_delay.h>
 #include <calf/modules_dev.h>
@@ -71,31 +74,36 @@ void reverb_audio_module::params_changed()
 
 uint32_t reverb_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
+    bool on = *params[par_on] > 0.5;
+    float level_in = *params[param_level_in], level_out = *params[param_level_out];
+    float rl[MAX_SAMPLE_RUN], rr[MAX_SAMPLE_RUN];
     numsamples += offset;
-    for (uint32_t i = offset; i < numsamples; i++) {
-        float dry = dryamount.get();
-        float wet = amount.get();
-        stereo_sample<float> s(ins[0][i] * *params[param_level_in],
-                               ins[1][i] * *params[param_level_in]);
-        stereo_sample<float> s2 = pre_delay.process(s, predelay_amt);
-        
-        float rl = s2.left, rr = s2.right;
-        rl = left_lo.process(left_hi.process(rl));
-        rr = right_lo.process(right_hi.process(rr));
-        if (*params[par_on] > 0.5)
-            reverb.process(rl, rr);
-        outs[0][i] = dry*s.left;
-        outs[1][i] = dry*s.right;
-        if (*params[par_on] > 0.5) {
-            outs[0][i] += wet*rl;
-            outs[1][i] += wet*rr;
+    for (uint32_t i = offset; i < numsamples; i += MAX_SAMPLE_RUN) {
+        uint32_t len = std::min<uint32_t>(MAX_SAMPLE_RUN, numsamples - i);
+        for (uint32_t j = 0; j < len; j++) {
+            stereo_sample<float> s(ins[0][i + j] * level_in, ins[1][i + j] * level_in);
+            stereo_sample<float> s2 = pre_delay.process(s, predelay_amt);
+            rl[j] = left_lo.process(left_hi.process(s2.left));
+            rr[j] = right_lo.process(right_hi.process(s2.right));
+        }
+        if (on)
+            reverb.process(rl, rr, len);
+        for (uint32_t j = 0; j < len; j++) {
+            float dry = dryamount.get();
+            float wet = amount.get();
+            float outl = dry * ins[0][i + j] * level_in;
+            float outr = dry * ins[1][i + j] * level_in;
+            if (on) {
+                outl += wet * rl[j];
+                outr += wet * rr[j];
+            }
+            outs[0][i + j] = outl * level_out;
+            outs[1][i + j] = outr * level_out;
         }
-        outs[0][i] *= *params[param_level_out];
-        outs[1][i] *= *params[param_level_out];
-        
-        float values[] = {s.left, s.right, outs[0][i], outs[1][i]};
-        meters.process(values);
     }
+    const float *values[] = {ins[0] + offset, ins[1] + offset, outs[0] + offset, outs[1] + offset};
+    float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+    meters.process(values, numsamples - offset, scale);
     meters.fall(numsamples);
     reverb.extra_sanitize();
     left_lo.sanitize();
@@ -105,6 +113,163 @@ uint32_t reverb_audio_module::process(uint32_t offset, uint32_t numsamples, uint
     return outputs_mask;
 }
 
+/**********************************************************************
+ * CONVOLUTION REVERB
+**********************************************************************/
+
+conv_reverb_audio_module::conv_reverb_audio_module()
+{
+    current = pending = retired = NULL;
+    srate = ir_srate = 0;
+}
+
+conv_reverb_audio_module::~conv_reverb_audio_module()
+{
+    free_retired();
+    delete pending;
+    delete current;
+}
+
+void conv_reverb_audio_module::activate()
+{
+    if (current && current->conv[0])
+    {
+        current->conv[0]->reset();
+        current->conv[1]->reset();
+    }
+}
+
+void conv_reverb_audio_module::set_sample_rate(uint32_t sr)
+{
+    srate = sr;
+    int meter[] = {param_meter_inL,  param_meter_inR, param_meter_outL, param_meter_outR};
+    int clip[]  = {param_clip_inL, param_clip_inR, param_clip_outL, param_clip_outR};
+    meters.init(params, meter, clip, 4, srate);
+    // LV2 hosts set the rate on every activation, from the audio thread -
+    // only reload when the impulse response really has to be resampled
+    if (!ir_file.empty() && __atomic_load_n(&ir_srate, __ATOMIC_RELAXED) != sr)
+    {
+        char *error = load_ir();
+        if (error)
+        {
+            fprintf(stderr, "%s\n", error);
+            free(error);
+        }
+    }
+}
+
+char *conv_reverb_audio_module::configure(const char *key, const char *value)
+{
+    if (strcmp(key, "ir_file"))
+        return NULL;
+    ir_file = value ? value : "";
+    // the file is loaded on the first set_sample_rate otherwise
+    if (!srate)
+        return NULL;
+    return load_ir();
+}
+
+void conv_reverb_audio_module::send_configures(send_configure_iface *sci)
+{
+    sci->send_configure("ir_file", ir_file.c_str());
+}
+
+/// Read, resample and transform the impulse response, then hand it over to
+/// the audio thread. Runs in the thread calling configure(), never in process().
+char *conv_reverb_audio_module::load_ir()
+{
+    free_retired();
+    // a file that failed to load is not retried until the rate changes
+    __atomic_store_n(&ir_srate, srate, __ATOMIC_RELAXED);
+    ir_set *set = new ir_set;
+    if (!ir_file.empty())
+    {
+        impulse_response ir;
+        std::string error;
+        if (!ir.load(ir_file.c_str(), error))
+        {
+            delete set;
+            return strdup(error.c_str());
+        }
+        ir.resample(srate);
+        int length = std::min<int>(ir.get_length(), MAX_IR_TIME * srate);
+        if (length <= 0)
+        {
+            delete set;
+            return strdup(("Impulse response " + ir_file + " is empty").c_str());
+        }
+        int right = ir.channels.size() > 1 ? 1 : 0;
+        set->conv[0] = new convolver(&ir.channels[0][0], length);
+        set->conv[1] = new convolver(&ir.channels[right][0], length);
+        set->length = (float)length / srate;
+    }
+    delete __atomic_exchange_n(&pending, set, __ATOMIC_ACQ_REL);
+    return NULL;
+}
+
+void conv_reverb_audio_module::free_retired()
+{
+    ir_set *set = __atomic_exchange_n(&retired, (ir_set *)NULL, __ATOMIC_ACQUIRE);
+    while(set) {
+        ir_set *next = set->next;
+        delete set;
+        set = next;
+    }
+}
+
+uint32_t conv_reverb_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
+{
+    if (__atomic_load_n(&pending, __ATOMIC_RELAXED))
+    {
+        ir_set *set = __atomic_exchange_n(&pending, (ir_set *)NULL, __ATOMIC_ACQUIRE);
+        if (set)
+        {
+            // the old set is freed outside the audio thread
+            if (current)
+            {
+                current->next = __atomic_load_n(&retired, __ATOMIC_RELAXED);
+                while(!__atomic_compare_exchange_n(&retired, &current->next, current, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+                    ;
+            }
+            current = set;
+        }
+    }
+    if (params[par_ir_length])
+        *params[par_ir_length] = current ? current->length : 0;
+
+    bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t end = offset + numsamples;
+    if (bypassed) {
+        for (uint32_t i = offset; i < end; i++) {
+            outs[0][i] = ins[0][i];
+            outs[1][i] = ins[1][i];
+        }
+        meters.process(NULL, numsamples);
+    } else {
+        float level_in = *params[param_level_in];
+        float level_out = *params[param_level_out];
+        float dry = *params[par_dry];
+        float wet = *params[par_wet];
+        float in[2][MAX_SAMPLE_RUN], tail[2][MAX_SAMPLE_RUN];
+        for (int c = 0; c < 2; c++) {
+            for (uint32_t i = 0; i < numsamples; i++)
+                in[c][i] = ins[c][offset + i] * level_in;
+            if (current && current->conv[c])
+                current->conv[c]->process(in[c], tail[c], numsamples);
+            else
+                dsp::zero(tail[c], numsamples);
+            for (uint32_t i = 0; i < numsamples; i++)
+                outs[c][offset + i] = (dry * in[c][i] + wet * tail[c][i]) * level_out;
+        }
+        const float *values[] = {ins[0] + offset, ins[1] + offset, outs[0] + offset, outs[1] + offset};
+        float scale[] = {level_in, level_in, 1, 1};
+        meters.process(values, numsamples, scale);
+        bypass.crossfade(ins, outs, 2, offset, numsamples);
+    }
+    meters.fall(numsamples);
+    return outputs_mask;
+}
+
 /**********************************************************************
  * VINTAGE DELAY by Krzysztof Foltman
 **********************************************************************/
@@ -112,10 +277,8 @@ uint32_t reverb_audio_module::process(uint32_t offset, uint32_t numsamples, uint
 vintage_delay_audio_module::vintage_delay_audio_module()
 {
     old_medium = -1;
-    for (int i = 0; i < MAX_DELAY; i++) {
-        buffers[0][i] = 0.f;
-        buffers[1][i] = 0.f;
-    }
+    max_delay = 0;
+    addr_mask = 0;
     _tap_avg = 0;
     _tap_last = 0;
 }
@@ -207,6 +370,11 @@ void vintage_delay_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
     old_medium = -1;
+    // the contents don't need clearing on activation, see age
+    buffers[0].alloc(MAX_DELAY_TIME * sr);
+    buffers[1].alloc(MAX_DELAY_TIME * sr);
+    max_delay = buffers[0].get_size();
+    addr_mask = buffers[0].get_mask();
     amt_left.set_sample_rate(sr); amt_right.set_sample_rate(sr);
     fb_left.set_sample_rate(sr); fb_right.set_sample_rate(sr);
 
@@ -287,17 +455,15 @@ uint32_t vintage_delay_audio_module::process(uint32_t offset, uint32_t numsample
             {       
                 inL = ins[0][i] * *params[param_level_in];
                 inR = ins[1][i] * *params[param_level_in];
-                delayline_impl(age, deltime_l, *params[param_on] > 0.5 ? inL : 0, buffers[v][(bufptr - deltime_l) & ADDR_MASK], out_left, del_left, amt_left, fb_left);
-                delayline_impl(age, deltime_r, *params[param_on] > 0.5 ? inR : 0, buffers[1 - v][(bufptr - deltime_r) & ADDR_MASK], out_right, del_right, amt_right, fb_right);
+                delayline_impl(age, deltime_l, *params[param_on] > 0.5 ? inL : 0, buffers[v][(bufptr - deltime_l) & addr_mask], out_left, del_left, amt_left, fb_left);
+                delayline_impl(age, deltime_r, *params[param_on] > 0.5 ? inR : 0, buffers[1 - v][(bufptr - deltime_r) & addr_mask], out_right, del_right, amt_right, fb_right);
                 delay_mix(inL, inR, out_left, out_right, dry.get(), chmix.get());
                 
                 age++;
                 outs[0][i] = out_left * *params[param_level_out];
                 outs[1][i] = out_right * *params[param_level_out];
                 buffers[0][bufptr] = del_left; buffers[1][bufptr] = del_right;
-                bufptr = (bufptr + 1) & (MAX_DELAY - 1);
-                float values[] = {inL, inR, outs[0][i], outs[1][i]};
-                meters.process(values);
+                bufptr = (bufptr + 1) & addr_mask;
             }
         }
         break;
@@ -314,22 +480,23 @@ uint32_t vintage_delay_audio_module::process(uint32_t offset, uint32_t numsample
             {
                 inL = ins[0][i] * *params[param_level_in];
                 inR = ins[1][i] * *params[param_level_in];
-                delayline2_impl(age, deltime_l, *params[param_on] > 0.5 ? inL : 0, buffers[v][(bufptr - deltime_l_corr) & ADDR_MASK], buffers[v][(bufptr - deltime_fb) & ADDR_MASK], out_left, del_left, amt_left, fb_left);
-                delayline2_impl(age, deltime_r, *params[param_on] > 0.5 ? inR : 0, buffers[1 - v][(bufptr - deltime_r_corr) & ADDR_MASK], buffers[1-v][(bufptr - deltime_fb) & ADDR_MASK], out_right, del_right, amt_right, fb_right);
+                delayline2_impl(age, deltime_l, *params[param_on] > 0.5 ? inL : 0, buffers[v][(bufptr - deltime_l_corr) & addr_mask], buffers[v][(bufptr - deltime_fb) & addr_mask], out_left, del_left, amt_left, fb_left);
+                delayline2_impl(age, deltime_r, *params[param_on] > 0.5 ? inR : 0, buffers[1 - v][(bufptr - deltime_r_corr) & addr_mask], buffers[1-v][(bufptr - deltime_fb) & addr_mask], out_right, del_right, amt_right, fb_right);
                 delay_mix(inL, inR, out_left, out_right, dry.get(), chmix.get());
                 
                 age++;
                 outs[0][i] = out_left * *params[param_level_out];
                 outs[1][i] = out_right * *params[param_level_out];
                 buffers[0][bufptr] = del_left; buffers[1][bufptr] = del_right;
-                bufptr = (bufptr + 1) & (MAX_DELAY - 1);
-                float values[] = {inL, inR, outs[0][i], outs[1][i]};
-                meters.process(values);
+                bufptr = (bufptr + 1) & addr_mask;
             }
         }
     }
-    if (age >= MAX_DELAY)
-        age = MAX_DELAY;
+    const float *values[] = {ins[0] + offset, ins[1] + offset, outs[0] + offset, outs[1] + offset};
+    float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+    meters.process(values, numsamples, scale);
+    if (age >= max_delay)
+        age = max_delay;
     if (medium > 0) {
         bufptr = orig_bufptr;
         if (medium == 2)
@@ -338,7 +505,7 @@ uint32_t vintage_delay_audio_module::process(uint32_t offset, uint32_t numsample
             {
                 buffers[0][bufptr] = biquad_left[0].process_lp(biquad_left[1].process(buffers[0][bufptr]));
                 buffers[1][bufptr] = biquad_right[0].process_lp(biquad_right[1].process(buffers[1][bufptr]));
-                bufptr = (bufptr + 1) & (MAX_DELAY - 1);
+                bufptr = (bufptr + 1) & addr_mask;
             }
             biquad_left[0].sanitize();biquad_right[0].sanitize();
         } else {
@@ -346,7 +513,7 @@ uint32_t vintage_delay_audio_module::process(uint32_t offset, uint32_t numsample
             {
                 buffers[0][bufptr] = biquad_left[1].process(buffers[0][bufptr]);
                 buffers[1][bufptr] = biquad_right[1].process(buffers[1][bufptr]);
-                bufptr = (bufptr + 1) & (MAX_DELAY - 1);
+                bufptr = (bufptr + 1) & addr_mask;
             }
         }
         biquad_left[1].sanitize();biquad_right[1].sanitize();
@@ -362,18 +529,11 @@ uint32_t vintage_delay_audio_module::process(uint32_t offset, uint32_t numsample
 
 comp_delay_audio_module::comp_delay_audio_module()
 {
-    buffer      = NULL;
     buf_size    = 0;
     delay       = 0;
     write_ptr   = 0;
 }
 
-comp_delay_audio_module::~comp_delay_audio_module()
-{
-    if (buffer != NULL)
-        delete [] buffer;
-}
-
 void comp_delay_audio_module::params_changed()
 {
     delay = (uint32_t)
@@ -398,25 +558,9 @@ void comp_delay_audio_module::deactivate()
 void comp_delay_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
-    float *old_buf = buffer;
-
-    uint32_t min_buf_size = (uint32_t)(srate * COMP_DELAY_MAX_DELAY * 2);
-    uint32_t new_buf_size = 2;
-    while (new_buf_size < min_buf_size)
-        new_buf_size <<= 1;
+    buffer.alloc(std::max<uint32_t>(2, (uint32_t)(srate * COMP_DELAY_MAX_DELAY * 2)));
+    buf_size = buffer.get_size();
 
-    float *new_buf = new float[new_buf_size];
-    for (size_t i=0; i<new_buf_size; i++)
-        new_buf[i] = 0.0f;
-
-    // Assign new pointer and size
-    buffer         = new_buf;
-    buf_size       = new_buf_size;
-
-    // Delete old buffer
-    if (old_buf != NULL)
-        delete [] old_buf;
-        
     int meter[] = {param_meter_inL,  param_meter_inR, param_meter_outL, param_meter_outR};
     int clip[]  = {param_clip_inL, param_clip_inR, param_clip_outL, param_clip_outR};
     meters.init(params, meter, clip, 4, srate);
@@ -432,7 +576,6 @@ uint32_t comp_delay_audio_module::process(uint32_t offset, uint32_t numsamples,
     uint32_t off    = offset;
     
     if (bypassed) {
-        float values[] = {0,0,0,0};
         while(offset < end) {
             outs[0][offset] = ins[0][offset];
             buffer[w_ptr]   = ins[0][offset];
@@ -441,9 +584,9 @@ uint32_t comp_delay_audio_module::process(uint32_t offset, uint32_t numsamples,
                 buffer[w_ptr + 1] = ins[1][offset];
             }
             w_ptr = (w_ptr + 2) & b_mask;
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, numsamples);
     } else {
         uint32_t r_ptr  = (write_ptr + buf_size - delay) & b_mask; // Unsigned math, that's why we add buf_size
         float dry       = *params[par_dry];
@@ -464,10 +607,10 @@ uint32_t comp_delay_audio_module::process(uint32_t offset, uint32_t numsamples,
             }
             w_ptr = (w_ptr + 2) & b_mask;
             r_ptr = (r_ptr + 2) & b_mask;
-            
-            float values[] = {L, R, outs[0][i], outs[1][i]};
-            meters.process(values);
         }
+        const float *values[] = {ins[0] + off, stereo ? ins[1] + off : NULL, outs[0] + off, stereo ? outs[1] + off : NULL};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, numsamples, scale);
     }
     if (!bypassed)
         bypass.crossfade(ins, outs, stereo ? 2 : 1, off, numsamples);
@@ -482,7 +625,6 @@ uint32_t comp_delay_audio_module::process(uint32_t offset, uint32_t numsamples,
 
 haas_enhancer_audio_module::haas_enhancer_audio_module()
 {
-    buffer              = NULL;
     srate               = 0;
     buf_size            = 0;
     write_ptr           = 0;
@@ -496,15 +638,6 @@ haas_enhancer_audio_module::haas_enhancer_audio_module()
     s_bal_r[1]          = 0.0f;
 }
 
-haas_enhancer_audio_module::~haas_enhancer_audio_module()
-{
-    if (buffer != NULL)
-    {
-        delete [] buffer;
-        buffer = NULL;
-    }
-}
-
 void haas_enhancer_audio_module::params_changed()
 {
     m_source            = (uint32_t)(*params[par_m_source]);
@@ -532,25 +665,9 @@ void haas_enhancer_audio_module::deactivate()
 void haas_enhancer_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
-    float *old_buf = buffer;
+    buffer.alloc((uint32_t)(srate * HAAS_ENHANCER_MAX_DELAY));
+    buf_size = buffer.get_size();
 
-    uint32_t min_buf_size = (uint32_t)(srate * HAAS_ENHANCER_MAX_DELAY);
-    uint32_t new_buf_size = 1;
-    while (new_buf_size < min_buf_size)
-        new_buf_size <<= 1;
-
-    float *new_buf = new float[new_buf_size];
-    for (size_t i=0; i<new_buf_size; i++)
-        new_buf[i] = 0.0f;
-
-    // Assign new pointer and size
-    buffer         = new_buf;
-    buf_size       = new_buf_size;
-
-    // Delete old buffer
-    if (old_buf != NULL)
-        delete [] old_buf;
-        
     int meter[] = {param_meter_inL, param_meter_inR,  param_meter_outL, param_meter_outR, param_meter_sideL, param_meter_sideR};
     int clip[] = {param_clip_inL, param_clip_inR, param_clip_outL, param_clip_outR, -1, -1};
     meters.init(params, meter, clip, 6, srate);
@@ -567,11 +684,9 @@ uint32_t haas_enhancer_audio_module::process(uint32_t offset, uint32_t numsample
     float mid, side[2], side_l, side_r;
     // Boundaries and pointers
     uint32_t b_mask = buf_size-1;
+    float meter_side[2][MAX_SAMPLE_RUN];
             
     while(offset < end) {
-        float values[] = {0, 0, 0, 0, 0, 0};
-        float *p = values;
-        
         // Get middle sample
         switch (m_source)
         {
@@ -610,16 +725,18 @@ uint32_t haas_enhancer_audio_module::process(uint32_t offset, uint32_t numsample
             s0_ptr = (s0_ptr + 1) & b_mask;
             s1_ptr = (s1_ptr + 1) & b_mask;
             
-            *p++ = ins[0][offset];  *p++ = ins[1][offset];
-            *p++ = outs[0][offset]; *p++ = outs[1][offset];
-            *p++ = side_l;          *p++ = side_r;
+            meter_side[0][offset - off_] = side_l;
+            meter_side[1][offset - off_] = side_r;
         }
-        meters.process (values);
         w_ptr = (w_ptr + 1) & b_mask;
         ++offset;
     }
-    if (!bypassed)
+    if (!bypassed) {
+        const float *values[] = {ins[0] + off_, ins[1] + off_, outs[0] + off_, outs[1] + off_, meter_side[0], meter_side[1]};
+        meters.process(values, numsamples);
         bypass.crossfade(ins, outs, 2, off_, numsamples);
+    } else
+        meters.process(NULL, numsamples);
     write_ptr = w_ptr;
     meters.fall(numsamples);
     return outputs_mask;
@@ -631,11 +748,6 @@ uint32_t haas_enhancer_audio_module::process(uint32_t offset, uint32_t numsample
 
 reverse_delay_audio_module::reverse_delay_audio_module()
 {
-    for (int i = 0; i < MAX_DELAY; i++) {
-        buffers[0][i] = 0.f;
-        buffers[1][i] = 0.f;
-    }
-
     counters[0] = 0;
     counters[1] = 0;
 
@@ -648,10 +760,10 @@ void reverse_delay_audio_module::params_changed()
     if (*params[par_sync] > 0.5f)
         *params[par_bpm] = *params[par_bpm_host];
 
-    //Max delay line length: (60*192000/30)*16 = 6144000, see buffers declaration
+    //Max delay line length: (60*srate/30)*16, see MAX_DELAY_TIME
     float unit = 60.0 * srate / (*params[par_bpm] * *params[par_divide]);
-    deltime_l = dsp::fastf2i_drm(unit * *params[par_time_l]);
-    deltime_r = dsp::fastf2i_drm(unit * *params[par_time_r]);
+    deltime_l = std::min<int>(dsp::fastf2i_drm(unit * *params[par_time_l]), buffers[0].get_size());
+    deltime_r = std::min<int>(dsp::fastf2i_drm(unit * *params[par_time_r]), buffers[1].get_size());
 
     fb_val.set_inertia(*params[par_feedback]);
     dry.set_inertia(*params[par_amount]);
@@ -667,10 +779,8 @@ void reverse_delay_audio_module::params_changed()
     //Cleanup delay line buffers if reset
     if(*params[par_reset])
     {
-        for (int i = 0; i < MAX_DELAY; i++) {
-            buffers[0][i] = 0.f;
-            buffers[1][i] = 0.f;
-        }
+        buffers[0].clear();
+        buffers[1].clear();
 
         feedback_buf[0] = 0;
         feedback_buf[1] = 0;
@@ -688,6 +798,8 @@ void reverse_delay_audio_module::deactivate()
 void reverse_delay_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
+    buffers[0].alloc(MAX_DELAY_TIME * sr, false);
+    buffers[1].alloc(MAX_DELAY_TIME * sr, false);
     fb_val.set_sample_rate(sr);
     dry.set_sample_rate(sr);
     width.set_sample_rate(sr);
@@ -721,6 +833,7 @@ uint32_t reverse_delay_audio_module::process(uint32_t offset, uint32_t numsample
     bool bypassed  = bypass.update(*params[param_bypass] > 0.5f, numsamples);
     uint32_t ostate = 3; // XXXKF optimize!
     uint32_t end = offset + numsamples;
+    float meter_values[4][MAX_SAMPLE_RUN];
 
     //Loop
     for(uint32_t i = offset; i < end; i++)
@@ -752,8 +865,8 @@ uint32_t reverse_delay_audio_module::process(uint32_t offset, uint32_t numsample
             inL = inL + feedback_buf[0]* feedback_val*(1 - st_width_val) + feedback_buf[1]* st_width_val*feedback_val;
             inR = inR + feedback_buf[1]* feedback_val*(1 - st_width_val) + feedback_buf[0]* st_width_val*feedback_val;
     
-            outL = reverse_delay_line_impl(inL, &buffers[0][0], &counters[0], deltime_l);
-            outR = reverse_delay_line_impl(inR, &buffers[1][0], &counters[1], deltime_r);
+            outL = reverse_delay_line_impl(inL, buffers[0].get(), &counters[0], deltime_l);
+            outR = reverse_delay_line_impl(inR, buffers[1].get(), &counters[1], deltime_r);
             feedback_buf[0] = outL;
             feedback_buf[1] = outR;
     
@@ -767,9 +880,16 @@ uint32_t reverse_delay_audio_module::process(uint32_t offset, uint32_t numsample
             outs[1][i] = outR * *params[param_level_out];
             bypass.crossfade(ins, outs, 2, offset, numsamples);
         }
-        float values[] = {inL, inR, outL, outR};
-        meters.process(values);
+        meter_values[0][i - offset] = inL;
+        meter_values[1][i - offset] = inR;
+        meter_values[2][i - offset] = outL;
+        meter_values[3][i - offset] = outR;
     }
+    if (!bypassed) {
+        const float *values[] = {meter_values[0], meter_values[1], meter_values[2], meter_values[3]};
+        meters.process(values, numsamples);
+    } else
+        meters.process(NULL, numsamples);
 
     return ostate;
 }
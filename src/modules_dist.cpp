@@ -123,6 +123,8 @@ void saturator_audio_module::set_sample_rate(uint32_t sr)
 uint32_t saturator_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
@@ -138,13 +140,10 @@ uint32_t saturator_audio_module::process(uint32_t offset, uint32_t numsamples, u
             } else {
                 outs[0][offset] = ins[0][offset];
             }
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         // process
         while(offset < numsamples) {
             // cycle through samples
@@ -194,6 +193,14 @@ uint32_t saturator_audio_module::process(uint32_t offset, uint32_t numsamples, u
                     proc[i] *= 1 + (*params[param_level_in] - 1) / 32;
             }
             
+            // align the dry signal with the oversampled one
+            // (simple_delay reads before writing, so it can't do a zero delay)
+            int latency = dist[0].get_latency();
+            for (int i = 0; i < c && latency; ++i)
+                in[i] = dry[i].process(in[i], latency);
+            if (c == 1)
+                in[1] = in[0];
+            
             if(in_count > 1 && out_count > 1) {
                 // full stereo
                 out[0] = ((proc[0] * *params[param_mix]) + in[0] * (1 - *params[param_mix])) * *params[param_level_out];
@@ -212,12 +219,12 @@ uint32_t saturator_audio_module::process(uint32_t offset, uint32_t numsamples, u
                 out[0] = ((proc[0] * *params[param_mix]) + in[0] * (1 - *params[param_mix])) * *params[param_level_out];
                 outs[0][offset] = out[0];
             }
-            float values[] = {in[0],  in[1], out[0], out[1]};
-            meters.process(values);
-
             // next sample
             ++offset;
         } // cycle trough samples
+        bool stereo_in = in_count > 1 && out_count > 1;
+        const float *values[] = {ins[0] + orig_offset, (stereo_in ? ins[1] : ins[0]) + orig_offset, outs[0] + orig_offset, out_count > 1 ? outs[1] + orig_offset : NULL};
+        meters.process(values, orig_numsamples);
         
         // clean up
         lp[0][0].sanitize();
@@ -315,6 +322,8 @@ void exciter_audio_module::set_sample_rate(uint32_t sr)
 uint32_t exciter_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
@@ -330,18 +339,16 @@ uint32_t exciter_audio_module::process(uint32_t offset, uint32_t numsamples, uin
             } else {
                 outs[0][offset] = ins[0][offset];
             }
-            float values[] = {0, 0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
         // displays, too
         meter_drive = 0.f;
     } else {
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         meter_drive = 0.f;
         
         float in2out = *params[param_listen] > 0.f ? 0.f : 1.f;
+        float meter_values[3][MAX_SAMPLE_RUN];
         
         // process
         while(offset < numsamples) {
@@ -387,6 +394,14 @@ uint32_t exciter_audio_module::process(uint32_t offset, uint32_t numsamples, uin
                     
                 }
             }
+            // align the dry signal with the oversampled one
+            // (simple_delay reads before writing, so it can't do a zero delay)
+            int latency = dist[0].get_latency();
+            for (int i = 0; i < c && latency; ++i)
+                in[i] = dry[i].process(in[i], latency);
+            if (c == 1)
+                in[1] = in[0];
+            
             maxDrive = dist[0].get_distortion_level() * *params[param_amount];
             
             if(in_count > 1 && out_count > 1) {
@@ -407,11 +422,14 @@ uint32_t exciter_audio_module::process(uint32_t offset, uint32_t numsamples, uin
                 out[0] = (proc[0] * *params[param_amount] + in2out * in[0]) * *params[param_level_out];
                 outs[0][offset] = out[0];
             }
-            float values[] = {(in[0] + in[1]) / 2, (out[0] + out[1]) / 2, maxDrive};
-            meters.process(values);
+            meter_values[0][offset - orig_offset] = (in[0] + in[1]) / 2;
+            meter_values[1][offset - orig_offset] = (out[0] + out[1]) / 2;
+            meter_values[2][offset - orig_offset] = maxDrive;
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[] = {meter_values[0], meter_values[1], meter_values[2]};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         // clean up
         hp[0][0].sanitize();
@@ -502,6 +520,8 @@ void bassenhancer_audio_module::set_sample_rate(uint32_t sr)
 uint32_t bassenhancer_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
@@ -517,14 +537,12 @@ uint32_t bassenhancer_audio_module::process(uint32_t offset, uint32_t numsamples
             } else {
                 outs[0][offset] = ins[0][offset];
             }
-            float values[] = {0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
+        float meter_values[3][MAX_SAMPLE_RUN];
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         while(offset < numsamples) {
             // cycle through samples
             float out[2], in[2] = {0.f, 0.f};
@@ -569,6 +587,14 @@ uint32_t bassenhancer_audio_module::process(uint32_t offset, uint32_t numsamples
                 }
             }
             
+            // align the dry signal with the oversampled one
+            // (simple_delay reads before writing, so it can't do a zero delay)
+            int latency = dist[0].get_latency();
+            for (int i = 0; i < c && latency; ++i)
+                in[i] = dry[i].process(in[i], latency);
+            if (c == 1)
+                in[1] = in[0];
+            
             if(in_count > 1 && out_count > 1) {
                 // full stereo
                 if(*params[param_listen] > 0.f)
@@ -604,11 +630,14 @@ uint32_t bassenhancer_audio_module::process(uint32_t offset, uint32_t numsamples
                 maxDrive = dist[0].get_distortion_level() * *params[param_amount];
             }
             
-            float values[] = {(in[0] + in[1]) / 2, (out[0] + out[1]) / 2, maxDrive};
-            meters.process(values);
+            meter_values[0][offset - orig_offset] = (in[0] + in[1]) / 2;
+            meter_values[1][offset - orig_offset] = (out[0] + out[1]) / 2;
+            meter_values[2][offset - orig_offset] = maxDrive;
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[] = {meter_values[0], meter_values[1], meter_values[2]};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         // clean up
         lp[0][0].sanitize();
@@ -683,6 +712,7 @@ void tapesimulator_audio_module::params_changed() {
 uint32_t tapesimulator_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
     uint32_t orig_offset = offset;
+    float meter_inL[MAX_SAMPLE_RUN], meter_inR[MAX_SAMPLE_RUN];
     for(uint32_t i = offset; i < offset + numsamples; i++) {
         float L = ins[0][i];
         float R = ins[1][i];
@@ -691,12 +721,8 @@ uint32_t tapesimulator_audio_module::process(uint32_t offset, uint32_t numsample
         if(bypassed) {
             outs[0][i]  = ins[0][i];
             outs[1][i]  = ins[1][i];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
         } else {
             // transients
-            float inL = 0;
-            float inR = 0;
             if(*params[param_magnetical] > 0.5f) {
                 float values[] = {L, R};
                 transients.process(values, (L + R) / 2.f);
@@ -745,8 +771,8 @@ uint32_t tapesimulator_audio_module::process(uint32_t offset, uint32_t numsample
             L *= *params[param_level_in];
             R *= *params[param_level_in];
             
-            inL = L;
-            inR = R;
+            meter_inL[i - orig_offset] = L;
+            meter_inR[i - orig_offset] = R;
             
             // save for drawing input/output curve
             float Lc = L;
@@ -798,11 +824,13 @@ uint32_t tapesimulator_audio_module::process(uint32_t offset, uint32_t numsample
             // dot
             rms = std::max((double)rms, (double)((fabs(Lo) + fabs(Ro)) / 2));
             input = std::max((double)input, (double)((fabs(Lc) + fabs(Rc)) / 2));
-            
-            float values[] = {inL, inR, outs[0][i], outs[1][i]};
-            meters.process(values);
         }
     }
+    if (!bypassed) {
+        const float *values[] = {meter_inL, meter_inR, outs[0] + orig_offset, outs[1] + orig_offset};
+        meters.process(values, numsamples);
+    } else
+        meters.process(NULL, numsamples);
     if (bypassed)
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
     meters.fall(numsamples);
@@ -965,20 +993,19 @@ void crusher_audio_module::set_sample_rate(uint32_t sr)
 uint32_t crusher_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         while(offset < numsamples) {
             // cycle through samples
             if (*params[param_lfo] > 0.5) {
@@ -991,13 +1018,13 @@ uint32_t crusher_audio_module::process(uint32_t offset, uint32_t numsamples, uin
             outs[1][offset] = outs[1][offset] * *params[param_morph] + ins[1][offset] * (*params[param_morph] * -1 + 1) * *params[param_level_in];
             outs[0][offset] = bitreduction.process(outs[0][offset]) * *params[param_level_out];
             outs[1][offset] = bitreduction.process(outs[1][offset]) * *params[param_level_out];
-            float values[] = {ins[0][offset], ins[1][offset], outs[0][offset], outs[1][offset]};
-            meters.process(values);
             // next sample
             ++offset;
             if (*params[param_lforate])
                 lfo.advance(1);
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     }
     meters.fall(numsamples);
@@ -267,21 +267,21 @@ uint32_t equalizerNband_audio_module<BaseClass, has_lphp>::process(uint32_t offs
         if (keep_gliding)
             params_changed();
     }
+    uint32_t orig_numsamples = numsamples;
+    uint32_t orig_offset = offset;
     numsamples += offset;
     if(bypassed) {
         // everything bypassed
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
-            _analyzer.process(0, 0);
             ++offset;
         }
+        _analyzer.process(NULL, NULL, orig_numsamples);
+        meters.process(NULL, orig_numsamples);
     } else {
+        float analyzer_in[MAX_SAMPLE_RUN], analyzer_out[MAX_SAMPLE_RUN];
         // process
-        uint32_t orig_numsamples = numsamples-offset;
-        uint32_t orig_offset = offset;
         while(offset < numsamples) {
             // cycle through samples
             float outL = 0.f;
@@ -330,18 +330,20 @@ uint32_t equalizerNband_audio_module<BaseClass, has_lphp>::process(uint32_t offs
             outR = procR * *params[AM::param_level_out];
             
             // analyzer
-            _analyzer.process((inL + inR) / 2.f, (outL + outR) / 2.f);
+            analyzer_in[offset - orig_offset]  = (inL + inR) / 2.f;
+            analyzer_out[offset - orig_offset] = (outL + outR) / 2.f;
         
             // send to output
             outs[0][offset] = outL;
             outs[1][offset] = outR;
-            
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
 
             // next sample
             ++offset;
         } // cycle trough samples
+        _analyzer.process(analyzer_in, analyzer_out, orig_numsamples);
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[AM::param_level_in], *params[AM::param_level_in], 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         // clean up
         for(int i = 0; i < 3; ++i) {
@@ -520,21 +522,9 @@ equalizer30band_audio_module::equalizer30band_audio_module() :
     using namespace orfanidis_eq;
 
     fg.set_30_bands();
-
-    eq2* ptr30L = new eq2(fg, butterworth);
-    eq2* ptr30R = new eq2(fg, butterworth);
-    eq_arrL.push_back(ptr30L);
-    eq_arrR.push_back(ptr30R);
-
-    ptr30L = new eq2(fg, chebyshev1);
-    ptr30R = new eq2(fg, chebyshev1);
-    eq_arrL.push_back(ptr30L);
-    eq_arrR.push_back(ptr30R);
-
-    ptr30L = new eq2(fg, chebyshev2);
-    ptr30R = new eq2(fg, chebyshev2);
-    eq_arrL.push_back(ptr30L);
-    eq_arrR.push_back(ptr30R);
+    eq_srate = default_sample_freq_hz;
+    create_eqs(fg, eq_srate, eq_arrL, eq_arrR);
+    rebuild.owner = this;
 
     flt_type = butterworth;
     flt_type_old = none;
@@ -549,11 +539,74 @@ equalizer30band_audio_module::equalizer30band_audio_module() :
 
 equalizer30band_audio_module::~equalizer30band_audio_module()
 {
-    for (unsigned int i = 0; i < eq_arrL.size(); i++)
-        delete eq_arrL[i];
+    delete_eqs(eq_arrL);
+    delete_eqs(eq_arrR);
+}
+
+void equalizer30band_audio_module::create_eqs(orfanidis_eq::freq_grid &fg, uint32_t sr, eq_array &eqL, eq_array &eqR)
+{
+    using namespace orfanidis_eq;
+    static const filter_type types[] = { butterworth, chebyshev1, chebyshev2 };
+    for (unsigned int i = 0; i < sizeof(types) / sizeof(types[0]); i++) {
+        eq2 *ptrL = new eq2(fg, types[i]);
+        eq2 *ptrR = new eq2(fg, types[i]);
+        if (sr != default_sample_freq_hz) {
+            ptrL->set_sample_rate(sr);
+            ptrR->set_sample_rate(sr);
+        }
+        eqL.push_back(ptrL);
+        eqR.push_back(ptrR);
+    }
+}
+
+void equalizer30band_audio_module::delete_eqs(eq_array &eqs)
+{
+    for (unsigned int i = 0; i < eqs.size(); i++)
+        delete eqs[i];
+    eqs.clear();
+}
+
+void equalizer30band_audio_module::rebuild_job::work()
+{
+    cleanup();
+    create_eqs(owner->fg, srate, eqL, eqR);
+}
+
+void equalizer30band_audio_module::rebuild_job::apply()
+{
+    owner->eq_arrL.swap(eqL);
+    owner->eq_arrR.swap(eqR);
+    owner->eq_srate = srate;
+    // the new equalizers start with flat gains
+    owner->params_changed();
+}
+
+void equalizer30band_audio_module::rebuild_job::cleanup()
+{
+    delete_eqs(eqL);
+    delete_eqs(eqR);
+}
+
+void equalizer30band_audio_module::rebuild_eqs()
+{
+    if (eq_srate == srate || !rebuild.is_idle())
+        return;
+    rebuild.srate = srate;
+    schedule_work(&rebuild);
+}
 
-    for (unsigned int i = 0; i < eq_arrR.size(); i++)
-        delete eq_arrR[i];
+void equalizer30band_audio_module::post_instantiate(uint32_t sr)
+{
+    // build for the right rate up front, so that set_sample_rate has nothing to do
+    if (sr == eq_srate)
+        return;
+    eq_array eqL, eqR;
+    create_eqs(fg, sr, eqL, eqR);
+    eq_arrL.swap(eqL);
+    eq_arrR.swap(eqR);
+    delete_eqs(eqL);
+    delete_eqs(eqR);
+    eq_srate = sr;
 }
 
 void equalizer30band_audio_module::activate()
@@ -616,10 +669,17 @@ void equalizer30band_audio_module::params_changed()
                 *params[param_gainscale2];
     }
 
-    //Pass gains to eq's
+    //Pass gains to eq's, but only recalculate the bands that changed
+    bool all = param_changed(param_linked) || param_changed(param_filters);
+    int gl = psl - param_gain_scale11 + param_gain11;
+    int gr = psr - param_gain_scale11 + param_gain11;
+    bool all_l = all || param_changed(pql);
+    bool all_r = all || param_changed(pqr);
     for (unsigned int i = 0; i < fg.get_number_of_bands(); i++) {
-        eq_arrL[*params[param_filters]]->change_band_gain_db(i,*params[psl + band_params*i]);
-        eq_arrR[*params[param_filters]]->change_band_gain_db(i,*params[psr + band_params*i]);
+        if (all_l || param_changed(gl + band_params*i))
+            eq_arrL[*params[param_filters]]->change_band_gain_db(i,*params[psl + band_params*i]);
+        if (all_r || param_changed(gr + band_params*i))
+            eq_arrR[*params[param_filters]]->change_band_gain_db(i,*params[psr + band_params*i]);
     }
 
     //Upadte filter type
@@ -630,12 +690,8 @@ void equalizer30band_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
 
-    //Change sample rate for eq's
-    for(unsigned int i = 0; i < eq_arrL.size(); i++)
-    {
-        eq_arrL[i]->set_sample_rate(srate);
-        eq_arrL[i]->set_sample_rate(srate);
-    }
+    //Rebuilding the eq's takes a while, leave it to the worker
+    rebuild_eqs();
 
     int meter[] = {param_level_in_vuL, param_level_in_vuR, param_level_out_vuL, param_level_out_vuR};
     int clip[] = {param_level_in_clipL, param_level_in_clipR, param_level_out_clipL, param_level_out_clipR};
@@ -644,6 +700,8 @@ void equalizer30band_audio_module::set_sample_rate(uint32_t sr)
 
 uint32_t equalizer30band_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
+    // retry if the worker was busy with an earlier sample rate
+    rebuild_eqs();
     uint32_t orig_numsamples = numsamples;
     uint32_t orig_offset = offset;
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
@@ -653,10 +711,9 @@ uint32_t equalizer30band_audio_module::process(uint32_t offset, uint32_t numsamp
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process
         while(offset < numsamples) {
@@ -691,13 +748,12 @@ uint32_t equalizer30band_audio_module::process(uint32_t offset, uint32_t numsamp
             outs[0][offset] = outL;
             outs[1][offset] = outR;
 
-            // meters
-            float values[] = {(float)inL, (float)inR, (float)outL, (float)outR};
-            meters.process(values);
-
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     }
 
@@ -866,10 +922,9 @@ uint32_t emphasis_audio_module::process(uint32_t offset, uint32_t numsamples, ui
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process
         while(offset < numsamples) {
@@ -895,12 +950,12 @@ uint32_t emphasis_audio_module::process(uint32_t offset, uint32_t numsamples, ui
             outs[0][offset] = outL;
             outs[1][offset] = outR;
             
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
-            
             // next sample
             ++offset;
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         // clean up
         riaacurvL.sanitize();
@@ -998,8 +1053,8 @@ template<class XoverBaseClass>
 uint32_t xover_audio_module<XoverBaseClass>::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask)
 {
     unsigned int targ = numsamples + offset;
+    unsigned int orig_offset = offset;
     float xval;
-    float values[AM::bands * AM::channels + AM::channels];
     while(offset < targ) {
         // cycle through samples
         
@@ -1033,22 +1088,21 @@ uint32_t xover_audio_module<XoverBaseClass>::process(uint32_t offset, uint32_t n
                 
                 // set value with phase to output
                 outs[ptr][offset] = *params[AM::param_phase1 + off] > 0.5 ? xval * -1 : xval;
-                
-                // band meters
-                values[b * AM::channels + c] = outs[ptr][offset];
             }
         }
-        // in meters
-        for (int c = 0; c < AM::channels; c++) {
-            values[c + AM::bands * AM::channels] = ins[c][offset];
-        }
-        meters.process(values);
         // next sample
         ++offset;
         // delay buffer pos forward
         pos = (pos + AM::channels * AM::bands) % buffer_size;
         
     } // cycle trough samples
+    // band meters, then in meters
+    const float *values[AM::bands * AM::channels + AM::channels];
+    for (int i = 0; i < AM::bands * AM::channels; i++)
+        values[i] = outs[i] + orig_offset;
+    for (int c = 0; c < AM::channels; c++)
+        values[c + AM::bands * AM::channels] = ins[c] + orig_offset;
+    meters.process(values, numsamples);
     meters.fall(numsamples);
     return outputs_mask;
 }
@@ -1138,13 +1192,10 @@ void vocoder_audio_module::params_changed()
             float step = (log10(to) - _freq) / (bands - i) * (1 + tilt);
             float f = pow(10, _freq + (0.5 * step));
             bandfreq[_i] = f;
-            detector[0][0][_i].set_bp_rbj(f, _q, (double)srate);
+            bandfilter[_i].set_bp_rbj(f, _q, (double)srate);
             for (int j = 0; j < order; j++) {
-                if (j)
-                    detector[0][j][_i].copy_coeffs(detector[0][0][_i]);
-                detector[1][j][_i].copy_coeffs(detector[0][0][_i]);
-                modulator[0][j][_i].copy_coeffs(detector[0][0][_i]);
-                modulator[1][j][_i].copy_coeffs(detector[0][0][_i]);
+                for (int k = 0; k < 4; k++)
+                    filters[j].copy_coeffs(k * 32 + _i, bandfilter[_i]);
             }
             freq = pow(10, _freq + step);
         }
@@ -1174,12 +1225,15 @@ uint32_t vocoder_audio_module::process(uint32_t offset, uint32_t numsamples, uin
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process
+        float lanes[128] __attribute__((aligned(32)));
+        float analyzer_L[MAX_SAMPLE_RUN], analyzer_R[MAX_SAMPLE_RUN];
+        int analyzer_source = *params[param_analyzer];
+        bool link = *params[param_link] > 0.5;
         while(offset < numsamples) {
             // cycle through samples
             double outL = 0;
@@ -1199,26 +1253,29 @@ uint32_t vocoder_audio_module::process(uint32_t offset, uint32_t numsamples, uin
             double nL = (float)rand() / (float)RAND_MAX;
             double nR = (float)rand() / (float)RAND_MAX;
             
+            // filter all bands at once: modulator, then carrier with noise
+            float *mLs = lanes, *mRs = lanes + 32, *cLs = lanes + 64, *cRs = lanes + 96;
+            for (int i = 0; i < bands; i++) {
+                mLs[i] = link ? std::max(mL, mR) : mL;
+                mRs[i] = mR;
+                cLs[i] = cL + nL * *params[param_noise0 + i * band_params];
+                cRs[i] = cR + nR * *params[param_noise0 + i * band_params];
+            }
+            for (int j = 0; j < order; j++) {
+                filters[j].process(lanes, 0, bands);
+                if (!link)
+                    filters[j].process(lanes, 32, 32 + bands);
+                filters[j].process(lanes, 64, 64 + bands);
+                filters[j].process(lanes, 96, 96 + bands);
+            }
+            
             for (int i = 0; i < bands; i++) {
-                double mL_ = mL;
-                double mR_ = mR;
-                double cL_ = cL + nL * *params[param_noise0 + i * band_params];
-                double cR_ = cR + nR * *params[param_noise0 + i * band_params];
+                double mL_ = mLs[i];
+                double mR_ = link ? mLs[i] : mRs[i];
+                double cL_ = cLs[i];
+                double cR_ = cRs[i];
                 
                 if ((solo and *params[param_solo0 + i * band_params]) or !solo) {
-                    for (int j = 0; j < order; j++) {
-                        // filter modulator
-                        if (*params[param_link] > 0.5) {
-                            mL_ = detector[0][j][i].process(std::max(mL_, mR_));
-                            mR_ = mL_;
-                        } else {
-                            mL_ = detector[0][j][i].process(mL_);
-                            mR_ = detector[1][j][i].process(mR_);
-                        }
-                        // filter carrier with noise
-                        cL_ = modulator[0][j][i].process(cL_);
-                        cR_ = modulator[1][j][i].process(cR_);
-                    }
                     // level by envelope with levelling
                     cL_ *= env_mods[0][i] * ((float)order / 2 + 4) * 4;
                     cR_ *= env_mods[1][i] * ((float)order / 2 + 4) * 4;
@@ -1263,21 +1320,27 @@ uint32_t vocoder_audio_module::process(uint32_t offset, uint32_t numsamples, uin
             outR += mR * *params[param_mod];
             
             // analyzer
-            switch ((int)*params[param_analyzer]) {
+            float *aL = analyzer_L + offset - orig_offset;
+            float *aR = analyzer_R + offset - orig_offset;
+            switch (analyzer_source) {
                 case 0:
                 default:
                     break;
                 case 1:
-                    _analyzer.process((float)cL, (float)cR);
+                    *aL = cL;
+                    *aR = cR;
                     break;
                 case 2:
-                    _analyzer.process((float)mL, (float)mR);
+                    *aL = mL;
+                    *aR = mR;
                     break;
                 case 3:
-                    _analyzer.process((float)pL, (float)pR);
+                    *aL = pL;
+                    *aR = pR;
                     break;
                 case 4:
-                    _analyzer.process((float)outL, (float)outR);
+                    *aL = outL;
+                    *aR = outR;
                     break;
             }
             
@@ -1289,23 +1352,18 @@ uint32_t vocoder_audio_module::process(uint32_t offset, uint32_t numsamples, uin
             outs[0][offset] = outL;
             outs[1][offset] = outR;
             
-            // meters
-            float values[] = {(float)cL, (float)cR, (float)mL, (float)mR, (float)outL, (float)outR};
-            meters.process(values);
-            
             // next sample
             ++offset;
         } // cycle trough samples
+        if (analyzer_source > 0 and analyzer_source < 5)
+            _analyzer.process(analyzer_L, analyzer_R, orig_numsamples);
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, ins[2] + orig_offset, ins[3] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[param_carrier_in], *params[param_carrier_in], *params[param_mod_in], *params[param_mod_in], 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
         // clean up
-        for (int i = 0; i < bands; i++) {
-            for (int j = 0; j < order; j++) {
-                detector[0][j][i].sanitize();
-                detector[1][j][i].sanitize();
-                modulator[0][j][i].sanitize();
-                modulator[1][j][i].sanitize();
-            }
-        }
+        for (int j = 0; j < order; j++)
+            filters[j].sanitize();
     }
     
     // LED
@@ -1344,7 +1402,7 @@ bool vocoder_audio_module::get_graph(int index, int subindex, int phase, float *
             double freq = 20.0 * pow (20000.0 / 20.0, i * 1.0 / points);
             float level = 1;
             for (int j = 0; j < order; j++)
-                level *= detector[0][0][subindex].freq_gain(freq, srate);
+                level *= bandfilter[subindex].freq_gain(freq, srate);
             level *= *params[param_volume0 + subindex * band_params];
             data[i] = dB_grid(level, 256, 0.4);
             if (!drawn and freq > bandfreq[subindex]) {
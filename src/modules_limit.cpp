@@ -57,6 +57,15 @@ void limiter_audio_module::deactivate()
     is_active = false;
     limiter.deactivate();
 }
+void limiter_audio_module::allocate_buffers(uint32_t sr)
+{
+    // enough for the highest oversampling, so that set_srates() never allocates
+    limiter.allocate(sr * (uint32_t)param_props[param_oversampling].max);
+}
+void limiter_audio_module::post_instantiate(uint32_t sr)
+{
+    allocate_buffers(sr);
+}
 void limiter_audio_module::set_srates()
 {
     resampler[0].set_params(srate, *params[param_oversampling], 2);
@@ -81,12 +90,20 @@ void limiter_audio_module::params_changed()
     }
 }
 
+uint32_t limiter_audio_module::get_latency()
+{
+    // lookahead at the oversampled rate plus the resampling filters
+    int over = resampler[0].factor;
+    return resampler[0].get_latency() + (limiter.get_latency() + over / 2) / over;
+}
+
 void limiter_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
     int meter[] = {param_meter_inL, param_meter_inR,  param_meter_outL, param_meter_outR, -param_att};
     int clip[] = {param_clip_inL, param_clip_inR, param_clip_outL, param_clip_outR, -1};
     meters.init(params, meter, clip, 5, srate);
+    allocate_buffers(srate);
     set_srates();
 }
 
@@ -101,71 +118,58 @@ uint32_t limiter_audio_module::process(uint32_t offset, uint32_t numsamples, uin
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
         asc_led    = 0.f;
-    } else {
+    } else if (orig_numsamples) {
         asc_led   -= std::min(asc_led, numsamples);
+        float meter_att[MAX_SAMPLE_RUN];
+        float inL[MAX_SAMPLE_RUN], inR[MAX_SAMPLE_RUN];
+        float samplesL[MAX_SAMPLE_RUN * 4], samplesR[MAX_SAMPLE_RUN * 4];
+        int over = resampler[0].factor;
+        float level_in = *params[param_level_in];
+        float limit = *params[param_limit];
+        float level_out = *params[param_level_out];
+
+        // in level
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
+            inL[i] = ins[0][orig_offset + i] * level_in;
+            inR[i] = ins[1][orig_offset + i] * level_in;
+        }
 
-        while(offset < numsamples) {
-            // cycle through samples
-            float inL = ins[0][offset];
-            float inR = ins[1][offset];
-            // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
-            // out vars
-            float outL = inL;
-            float outR = inR;
-            
-            // upsampling
-            double *samplesL = resampler[0].upsample((double)outL);
-            double *samplesR = resampler[1].upsample((double)outR);
-            
-            float tmpL;
-            float tmpR;
-            
-            // process gain reduction
-            float fickdich[0];
-            for (int i = 0; i < *params[param_oversampling]; i ++) {
-                tmpL = samplesL[i];
-                tmpR = samplesR[i];
-                limiter.process(tmpL, tmpR, fickdich);
-                samplesL[i] = tmpL;
-                samplesR[i] = tmpR;
+        // upsampling
+        resampler[0].upsample(inL, samplesL, orig_numsamples);
+        resampler[1].upsample(inR, samplesR, orig_numsamples);
+
+        // process gain reduction
+        float fickdich[0];
+        for (uint32_t i = 0; i < orig_numsamples; i++) {
+            for (int o = i * over; o < (int)(i + 1) * over; o++) {
+                limiter.process(samplesL[o], samplesR[o], fickdich);
                 if(limiter.get_asc())
                     asc_led = srate >> 3;
             }
-            
-            // downsampling
-            outL = resampler[0].downsample(samplesL);
-            outR = resampler[1].downsample(samplesR);
-            
-            // should never be used. but hackers are paranoid by default.
-            // so we make shure NOTHING is above limit
-            outL = std::min(std::max(outL, -*params[param_limit]), *params[param_limit]);
-            outR = std::min(std::max(outR, -*params[param_limit]), *params[param_limit]);
-
-            // autolevel
-            outL /= *params[param_limit];
-            outR /= *params[param_limit];
-
-            // out level
-            outL *= *params[param_level_out];
-            outR *= *params[param_level_out];
+            meter_att[i] = limiter.get_attenuation();
+        }
 
-            // send to output
-            outs[0][offset] = outL;
-            outs[1][offset] = outR;
+        // downsampling
+        resampler[0].downsample(samplesL, outs[0] + orig_offset, orig_numsamples);
+        resampler[1].downsample(samplesR, outs[1] + orig_offset, orig_numsamples);
 
-            float values[] = {inL, inR, outL, outR, bypassed ? (float)1.0 : (float)limiter.get_attenuation()};
-            meters.process (values);
+        for (uint32_t i = orig_offset; i < numsamples; i++) {
+            // should never be used. but hackers are paranoid by default.
+            // so we make shure NOTHING is above limit
+            float outL = std::min(std::max(outs[0][i], -limit), limit);
+            float outR = std::min(std::max(outs[1][i], -limit), limit);
 
-            // next sample
-            ++offset;
-        } // cycle trough samples
+            // autolevel and out level
+            outs[0][i] = outL / limit * level_out;
+            outs[1][i] = outR / limit * level_out;
+        }
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset, meter_att};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process (no bypass)
     meters.fall(numsamples);
@@ -184,6 +188,8 @@ multibandlimiter_audio_module::multibandlimiter_audio_module()
     over                = 1;
     buffer_size         = 0;
     overall_buffer_size = 0;
+    allocated_size      = 0;
+    buffer              = NULL;
     channels            = 2;
     asc_led             = 0.f;
     attack_old          = -1.f;
@@ -293,15 +299,43 @@ void multibandlimiter_audio_module::params_changed()
     }
 }
 
+uint32_t multibandlimiter_audio_module::get_latency()
+{
+    // the strips and the broadband limiter look ahead by the same time
+    int o = (int)over;
+    return resampler[0][0].get_latency() + (strip[0].get_latency() + broadband.get_latency() + o / 2) / o;
+}
+
 void multibandlimiter_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
+    allocate_buffers(srate);
     set_srates();
     int meter[] = {param_meter_inL, param_meter_inR,  param_meter_outL, param_meter_outR, -param_att0, -param_att1, -param_att2, -param_att3};
     int clip[] = {param_clip_inL, param_clip_inR, param_clip_outL, param_clip_outR, -1, -1, -1, -1};
     meters.init(params, meter, clip, 8, srate);
 }
 
+void multibandlimiter_audio_module::allocate_buffers(uint32_t sr)
+{
+    // enough for the highest oversampling, so that set_srates() never allocates
+    uint32_t max_over = (uint32_t)param_props[param_oversampling].max;
+    broadband.allocate(sr * max_over);
+    for (int j = 0; j < strips; j ++)
+        strip[j].allocate(sr * max_over);
+    unsigned int size = (int)(sr * (100.f / 1000.f) * channels * max_over) + channels;
+    if (size > allocated_size) {
+        free(buffer);
+        buffer = (float*) calloc(size, sizeof(float));
+        allocated_size = size;
+    }
+}
+
+void multibandlimiter_audio_module::post_instantiate(uint32_t sr)
+{
+    allocate_buffers(sr);
+}
+
 void multibandlimiter_audio_module::set_srates()
 {
     broadband.set_sample_rate(srate * over);
@@ -313,7 +347,9 @@ void multibandlimiter_audio_module::set_srates()
     }
     // rebuild buffer
     overall_buffer_size = (int)(srate * (100.f / 1000.f) * channels * over) + channels; // buffer size max attack rate
-    buffer = (float*) calloc(overall_buffer_size, sizeof(float));
+    if (overall_buffer_size > allocated_size)
+        allocate_buffers(srate);
+    memset(buffer, 0, overall_buffer_size * sizeof(float));
     pos = 0;
 }
 
@@ -338,14 +374,14 @@ uint32_t multibandlimiter_audio_module::process(uint32_t offset, uint32_t numsam
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 1, 1, 1, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
         asc_led    = 0.f;
     } else {
         // process all strips
         asc_led     -= std::min(asc_led, numsamples);
+        float meter_values[4 + strips][MAX_SAMPLE_RUN];
         while(offset < numsamples) {
             float inL  = 0.f; // input
             float inR  = 0.f;
@@ -497,12 +533,13 @@ uint32_t multibandlimiter_audio_module::process(uint32_t offset, uint32_t numsam
             
             batt = broadband.get_attenuation();
             
-            float values[] = {inL, inR, outL, outR,
-                bypassed ? (float)1.0 : (float)strip[0].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[1].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[2].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[3].get_attenuation() * batt};
-            meters.process(values);
+            uint32_t m = offset - 1 - orig_offset;
+            meter_values[0][m] = inL;
+            meter_values[1][m] = inR;
+            meter_values[2][m] = outL;
+            meter_values[3][m] = outR;
+            for (int i = 0; i < strips; i++)
+                meter_values[4 + i][m] = strip[i].get_attenuation() * batt;
             
             
             
@@ -549,6 +586,10 @@ uint32_t multibandlimiter_audio_module::process(uint32_t offset, uint32_t numsam
             //}
             cnt++;
         } // cycle trough samples
+        const float *values[4 + strips];
+        for (int i = 0; i < 4 + strips; i++)
+            values[i] = meter_values[i];
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process (no bypass)
     if (params[param_asc_led] != NULL) *params[param_asc_led] = asc_led;
@@ -576,6 +617,8 @@ sidechainlimiter_audio_module::sidechainlimiter_audio_module()
     over                = 1;
     buffer_size         = 0;
     overall_buffer_size = 0;
+    allocated_size      = 0;
+    buffer              = NULL;
     channels            = 2;
     asc_led             = 0.f;
     attack_old          = -1.f;
@@ -688,15 +731,43 @@ void sidechainlimiter_audio_module::params_changed()
     }
 }
 
+uint32_t sidechainlimiter_audio_module::get_latency()
+{
+    // the strips and the broadband limiter look ahead by the same time
+    int o = (int)over;
+    return resampler[0][0].get_latency() + (strip[0].get_latency() + broadband.get_latency() + o / 2) / o;
+}
+
 void sidechainlimiter_audio_module::set_sample_rate(uint32_t sr)
 {
     srate = sr;
+    allocate_buffers(srate);
     set_srates();
     int meter[] = {param_meter_inL, param_meter_inR, param_meter_scL, param_meter_scR, param_meter_outL, param_meter_outR, -param_att0, -param_att1, -param_att2, -param_att3, -param_att_sc};
     int clip[] = {param_clip_inL, param_clip_inR, -1, -1, param_clip_outL, param_clip_outR, -1, -1, -1, -1, -1};
     meters.init(params, meter, clip, 8, srate);
 }
 
+void sidechainlimiter_audio_module::allocate_buffers(uint32_t sr)
+{
+    // enough for the highest oversampling, so that set_srates() never allocates
+    uint32_t max_over = (uint32_t)param_props[param_oversampling].max;
+    broadband.allocate(sr * max_over);
+    for (int j = 0; j < strips; j ++)
+        strip[j].allocate(sr * max_over);
+    unsigned int size = (int)(sr * (100.f / 1000.f) * channels * max_over) + channels;
+    if (size > allocated_size) {
+        free(buffer);
+        buffer = (float*) calloc(size, sizeof(float));
+        allocated_size = size;
+    }
+}
+
+void sidechainlimiter_audio_module::post_instantiate(uint32_t sr)
+{
+    allocate_buffers(sr);
+}
+
 void sidechainlimiter_audio_module::set_srates()
 {
     broadband.set_sample_rate(srate * over);
@@ -708,7 +779,9 @@ void sidechainlimiter_audio_module::set_srates()
     }
     // rebuild buffer
     overall_buffer_size = (int)(srate * (100.f / 1000.f) * channels * over) + channels; // buffer size max attack rate
-    buffer = (float*) calloc(overall_buffer_size, sizeof(float));
+    if (overall_buffer_size > allocated_size)
+        allocate_buffers(srate);
+    memset(buffer, 0, overall_buffer_size * sizeof(float));
     pos = 0;
 }
 
@@ -733,14 +806,14 @@ uint32_t sidechainlimiter_audio_module::process(uint32_t offset, uint32_t numsam
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 1};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
         asc_led    = 0.f;
     } else {
         // process all strips
         asc_led     -= std::min(asc_led, numsamples);
+        float meter_values[6 + strips][MAX_SAMPLE_RUN];
         while(offset < numsamples) {
             float inL  = 0.f; // input
             float inR  = 0.f;
@@ -879,16 +952,22 @@ uint32_t sidechainlimiter_audio_module::process(uint32_t offset, uint32_t numsam
             
             batt = broadband.get_attenuation();
             
-            float values[] = {inL, inR, scL, scR, outL, outR,
-                bypassed ? (float)1.0 : (float)strip[0].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[1].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[2].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[3].get_attenuation() * batt,
-                bypassed ? (float)1.0 : (float)strip[4].get_attenuation() * batt};
-            meters.process(values);
+            uint32_t m = offset - 1 - orig_offset;
+            meter_values[0][m] = inL;
+            meter_values[1][m] = inR;
+            meter_values[2][m] = scL;
+            meter_values[3][m] = scR;
+            meter_values[4][m] = outL;
+            meter_values[5][m] = outR;
+            for (int i = 0; i < strips; i++)
+                meter_values[6 + i][m] = strip[i].get_attenuation() * batt;
             
             cnt++;
         } // cycle trough samples
+        const float *values[6 + strips];
+        for (int i = 0; i < 6 + strips; i++)
+            values[i] = meter_values[i];
+        meters.process(values, orig_numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process (no bypass)
     if (params[param_asc_led] != NULL) *params[param_asc_led] = asc_led;
@@ -355,9 +355,8 @@ uint32_t rotary_speaker_audio_module::process(uint32_t offset, uint32_t nsamples
         for (unsigned int i = offset; i < nsamples + offset; i++) {
             outs[0][i] = ins[0][i];
             outs[1][i] = ins[1][i];
-            float values[] = {0,0,0,0};
-            meters.process(values);
         }
+        meters.process(NULL, nsamples);
     } else {
         if (true)
         {
@@ -414,10 +413,10 @@ uint32_t rotary_speaker_audio_module::process(uint32_t offset, uint32_t nsamples
             delay.put(in_mono);
             phase_l += dphase_l;
             phase_h += dphase_h;
-            
-            float values[] = {in_l, in_r, outs[0][i + offset], outs[1][i + offset]};
-            meters.process(values);
         }
+        const float *values[] = {ins[0] + offset, ins[1] + offset, outs[0] + offset, outs[1] + offset};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, nsamples, scale);
         crossover1l.sanitize();
         crossover1r.sanitize();
         crossover2l.sanitize();
@@ -524,10 +523,9 @@ uint32_t multichorus_audio_module::process(uint32_t offset, uint32_t numsamples,
 {
     left.process(outs[0] + offset, ins[0] + offset, numsamples, *params[param_on] > 0.5, *params[param_level_in], *params[param_level_out]);
     right.process(outs[1] + offset, ins[1] + offset, numsamples, *params[param_on] > 0.5, *params[param_level_in], *params[param_level_out]);
-    for (uint32_t i = offset; i < offset + numsamples; i++) {
-        float values[] = {ins[0][i] * *params[param_level_in], ins[1][i] * *params[param_level_in], outs[0][i], outs[1][i]};
-        meters.process(values);
-    }
+    const float *values[] = {ins[0] + offset, ins[1] + offset, outs[0] + offset, outs[1] + offset};
+    float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+    meters.process(values, numsamples, scale);
     meters.fall(numsamples);
     return outputs_mask; // XXXKF allow some delay after input going blank
 }
@@ -726,11 +724,11 @@ uint32_t pulsator_audio_module::process(uint32_t offset, uint32_t numsamples, ui
         lfoL.advance(numsamples);
         lfoR.advance(numsamples);
         
-        float values[] = {0, 0, 0, 0};
-        meters.process(values);
+        meters.process(NULL, numsamples);
     } else {
         // process
         uint32_t orig_offset = offset;
+        float meter_inL[MAX_SAMPLE_RUN], meter_inR[MAX_SAMPLE_RUN];
         while(offset < samples) {
             // cycle through samples
             float outL = 0.f;
@@ -745,6 +743,8 @@ uint32_t pulsator_audio_module::process(uint32_t offset, uint32_t numsamples, ui
                 inL = (inL + inR) * 0.5;
                 inR = inL;
             }
+            meter_inL[offset - orig_offset] = inL;
+            meter_inR[offset - orig_offset] = inR;
             float procL = inL;
             float procR = inR;
             
@@ -767,11 +767,9 @@ uint32_t pulsator_audio_module::process(uint32_t offset, uint32_t numsamples, ui
             // advance lfo's
             lfoL.advance(1);
             lfoR.advance(1);
-            
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
-
         } // cycle trough samples
+        const float *values[] = {meter_inL, meter_inR, outs[0] + orig_offset, outs[1] + orig_offset};
+        meters.process(values, numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
     }
     meters.fall(numsamples);
@@ -889,8 +887,7 @@ uint32_t ringmodulator_audio_module::process(uint32_t offset, uint32_t numsample
         modL.advance(numsamples);
         modR.advance(numsamples);
         
-        float values[] = {0, 0, 0, 0};
-        meters.process(values);
+        meters.process(NULL, numsamples);
     } else {
         // process
         uint32_t orig_offset = offset;
@@ -971,11 +968,10 @@ uint32_t ringmodulator_audio_module::process(uint32_t offset, uint32_t numsample
             lfo2.advance(1);
             modL.advance(1);
             modR.advance(1);
-            
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
-
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
     }
     *params[param_lfo1_activity] = led1;
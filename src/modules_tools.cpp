@@ -68,20 +68,12 @@ void stereo_audio_module::params_changed() {
 uint32_t stereo_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
     uint32_t orig_offset = offset;
+    float meter_inL[MAX_SAMPLE_RUN], meter_inR[MAX_SAMPLE_RUN];
     for(uint32_t i = offset; i < offset + numsamples; i++) {
         if(bypassed) {
             outs[0][i] = ins[0][i];
             outs[1][i] = ins[1][i];
-            meter_inL  = 0.f;
-            meter_inR  = 0.f;
-            meter_outL = 0.f;
-            meter_outR = 0.f;
         } else {
-            meter_inL = 0.f;
-            meter_inR = 0.f;
-            meter_outL = 0.f;
-            meter_outR = 0.f;
-            
             float L = ins[0][i];
             float R = ins[1][i];
             
@@ -100,8 +92,8 @@ uint32_t stereo_audio_module::process(uint32_t offset, uint32_t numsamples, uint
             }
             
             // GUI stuff
-            meter_inL = L;
-            meter_inR = R;
+            meter_inL[i - orig_offset] = L;
+            meter_inR[i - orig_offset] = R;
             
             // modes
             float slev = *params[param_slev];       // slev - stereo level ( -2 -> 2 )
@@ -214,9 +206,6 @@ uint32_t stereo_audio_module::process(uint32_t offset, uint32_t numsamples, uint
             outs[0][i] = L;
             outs[1][i] = R;
             
-            meter_outL = L;
-            meter_outR = R;
-            
             // phase meter
             if(fabs(L) > 0.001 and fabs(R) > 0.001) {
                 meter_phase = fabs(fabs(L+R) > 0.000000001 ? sin(fabs((L-R)/(L+R))) : 0.f);
@@ -224,11 +213,13 @@ uint32_t stereo_audio_module::process(uint32_t offset, uint32_t numsamples, uint
                 meter_phase = 0.f;
             }
         }
-        float values[] = {meter_inL, meter_inR, meter_outL, meter_outR};
-        meters.process(values);
     }
-    if (!bypassed)
+    if (!bypassed) {
+        const float *values[] = {meter_inL, meter_inR, outs[0] + orig_offset, outs[1] + orig_offset};
+        meters.process(values, numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
+    } else
+        meters.process(NULL, numsamples);
     meters.fall(numsamples);
     return outputs_mask;
 }
@@ -251,9 +242,6 @@ void stereo_audio_module::set_sample_rate(uint32_t sr)
 
 mono_audio_module::mono_audio_module() {
     active      = false;
-    meter_in    = 0.f;
-    meter_outL  = 0.f;
-    meter_outR  = 0.f;
     _phase      = -1.f;
     _sc_level   = 0.f;
 }
@@ -283,18 +271,12 @@ void mono_audio_module::params_changed() {
 uint32_t mono_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
     bool bypassed = bypass.update(*params[param_bypass] > 0.5f, numsamples);
     uint32_t orig_offset = offset;
+    float meter_in[MAX_SAMPLE_RUN];
     for(uint32_t i = offset; i < offset + numsamples; i++) {
         if(bypassed) {
             outs[0][i] = ins[0][i];
             outs[1][i] = ins[0][i];
-            meter_in    = 0.f;
-            meter_outL  = 0.f;
-            meter_outR  = 0.f;
         } else {
-            meter_in     = 0.f;
-            meter_outL   = 0.f;
-            meter_outR   = 0.f;
-            
             float L = ins[0][i];
             
             // levels in
@@ -308,7 +290,7 @@ uint32_t mono_audio_module::process(uint32_t offset, uint32_t numsamples, uint32
             }
             
             // GUI stuff
-            meter_in = L;
+            meter_in[i - orig_offset] = L;
             
             float R = L;
             
@@ -362,15 +344,14 @@ uint32_t mono_audio_module::process(uint32_t offset, uint32_t numsamples, uint32
             //output
             outs[0][i] = L;
             outs[1][i] = R;
-            
-            meter_outL = L;
-            meter_outR = R;
         }
-        float values[] = {meter_in, meter_outL, meter_outR};
-        meters.process(values);
     }
-    if (!bypassed)
+    if (!bypassed) {
+        const float *values[] = {meter_in, outs[0] + orig_offset, outs[1] + orig_offset};
+        meters.process(values, numsamples);
         bypass.crossfade(ins, outs, 2, orig_offset, numsamples);
+    } else
+        meters.process(NULL, numsamples);
     meters.fall(numsamples);
     return outputs_mask;
 }
@@ -494,9 +475,6 @@ uint32_t analyzer_audio_module::process(uint32_t offset, uint32_t numsamples, ui
         ppos += 2;
         ppos %= (phase_buffer_size - 2);
         
-        // analyzer
-        _analyzer.process(L, R);
-        
         // meter
         meter_L = L;
         meter_R = R;
@@ -505,6 +483,8 @@ uint32_t analyzer_audio_module::process(uint32_t offset, uint32_t numsamples, ui
         outs[0][i] = L;
         outs[1][i] = R;
     }
+    // analyzer
+    _analyzer.process(ins[0] + offset, ins[1] + offset, numsamples);
     // draw meters
     SET_IF_CONNECTED(clip_L);
     SET_IF_CONNECTED(clip_R);
@@ -668,10 +648,9 @@ uint32_t multibandenhancer_audio_module::process(uint32_t offset, uint32_t numsa
             
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
         // process all strips
         while(offset < numsamples) {
@@ -710,7 +689,14 @@ uint32_t multibandenhancer_audio_module::process(uint32_t offset, uint32_t numsa
                 L = tmpL;
                 R = tmpR;
                 if (solo[i] || no_solo) {
-                    // process harmonics
+                    // process harmonics, strips without drive are delayed
+                    // by the oversampling latency to keep the bands aligned
+                    // (simple_delay reads before writing, so it can't do a zero delay)
+                    int latency = dist[i][0].get_latency();
+                    if (latency) {
+                        L = dry[i][0].process(tmpL, latency);
+                        R = dry[i][1].process(tmpR, latency);
+                    }
                     if (*params[param_drive0 + i]) {
                         L = dist[i][0].process(tmpL);
                         R = dist[i][1].process(tmpR);
@@ -746,10 +732,10 @@ uint32_t multibandenhancer_audio_module::process(uint32_t offset, uint32_t numsa
 
             // next sample
             ++offset;
-            
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, ins[1] + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {*params[param_level_in], *params[param_level_in], 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process (no bypass)
     meters.fall(numsamples);
@@ -826,6 +812,8 @@ void multispread_audio_module::params_changed()
             gain2 = 1. / *params[param_amount0 + int(i / filters)];
             L[i].set_peakeq_rbj(pow(10, fcoeff + (0.5f + (float)i) * 3.f / (float)amount), q, (i % 2) ? gain1 : gain2, (double)srate);
             R[i].set_peakeq_rbj(pow(10, fcoeff + (0.5f + (float)i) * 3.f / (float)amount), q, (i % 2) ? gain2 : gain1, (double)srate);
+            bankL.copy_coeffs(i, L[i]);
+            bankR.copy_coeffs(i, R[i]);
         }
     }
 }
@@ -854,8 +842,6 @@ uint32_t multispread_audio_module::process(uint32_t offset, uint32_t numsamples,
         while(offset < numsamples) {
             outs[0][offset] = ins[0][offset];
             outs[1][offset] = *params[param_mono] > 0.5 ? ins[0][offset] : ins[1][offset];
-            float values[] = {0, 0, 0, 0};
-            meters.process(values);
             // phase buffer handling
             phase_buffer[ppos]     = 0;
             phase_buffer[ppos + 1] = 0;
@@ -864,27 +850,28 @@ uint32_t multispread_audio_module::process(uint32_t offset, uint32_t numsamples,
             ppos %= (phase_buffer_size - 2);
             ++offset;
         }
+        meters.process(NULL, orig_numsamples);
     } else {
-        // process all strips
+        // filter the whole block through both chains first
+        int amount = filters * 4;
+        float level_in = *params[param_level_in];
+        const float *srcR = *params[param_mono] > 0.5 ? ins[0] : ins[1];
+        float filteredL[256], filteredR[256];
+        uint32_t chunk_start = offset, chunk_end = offset;
         while(offset < numsamples) {
-            float inL  = ins[0][offset]; // input
-            float inR  = *params[param_mono] > 0.5 ? ins[0][offset] : ins[1][offset];
-            float outL = 0.f; // final output
-            float outR = 0.f;
-            
-            // in level
-            inR *= *params[param_level_in];
-            inL *= *params[param_level_in];
-            
-            outL = inL;
-            outR = inR;
-            
-            // filters
-            int amount = filters * 4;
-            for (int i = 0; i < amount; i++) {
-                outL = L[i].process(outL);
-                outR = R[i].process(outR);
+            if (offset == chunk_end) {
+                chunk_start = offset;
+                chunk_end = std::min(numsamples, offset + 256);
+                for (uint32_t i = chunk_start; i < chunk_end; i++) {
+                    filteredL[i - chunk_start] = ins[0][i] * level_in;
+                    filteredR[i - chunk_start] = srcR[i] * level_in;
+                }
+                bankL.process_cascade(filteredL, filteredL, chunk_end - chunk_start, amount);
+                bankR.process_cascade(filteredR, filteredR, chunk_end - chunk_start, amount);
             }
+            float outL = filteredL[offset - chunk_start]; // final output
+            float outR = filteredR[offset - chunk_start];
+            
             // out level
             outL *= *params[param_level_out];
             outR *= *params[param_level_out];
@@ -909,10 +896,10 @@ uint32_t multispread_audio_module::process(uint32_t offset, uint32_t numsamples,
             
             // next sample
             ++offset;
-            
-            float values[] = {inL, inR, outL, outR};
-            meters.process(values);
         } // cycle trough samples
+        const float *values[] = {ins[0] + orig_offset, srcR + orig_offset, outs[0] + orig_offset, outs[1] + orig_offset};
+        float scale[] = {level_in, level_in, 1, 1};
+        meters.process(values, orig_numsamples, scale);
         bypass.crossfade(ins, outs, 2, orig_offset, orig_numsamples);
     } // process (no bypass)
     meters.fall(numsamples);
@@ -973,18 +960,7 @@ void widgets_audio_module::params_changed() {
 }
 
 uint32_t widgets_audio_module::process(uint32_t offset, uint32_t numsamples, uint32_t inputs_mask, uint32_t outputs_mask) {
-    float meter_1, meter_2, meter_3, meter_4;
-    for(uint32_t i = offset; i < offset + numsamples; i++) {
-        meter_1 = 0.f;
-        meter_2 = 0.f;
-        meter_3 = 0.f;
-        meter_4 = 0.f;
-        
-        //float L = ins[0][i];
-        //float R = ins[1][i];
-        float values[] = {meter_1, meter_2, meter_3, meter_4};
-        meters.process(values);
-    }
+    meters.process(NULL, numsamples);
     meters.fall(numsamples);
     return outputs_mask;
 }
@@ -20,6 +20,7 @@
  */
 #include <calf/giface.h>
 #include <calf/modules_synths.h>
+#include <calf/wavecache.h>
 
 using namespace dsp;
 using namespace calf_plugins;
@@ -85,6 +86,15 @@ void monosynth_audio_module::precalculate_waves(progress_report_iface *reporter)
     static waveform_family<MONOSYNTH_WAVE_BITS> waves_data[wave_count];
     waves = waves_data;
     
+    // bump the version whenever the waveforms below change
+    wave_cache cache("monosynth", 1);
+    if (cache.open() && cache.load(waves, wave_count))
+    {
+        if (reporter)
+            reporter->report_progress(100, "");
+        return;
+    }
+    
     enum { S = 1 << MONOSYNTH_WAVE_BITS, HS = S / 2, QS = S / 4, QS3 = 3 * QS };
     float iQS = 1.0 / QS;
     
@@ -199,6 +209,8 @@ void monosynth_audio_module::precalculate_waves(progress_report_iface *reporter)
     }
     normalize_waveform(data, S);
     waves[wave_test8].make(bl, data);
+    cache.store(waves, wave_count);
+    cache.save();
     if (reporter)
         reporter->report_progress(100, "");
     
@@ -804,6 +816,7 @@ uint32_t monosynth_audio_module::process(uint32_t offset, uint32_t nsamples, uin
     uint32_t op = offset;
     uint32_t op_end = offset + nsamples;
     int had_data = 0;
+    update_modmatrix();
     while(op < op_end) {
         if (output_pos == 0) 
             calculate_step();
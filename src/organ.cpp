@@ -22,6 +22,7 @@
 
 #include <calf/giface.h>
 #include <calf/organ.h>
+#include <calf/wavecache.h>
 #include <iostream>
 
 using namespace std;
@@ -257,6 +258,16 @@ void organ_voice_base::precalculate_waves(progress_report_iface *reporter)
         organ_voice_base::waves = &waves;
         organ_voice_base::big_waves = &big_waves;
         
+        // bump the version whenever the waveforms below change
+        wave_cache cache("organ", 1);
+        if (cache.open() && cache.load(waves, wave_count_small) && cache.load(big_waves, wave_count_big))
+        {
+            inited = true;
+            if (reporter)
+                reporter->report_progress(100, "");
+            return;
+        }
+        
         float progress = 0.0;
         int totalwaves = 1 + wave_count_big;
         if (reporter)
@@ -498,6 +509,9 @@ void organ_voice_base::precalculate_waves(progress_report_iface *reporter)
         padsynth(bl, blBig, big_waves[wave_choir3 - wave_count_small], 50, 10);
         LARGE_WAVEFORM_PROGRESS();
         
+        cache.store(waves, wave_count_small);
+        cache.store(big_waves, wave_count_big);
+        cache.save();
         inited = true;
     }
 }
@@ -701,6 +715,64 @@ void organ_voice::update_pitch()
     dphase.set(dsp::midi_note_to_phase(note, 100 * parameters->global_transpose + parameters->global_detune, sample_rate) * inertia_pitchbend.get_last());
 }
 
+/// Structure-of-arrays state of the drawbars sounding in one block of a
+/// voice. Phases are fixed point with 20 fractional bits and grow without
+/// wrapping; masking the table index takes care of both the 32-bit
+/// wraparound of the small waves and the length of the big ones.
+struct organ_drawbar_batch
+{
+    enum { MaxBars = 9, BlockSize = 64 };
+    int count;
+    const float *data[MaxBars];
+    uint64_t phase[MaxBars], delta[MaxBars];
+    uint32_t mask[MaxBars];
+    float ampl[MaxBars], ampr[MaxBars];
+    float (*out[MaxBars])[2];
+
+    organ_drawbar_batch() : count(0) {}
+    void add(const float *_data, uint64_t _phase, uint64_t _delta, uint32_t _mask, float _ampl, float _ampr, float (*_out)[2])
+    {
+        data[count] = _data;
+        phase[count] = _phase;
+        delta[count] = _delta;
+        mask[count] = _mask;
+        ampl[count] = _ampl;
+        ampr[count] = _ampr;
+        out[count] = _out;
+        count++;
+    }
+    /// Add all drawbars to their output buffers, four samples at a time
+    void render()
+    {
+        typedef uint64_t u64x4 __attribute__((vector_size(32)));
+        typedef int32_t i32x4 __attribute__((vector_size(16)));
+        typedef float f32x4 __attribute__((vector_size(16)));
+        float mono[BlockSize] __attribute__((aligned(16)));
+        for (int h = 0; h < count; h++)
+        {
+            const float *d = data[h];
+            uint64_t ph0 = phase[h], dph = delta[h], m = mask[h];
+            u64x4 ph = { ph0, ph0 + dph, ph0 + 2 * dph, ph0 + 3 * dph };
+            u64x4 step = { 4 * dph, 4 * dph, 4 * dph, 4 * dph };
+            for (int i = 0; i < BlockSize; i += 4)
+            {
+                u64x4 pos = (ph >> 20) & m;
+                f32x4 frac = __builtin_convertvector(__builtin_convertvector(ph & 0xFFFFF, i32x4), f32x4) * (1.f / (1 << 20));
+                f32x4 a = { d[pos[0]], d[pos[1]], d[pos[2]], d[pos[3]] };
+                f32x4 b = { d[pos[0] + 1], d[pos[1] + 1], d[pos[2] + 1], d[pos[3] + 1] };
+                *(f32x4 *)(mono + i) = a + (b - a) * frac;
+                ph += step;
+            }
+            float l = ampl[h], r = ampr[h];
+            float (*o)[2] = out[h];
+            for (int i = 0; i < BlockSize; i++) {
+                o[i][0] += mono[i] * l;
+                o[i][1] += mono[i] * r;
+            }
+        }
+    }
+};
+
 void organ_voice::render_block(int snapshot) {
     if (note == -1)
         return;
@@ -717,9 +789,10 @@ void organ_voice::render_block(int snapshot) {
     inertia_pitchbend.set_inertia(parameters->pitch_bend);
     inertia_pitchbend.step();
     update_pitch();
-    dsp::fixed_point<int, 20> tphase, tdphase;
+    dsp::fixed_point<int, 20> tphase;
     unsigned int foldvalue = parameters->foldvalue * inertia_pitchbend.get_last();
     int vibrato_mode = fastf2i_drm(parameters->lfo_mode);
+    organ_drawbar_batch batch;
     for (int h = 0; h < 9; h++)
     {
         float amp = parameters->drawbars[h];
@@ -732,25 +805,18 @@ void organ_voice::render_block(int snapshot) {
             waveid = 0;
 
         uint32_t rate = (dphase * hm).get();
+        float ampl = amp * 0.5f * (1 - parameters->pan[h]);
+        float ampr = amp * 0.5f * (1 + parameters->pan[h]);
+        float (*out)[Channels] = aux_buffers[dsp::fastf2i_drm(parameters->routing[h])];
         if (waveid >= wave_count_small)
         {
             data = (*big_waves)[waveid - wave_count_small].get_level(rate >> (ORGAN_BIG_WAVE_BITS - ORGAN_WAVE_BITS + ORGAN_BIG_WAVE_SHIFT));
             if (!data)
                 continue;
             hm.set(hm.get() >> ORGAN_BIG_WAVE_SHIFT);
-            dsp::fixed_point<int64_t, 20> tphase, tdphase;
+            dsp::fixed_point<int64_t, 20> tphase;
             tphase.set(((phase * hm).get()) + parameters->phaseshift[h]);
-            tdphase.set(rate >> ORGAN_BIG_WAVE_SHIFT);
-            float ampl = amp * 0.5f * (1 - parameters->pan[h]);
-            float ampr = amp * 0.5f * (1 + parameters->pan[h]);
-            float (*out)[Channels] = aux_buffers[dsp::fastf2i_drm(parameters->routing[h])];
-            
-            for (int i=0; i < (int)BlockSize; i++) {
-                float wv = big_wave(data, tphase);
-                out[i][0] += wv * ampl;
-                out[i][1] += wv * ampr;
-                tphase += tdphase;
-            }
+            batch.add(data, tphase.get(), rate >> ORGAN_BIG_WAVE_SHIFT, ORGAN_BIG_WAVE_SIZE - 1, ampl, ampr, out);
         }
         else
         {
@@ -765,19 +831,10 @@ void organ_voice::render_block(int snapshot) {
             if (!data)
                 continue;
             tphase.set((uint32_t)((phase * hm).get()) + parameters->phaseshift[h]);
-            tdphase.set((uint32_t)rate);
-            float ampl = amp * 0.5f * (1 - parameters->pan[h]);
-            float ampr = amp * 0.5f * (1 + parameters->pan[h]);
-            float (*out)[Channels] = aux_buffers[dsp::fastf2i_drm(parameters->routing[h])];
-            
-            for (int i=0; i < (int)BlockSize; i++) {
-                float wv = wave(data, tphase);
-                out[i][0] += wv * ampl;
-                out[i][1] += wv * ampr;
-                tphase += tdphase;
-            }
+            batch.add(data, (uint32_t)tphase.get(), rate, ORGAN_WAVE_SIZE - 1, ampl, ampr, out);
         }
     }
+    batch.render();
     
     bool is_quad = parameters->quad_env >= 0.5f;
     
@@ -947,11 +1004,9 @@ void drawbar_organ::update_params()
     parameters->foldvalue = (int)(dphase);
 }
 
-dsp::voice *drawbar_organ::alloc_voice()
+void drawbar_organ::init_voice(block_voice<organ_voice> *v)
 {
-    block_voice<organ_voice> *v = new block_voice<organ_voice>();
     v->parameters = parameters;
-    return v;
 }
 
 void drawbar_organ::percussion_note_on(int note, int vel)
@@ -1078,7 +1133,7 @@ void drawbar_organ::render_separate(float *output[], int nsamples)
 {
     float buf[MAX_SAMPLE_RUN][2];
     dsp::zero(&buf[0][0], 2 * nsamples);
-    basic_synth::render_to(buf, nsamples);
+    render_to(buf, nsamples);
     if (dsp::fastf2i_drm(parameters->lfo_mode) == organ_voice_base::lfomode_global)
     {
         for (int i = 0; i < nsamples; i += 64)
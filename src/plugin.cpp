@@ -41,6 +41,7 @@ using namespace calf_plugins;
 template<class Module> LV2_Descriptor calf_plugins::lv2_wrapper<Module>::descriptor;
 template<class Module> LV2_Calf_Descriptor calf_plugins::lv2_wrapper<Module>::calf_descriptor;
 template<class Module> LV2_State_Interface calf_plugins::lv2_wrapper<Module>::state_iface;
+template<class Module> LV2_Worker_Interface calf_plugins::lv2_wrapper<Module>::work_iface;
 
 extern "C" {
 
@@ -151,6 +151,7 @@ void preset_list::plugin_snapshot::reset()
     instance_name.clear();
     preset_offset = input_index = output_index = midi_index = 0;
     automation_entries.clear();
+    links.clear();
 }
 
 void preset_list::xml_start_element_handler(void *user_data, const char *name, const char *attrs[])
@@ -204,6 +205,21 @@ void preset_list::xml_start_element_handler(void *user_data, const char *name, c
             state = AUTOMATION_ENTRY;
             return;
         }
+        if (!strcmp(name, "link"))
+        {
+            input_link link = { -1, -1, -1 };
+            for(; *attrs; attrs += 2) {
+                if (!strcmp(*attrs, "input")) link.input = atoi(attrs[1]);
+                else
+                if (!strcmp(*attrs, "plugin")) link.plugin = atoi(attrs[1]);
+                else
+                if (!strcmp(*attrs, "output")) link.output = atoi(attrs[1]);
+            }
+            if (link.input >= 0 && link.plugin >= 0 && link.output >= 0)
+                self.parser_plugin.links.push_back(link);
+            state = LINK_ENTRY;
+            return;
+        }
         // fall through
     case LIST:
         if (!strcmp(name, "preset")) {
@@ -267,6 +283,9 @@ void preset_list::xml_start_element_handler(void *user_data, const char *name, c
     case AUTOMATION_ENTRY:
         // no nested elements allowed inside <automation>
         break;
+    case LINK_ENTRY:
+        // no nested elements allowed inside <link>
+        break;
     }
     // g_warning("Invalid XML element: %s", name);
     throw preset_exception("Invalid XML element: %s", name, 0);
@@ -289,6 +308,13 @@ void preset_list::xml_end_element_handler(void *user_data, const char *name)
             return;
         }
         break;
+    case LINK_ENTRY:
+        if (!strcmp(name, "link"))
+        {
+            state = PLUGIN;
+            return;
+        }
+        break;
     case LIST:
         if (!strcmp(name, "presets")) {
             state = START;
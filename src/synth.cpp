@@ -19,10 +19,146 @@
  * Boston, MA  02110-1301  USA
  */
 #include <calf/synth.h>
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <algorithm>
 
 using namespace dsp;
 using namespace std;
 
+static inline void spin_pause()
+{
+#if defined(__i386__) || defined(__x86_64__)
+    __builtin_ia32_pause();
+#endif
+}
+
+int voice_render_pool::default_threads = 1;
+
+voice_render_pool::voice_render_pool(int threads)
+{
+    buffers = new float[std::max(threads, 1)][MaxSamples][2];
+    job_voices = NULL;
+    job_count = job_samples = job_slices = 0;
+    next_slice = done_slices = 0;
+    running = active = 0;
+    quit = false;
+    sched_copied = false;
+    for (int i = 1; i < threads; i++)
+    {
+        worker *w = new worker;
+        w->owner = this;
+        sem_init(&w->wakeup, 0, 0);
+        if (pthread_create(&w->thread, NULL, worker_thread, w))
+        {
+            fprintf(stderr, "Could not create voice rendering thread %d, using %d threads\n", i, i);
+            sem_destroy(&w->wakeup);
+            delete w;
+            break;
+        }
+        workers.push_back(w);
+    }
+}
+
+voice_render_pool::~voice_render_pool()
+{
+    quit = true;
+    for (size_t i = 0; i < workers.size(); i++)
+        sem_post(&workers[i]->wakeup);
+    for (size_t i = 0; i < workers.size(); i++)
+    {
+        pthread_join(workers[i]->thread, NULL);
+        sem_destroy(&workers[i]->wakeup);
+        delete workers[i];
+    }
+    delete []buffers;
+}
+
+void voice_render_pool::render(voice **voices, int count, float (*output)[2], int nsamples)
+{
+    assert(nsamples <= MaxSamples);
+    if (!sched_copied)
+    {
+        // run the workers with the scheduling class and priority of the
+        // audio thread (done once, the first time the pool is used)
+        int policy;
+        struct sched_param param;
+        if (!pthread_getschedparam(pthread_self(), &policy, &param))
+            for (size_t i = 0; i < workers.size(); i++)
+                pthread_setschedparam(workers[i]->thread, policy, &param);
+        sched_copied = true;
+    }
+    job_voices = voices;
+    job_count = count;
+    job_samples = nsamples;
+    job_slices = std::min(count, get_thread_count());
+    __atomic_store_n(&next_slice, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&done_slices, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&running, 1, __ATOMIC_SEQ_CST);
+    for (int i = 0; i < job_slices - 1; i++)
+        sem_post(&workers[i]->wakeup);
+
+    work();
+    while(__atomic_load_n(&done_slices, __ATOMIC_ACQUIRE) < job_slices)
+        spin_pause();
+
+    // a worker woken too late must not start on a job that is over
+    __atomic_store_n(&running, 0, __ATOMIC_SEQ_CST);
+    while(__atomic_load_n(&active, __ATOMIC_SEQ_CST))
+        spin_pause();
+
+    for (int s = 0; s < job_slices; s++)
+        for (int i = 0; i < nsamples; i++)
+        {
+            output[i][0] += buffers[s][i][0];
+            output[i][1] += buffers[s][i][1];
+        }
+}
+
+void voice_render_pool::work()
+{
+    int s;
+    while((s = __atomic_fetch_add(&next_slice, 1, __ATOMIC_ACQ_REL)) < job_slices)
+    {
+        float (*buf)[2] = buffers[s];
+        memset(buf, 0, sizeof(float) * 2 * job_samples);
+        int first = s * job_count / job_slices, last = (s + 1) * job_count / job_slices;
+        for (int v = first; v < last; v++)
+            job_voices[v]->render_to(buf, job_samples);
+        __atomic_add_fetch(&done_slices, 1, __ATOMIC_RELEASE);
+    }
+}
+
+void *voice_render_pool::worker_thread(void *arg)
+{
+    worker *w = (worker *)arg;
+    voice_render_pool *self = w->owner;
+    while(true)
+    {
+        while(sem_wait(&w->wakeup) && errno == EINTR)
+            ;
+        if (self->quit)
+            break;
+        __atomic_add_fetch(&self->active, 1, __ATOMIC_SEQ_CST);
+        if (__atomic_load_n(&self->running, __ATOMIC_SEQ_CST))
+            self->work();
+        __atomic_sub_fetch(&self->active, 1, __ATOMIC_SEQ_CST);
+    }
+    return NULL;
+}
+
+void basic_synth::setup(int sr)
+{
+    sample_rate = sr;
+    hold = false;
+    sostenuto = false;
+    polyphony_limit = (unsigned)-1;
+    int threads = voice_render_pool::get_default_threads();
+    if (!render_pool && threads > 1)
+        render_pool = new voice_render_pool(threads);
+}
+
 void basic_synth::init_voices(int count)
 {
     allocated_voices.init(count);
@@ -202,6 +338,21 @@ void basic_synth::control_change(int ctl, int val)
 
 void basic_synth::render_to(float (*output)[2], int nsamples)
 {
+    if (render_pool && active_voices.size() > 1 && nsamples <= voice_render_pool::MaxSamples)
+    {
+        render_pool->render(active_voices.begin(), active_voices.size(), output, nsamples);
+        // voice bookkeeping stays on this thread
+        for (dsp::voice **i = active_voices.begin(); i != active_voices.end(); ) {
+            dsp::voice *v = *i;
+            if (!v->get_active()) {
+                i = active_voices.erase(i);
+                unused_voices.add(v);
+                continue;
+            }
+            i++;
+        }
+        return;
+    }
     // render voices, eliminate ones that aren't sounding anymore
     for (dsp::voice **i = active_voices.begin(); i != active_voices.end(); ) {
         dsp::voice *v = *i;
@@ -217,6 +368,7 @@ void basic_synth::render_to(float (*output)[2], int nsamples)
 
 basic_synth::~basic_synth()
 {
+    delete render_pool;
     for (voice_array::iterator i = allocated_voices.begin(); i != allocated_voices.end(); ++i)
         delete *i;
 }
@@ -0,0 +1,207 @@
+/* Calf DSP Library
+ * Persistent cache of precalculated waveform tables
+ *
+ * Copyright (C) 2001-2007 Krzysztof Foltman
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 2 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General
+ * Public License along with this program; if not, write to the
+ * Free Software Foundation, Inc., 51 Franklin Street, Fifth Floor,
+ * Boston, MA  02110-1301  USA
+ */
+#include <config.h>
+#include <calf/wavecache.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+using namespace std;
+using namespace dsp;
+
+namespace {
+
+enum { format_version = 1, byte_order_mark = 0x01020304 };
+
+struct file_header
+{
+    char magic[8];
+    uint32_t byte_order;
+    uint32_t format;
+    uint32_t version;
+    uint32_t reserved;
+    uint64_t payload_size;
+    uint64_t checksum;
+};
+
+struct record_header
+{
+    uint32_t bits;
+    uint32_t levels;
+};
+
+const char cache_magic[8] = { 'C', 'A', 'L', 'F', 'W', 'A', 'V', 'E' };
+
+/// Fletcher style checksum over 32-bit words (the payload is made of those)
+uint64_t checksum(const char *data, size_t size)
+{
+    uint64_t a = 0, b = 0;
+    for (size_t i = 0; i + 4 <= size; i += 4) {
+        uint32_t w;
+        memcpy(&w, data + i, 4);
+        a += w;
+        b += a;
+    }
+    return (b << 32) ^ a;
+}
+
+bool make_dir(const string &path)
+{
+    return mkdir(path.c_str(), 0755) == 0 || errno == EEXIST;
+}
+
+}
+
+wave_cache::wave_cache(const char *_name, uint32_t _version)
+: name(_name)
+, version(_version)
+, data(NULL)
+, size(0)
+, pos(0)
+{
+}
+
+string wave_cache::get_path() const
+{
+    const char *xdg = getenv("XDG_CACHE_HOME");
+    if (xdg && *xdg)
+        return string(xdg) + "/calf/" + name + ".wavecache";
+    const char *home = getenv("HOME");
+    if (home && *home)
+        return string(home) + "/.cache/calf/" + name + ".wavecache";
+    return string();
+}
+
+bool wave_cache::open()
+{
+    string path = get_path();
+    if (path.empty())
+        return false;
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+    struct stat st;
+    void *map = MAP_FAILED;
+    if (fstat(fd, &st) == 0 && st.st_size >= (off_t)sizeof(file_header))
+        map = mmap(NULL, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED)
+        return false;
+
+    const file_header *hdr = (const file_header *)map;
+    const char *payload = (const char *)map + sizeof(file_header);
+    size_t payload_size = st.st_size - sizeof(file_header);
+    if (memcmp(hdr->magic, cache_magic, sizeof(cache_magic))
+        || hdr->byte_order != byte_order_mark
+        || hdr->format != format_version
+        || hdr->version != version
+        || hdr->payload_size != payload_size
+        || hdr->checksum != checksum(payload, payload_size))
+    {
+        munmap(map, st.st_size);
+        return false;
+    }
+    data = (const char *)map;
+    size = st.st_size;
+    pos = sizeof(file_header);
+    return true;
+}
+
+bool wave_cache::check_records(uint32_t bits, int count) const
+{
+    if (!data)
+        return false;
+    size_t p = pos;
+    size_t level_size = sizeof(uint32_t) + ((1 << bits) + 1) * sizeof(float);
+    for (int i = 0; i < count; i++) {
+        if (p + sizeof(record_header) > size)
+            return false;
+        record_header rh;
+        memcpy(&rh, data + p, sizeof(rh));
+        p += sizeof(rh) + (1 << bits) * sizeof(float);
+        if (rh.bits != bits || p > size || rh.levels > (size - p) / level_size)
+            return false;
+        p += rh.levels * level_size;
+    }
+    return true;
+}
+
+uint32_t wave_cache::read_record_header()
+{
+    record_header rh;
+    memcpy(&rh, data + pos, sizeof(rh));
+    pos += sizeof(rh);
+    return rh.levels;
+}
+
+void wave_cache::write_record_header(uint32_t bits, uint32_t levels)
+{
+    record_header rh = { bits, levels };
+    append(&rh, sizeof(rh));
+}
+
+void wave_cache::append(const void *src, size_t bytes)
+{
+    const char *p = (const char *)src;
+    pending.insert(pending.end(), p, p + bytes);
+}
+
+bool wave_cache::save()
+{
+    string path = get_path();
+    if (path.empty() || pending.empty())
+        return false;
+    // create the cache directory and its parent if needed
+    string dir = path.substr(0, path.rfind('/'));
+    if (!make_dir(dir.substr(0, dir.rfind('/'))) || !make_dir(dir))
+        return false;
+
+    file_header hdr;
+    memcpy(hdr.magic, cache_magic, sizeof(cache_magic));
+    hdr.byte_order = byte_order_mark;
+    hdr.format = format_version;
+    hdr.version = version;
+    hdr.reserved = 0;
+    hdr.payload_size = pending.size();
+    hdr.checksum = checksum(&pending[0], pending.size());
+
+    // write to a private file and rename it, so that other processes
+    // never get to see a half written cache
+    char suffix[32];
+    sprintf(suffix, ".%d.tmp", (int)getpid());
+    string tmp_path = path + suffix;
+    FILE *f = fopen(tmp_path.c_str(), "wb");
+    if (!f)
+        return false;
+    bool ok = fwrite(&hdr, sizeof(hdr), 1, f) == 1
+        && fwrite(&pending[0], pending.size(), 1, f) == 1;
+    ok = (fclose(f) == 0) && ok;
+    if (!ok || rename(tmp_path.c_str(), path.c_str()) != 0) {
+        unlink(tmp_path.c_str());
+        return false;
+    }
+    pending.clear();
+    return true;
+}
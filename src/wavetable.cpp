@@ -20,6 +20,7 @@
  */
 
 #include <config.h>
+#include <errno.h>
 
 #if ENABLE_EXPERIMENTAL
     
@@ -119,7 +120,7 @@ void wavetable_voice::render_block(int current_snapshot)
     int ospc = md::par_o2level - md::par_o1level;
     float pb = moddest[md::moddest_pitch] + parent->control_snapshots[current_snapshot].pitchbend;
     for (int j = 0; j < OscCount; j++) {
-        oscs[j].tables = parent->tables[(int)*params[md::par_o1wave + j * ospc]];
+        oscs[j].tables = parent->bank->request((int)*params[md::par_o1wave + j * ospc]);
         oscs[j].set_freq(note_to_hz(note, *params[md::par_o1transpose + j * ospc] * 100+ *params[md::par_o1detune + j * ospc] + moddest[md::moddest_o1detune + j] + pb), sample_rate);
     }
         
@@ -129,16 +130,26 @@ void wavetable_voice::render_block(int current_snapshot)
     }
     float osstep[2] = { (oscshift[0] - last_oscshift[0]) * step, (oscshift[1] - last_oscshift[1]) * step };
     float oastep[2] = { (cur_oscamp[0] - last_oscamp[0]) * step, (cur_oscamp[1] - last_oscamp[1]) * step };
-    for (int i = 0; i < BlockSize; i++) {        
-        float value = 0.f;
-
-        for (int j = 0; j < OscCount; j++) {
+    int slices[OscCount][BlockSize];
+    float amps[OscCount][BlockSize];
+    for (int j = 0; j < OscCount; j++) {
+        for (int i = 0; i < BlockSize; i++) {
             float o = last_oscshift[j] * 0.01;
-            value += last_oscamp[j] * oscs[j].get(dsp::clip(fastf2i_drm(o * 127.0 * 256), 0, 127 * 256));
+            slices[j][i] = dsp::clip(fastf2i_drm(o * 127.0 * 256), 0, 127 * 256);
+            amps[j][i] = last_oscamp[j];
             last_oscshift[j] += osstep[j];
             last_oscamp[j] += oastep[j];
         }
-        
+    }
+    float values[OscCount][BlockSize];
+    for (int j = 0; j < OscCount; j++) {
+        if (oscs[j].tables)
+            oscs[j].render(values[j], slices[j], BlockSize);
+        else
+            dsp::zero(values[j], BlockSize);
+    }
+    for (int i = 0; i < BlockSize; i++) {
+        float value = amps[0][i] * values[0][i] + amps[1][i] * values[1][i];
         output_buffer[i][0] = output_buffer[i][1] = value;
     }
     if (envs[0].stopped())
@@ -149,8 +160,10 @@ void wavetable_voice::render_block(int current_snapshot)
 
 /////////////////////////////////////////////////////////////////////////////////////////////////////
 
-const int16_t *wavetable_voice::get_last_table(int osc) const
+const float *wavetable_voice::get_last_table(int osc) const
 {
+    if (!oscs[osc].tables)
+        return NULL;
     float os = dsp::clip<double>(last_oscshift[osc] * 1.27, 0, 127);
     return oscs[osc].tables[(int)os];
 }
@@ -166,12 +179,14 @@ bool wavetable_audio_module::get_graph(int index, int subindex, int phase, float
         if (active_voices.empty())
             return false;
         wavetable_voice *vc = last_voice;
-        const int16_t *tab = vc->get_last_table(index == par_o1wave ? 0 : 1);
+        const float *tab = vc->get_last_table(index == par_o1wave ? 0 : 1);
+        if (!tab)
+            return false;
         for (int i = 0; i < points; i++)
         {
             double pos = i * 256 / points;
             int ipos = (int)pos;
-            data[i] = lerp(tab[ipos] / 32767.0, tab[(ipos + 1) & 255] / 32767.0, pos - ipos);
+            data[i] = lerp(tab[ipos], tab[ipos + 1], pos - ipos);
         }
 
         return true;
@@ -209,388 +224,567 @@ static void interpolate_wt(int16_t table[129][256], int step)
     }
 }
 
-wavetable_audio_module::wavetable_audio_module()
-: mod_matrix_impl(mod_matrix_data, &mm_metadata)
-, inertia_pitchbend(64)
-, inertia_pressure(64)
+/// Calculate one of the wavetables (in 16 bits, as they were designed)
+static void make_table(int index, int16_t table[129][256])
 {
-    init_voices(36);
-    last_voice = (wavetable_voice *)allocated_voices.items[0];
-
-    panic_flag = false;
-    modwheel_value = 0.;
-    for (int i = 0; i < 129; i += 8)
+    switch(index)
     {
-        for (int j = 0; j < 256; j++)
+    case wavetable_metadata::wt_fmshiny:
+        for (int i = 0; i < 129; i += 8)
         {
-            float ph = j * 2 * M_PI / 256;
-            int harm = 1 + 2 * (i / 8);
-            float ii = i / 128.0;
-            float rezo1 = sin(harm * ph) * sin(ph);
-            float rezo2 = sin((harm+1) * ph) * sin(ph * 2);
-            float rezo3 = sin((harm+3) * ph) * sin(ph * 4);
-            float rezo = (rezo1 + rezo2 + rezo3) / 3;
-            float v = (sin (ph) + ii * ii * rezo) / 2;
-            tables[0][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                int harm = 1 + 2 * (i / 8);
+                float ii = i / 128.0;
+                float rezo1 = sin(harm * ph) * sin(ph);
+                float rezo2 = sin((harm+1) * ph) * sin(ph * 2);
+                float rezo3 = sin((harm+3) * ph) * sin(ph * 4);
+                float rezo = (rezo1 + rezo2 + rezo3) / 3;
+                float v = (sin (ph) + ii * ii * rezo) / 2;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    interpolate_wt(tables[0], 8);
-    for (int i = 0; i < 129; i += 4)
-    {
-        for (int j = 0; j < 256; j++)
+        interpolate_wt(table, 8);
+        break;
+    case wavetable_metadata::wt_fmshiny2:
+        for (int i = 0; i < 129; i += 4)
         {
-            float ph = j * 2 * M_PI / 256;
-            int harm = 1 + (i / 4);
-            float ii = i / 128.0;
-            float h = sin(harm * ph);
-            float rezo1 = h * sin(ph);
-            float rezo2 = h * sin(ph * 2)/2;
-            float rezo3 = h * sin(ph * 3)/3;
-            float rezo4 = h * sin(ph * 4)/4;
-            float rezo5 = h * sin(ph * 5)/5;
-            float rezo = (rezo1 + rezo2 + rezo3 + rezo4 + rezo5) / 3;
-            float v = sin (ph + ii * rezo);
-            tables[1][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                int harm = 1 + (i / 4);
+                float ii = i / 128.0;
+                float h = sin(harm * ph);
+                float rezo1 = h * sin(ph);
+                float rezo2 = h * sin(ph * 2)/2;
+                float rezo3 = h * sin(ph * 3)/3;
+                float rezo4 = h * sin(ph * 4)/4;
+                float rezo5 = h * sin(ph * 5)/5;
+                float rezo = (rezo1 + rezo2 + rezo3 + rezo4 + rezo5) / 3;
+                float v = sin (ph + ii * rezo);
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    interpolate_wt(tables[1], 4);
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        interpolate_wt(table, 4);
+        break;
+    case wavetable_metadata::wt_rezo:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = (i & ~3) / 128.0;
-            float ii2 = ((i & ~3) + 4) / 128.0;
-            float peak = (32 * ii);
-            float rezo1 = sin(floor(peak) * ph);
-            float rezo2 = sin(floor(peak + 1) * ph);
-            float widener = (0.5 + 0.3 * sin(ph) + 0.2 * sin (3 * ph));
-            float v1 = 0.5 * sin (ph) + 0.5 * ii * ii * rezo1 * widener;
-            float v2 = 0.5 * sin (ph) + 0.5 * ii2 * ii2 * rezo2 * widener;
-            tables[wavetable_metadata::wt_rezo][i][j] = 32767 * lerp(v1, v2, (i & 3) / 4.0);
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = (i & ~3) / 128.0;
+                float ii2 = ((i & ~3) + 4) / 128.0;
+                float peak = (32 * ii);
+                float rezo1 = sin(floor(peak) * ph);
+                float rezo2 = sin(floor(peak + 1) * ph);
+                float widener = (0.5 + 0.3 * sin(ph) + 0.2 * sin (3 * ph));
+                float v1 = 0.5 * sin (ph) + 0.5 * ii * ii * rezo1 * widener;
+                float v2 = 0.5 * sin (ph) + 0.5 * ii2 * ii2 * rezo2 * widener;
+                table[i][j] = 32767 * lerp(v1, v2, (i & 3) / 4.0);
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_metal:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph) + ii * sin(ph + 2 * ii * sin(ph)) + ii * ii * sin(ph + 6 * ii * ii * sin(6 * ph)) + ii * ii * ii * ii * sin(ph + 11 * ii * ii * ii * ii * sin(11 * ph))) / 4;
-            tables[wavetable_metadata::wt_metal][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph) + ii * sin(ph + 2 * ii * sin(ph)) + ii * ii * sin(ph + 6 * ii * ii * sin(6 * ph)) + ii * ii * ii * ii * sin(ph + 11 * ii * ii * ii * ii * sin(11 * ph))) / 4;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_bell:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * sin(5 * ph - 5 * ii * ii * ii * ii * sin(11 * ph))) / 3;
-            tables[wavetable_metadata::wt_bell][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * sin(5 * ph - 5 * ii * ii * ii * ii * sin(11 * ph))) / 3;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_blah:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            //float v = (sin(ph) + ii * sin(ph + 2 * ii * sin(ph)) + ii * ii * sin(ph + 3 * ii * ii * sin(3 * ph)) + ii * ii * ii * sin(ph + 5 * ii * ii * ii * sin(5 * ph))) / 4;
-            float v = (sin(ph) + sin(ph - 3 * sin(ii * 5 - 2) * sin(ph)) + sin(ii * 4 - 1.3) * sin(5 * ph + 3 * ii * ii * sin(6 * ph))) / 3;
-            tables[wavetable_metadata::wt_blah][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                //float v = (sin(ph) + ii * sin(ph + 2 * ii * sin(ph)) + ii * ii * sin(ph + 3 * ii * ii * sin(3 * ph)) + ii * ii * ii * sin(ph + 5 * ii * ii * ii * sin(5 * ph))) / 4;
+                float v = (sin(ph) + sin(ph - 3 * sin(ii * 5 - 2) * sin(ph)) + sin(ii * 4 - 1.3) * sin(5 * ph + 3 * ii * ii * sin(6 * ph))) / 3;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 256; i++)
-    {
-        tables[wavetable_metadata::wt_pluck][128][i] = (i < 128) ? 32000 * fabs(sin(i / 32.0 * M_PI) * sin(i / 13.0 * M_PI) * sin(i / 19.0 * M_PI)) : 0;
-    }
-    for (int i = 127; i >= 0; i--)
-    {
-        int16_t *parent = tables[wavetable_metadata::wt_pluck][i + 1];
-        float damp = 0.05;
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_pluck:
+        for (int i = 0; i < 256; i++)
         {
-            tables[wavetable_metadata::wt_pluck][i][j] = (1 - 2*damp) * parent[j] + damp * parent[(j+1)&255] + damp * parent[(j+2)&255];// + 0.1 * parent[(j-1)&255]+ 0.1 * parent[(j-2)&255];
+            table[128][i] = (i < 128) ? 32000 * fabs(sin(i / 32.0 * M_PI) * sin(i / 13.0 * M_PI) * sin(i / 19.0 * M_PI)) : 0;
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        for (int i = 127; i >= 0; i--)
         {
-            float ph = j / 128.0 - 1.0;
-            float ii = i / 128.0;
-            float v = sincl(ph * (1 + 15 * ii), 1);
-            tables[wavetable_metadata::wt_stretch][i][j] = 32767 * v;
+            int16_t *parent = table[i + 1];
+            float damp = 0.05;
+            for (int j = 0; j < 256; j++)
+            {
+                table[i][j] = (1 - 2*damp) * parent[j] + damp * parent[(j+1)&255] + damp * parent[(j+2)&255];// + 0.1 * parent[(j-1)&255]+ 0.1 * parent[(j-2)&255];
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_stretch:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j / 128.0 - 1.0;
-            float ii = i / 128.0;
-            float v = sincl(ph * (1 + 15 * ii), 4) * sincl(j / 256.0, 1);
-            tables[wavetable_metadata::wt_stretch2][i][j] = 32000 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j / 128.0 - 1.0;
+                float ii = i / 128.0;
+                float v = sincl(ph * (1 + 15 * ii), 1);
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_stretch2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j / 128.0 - 1.0;
-            float ii = i / 128.0;
-            float w = sincl(ph * (1 + 15 * ii), 4);
-            float v = pow(w, 9) * sincl(j / 256.0, 1);
-            tables[wavetable_metadata::wt_hardsync][i][j] = 32000 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j / 128.0 - 1.0;
+                float ii = i / 128.0;
+                float v = sincl(ph * (1 + 15 * ii), 4) * sincl(j / 256.0, 1);
+                table[i][j] = 32000 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_hardsync:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j / 128.0 - 1.0;
-            float ii = i / 128.0;
-            float w = sincl(ph * (1 + 31 * ii), 3);
-            float v = pow(w, 5) * sincl(j / 256.0, 1);
-            tables[wavetable_metadata::wt_hardsync2][i][j] = 32000 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j / 128.0 - 1.0;
+                float ii = i / 128.0;
+                float w = sincl(ph * (1 + 15 * ii), 4);
+                float v = pow(w, 9) * sincl(j / 256.0, 1);
+                table[i][j] = 32000 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_hardsync2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j / 128.0 - 1.0;
-            float ii = i / 128.0;
-            float w = sincl(ph * ph * (1 + 15 * ii), 2);
-            float v = pow(w, 4) * sincl(j / 256.0, 1);
-            tables[wavetable_metadata::wt_softsync][i][j] = 32000 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j / 128.0 - 1.0;
+                float ii = i / 128.0;
+                float w = sincl(ph * (1 + 31 * ii), 3);
+                float v = pow(w, 5) * sincl(j / 256.0, 1);
+                table[i][j] = 32000 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_softsync:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * ii * sin(7 * ph - 2 * ii * ii * ii * ii * sin(13 * ph))) / 3;
-            tables[wavetable_metadata::wt_bell2][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j / 128.0 - 1.0;
+                float ii = i / 128.0;
+                float w = sincl(ph * ph * (1 + 15 * ii), 2);
+                float v = pow(w, 4) * sincl(j / 256.0, 1);
+                table[i][j] = 32000 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_bell2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * ii * sin(9 * ph - ii * ii * sin(11 * ph))) / 3;
-            tables[wavetable_metadata::wt_bell3][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * ii * sin(7 * ph - 2 * ii * ii * ii * ii * sin(13 * ph))) / 3;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_bell3:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph + ii * sin(ph - 3 * ii * sin(ph) + ii * ii * ii * sin(5 * ph - ii * ii * sin(7 * ph)))));
-            tables[wavetable_metadata::wt_tine][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph) + ii * sin(ph - 3 * ii * sin(ph)) + ii * ii * ii * sin(9 * ph - ii * ii * sin(11 * ph))) / 3;
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_tine:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float v = (sin(ph + ii * sin(ph - 2 * ii * sin(ph) + ii * ii * ii * sin(3 * ph - ii * ii * sin(4 * ph)))));
-            tables[wavetable_metadata::wt_tine2][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph + ii * sin(ph - 3 * ii * sin(ph) + ii * ii * ii * sin(5 * ph - ii * ii * sin(7 * ph)))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_tine2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ph2 = j / 128.0 - 1;
-            float ii = i / 128.0;
-            float w = sincl(ph2 * (1 + 7 * ii * ii), 4) * pow(sincl(j / 256.0, 1), 2);
-            float v = sin(ph + ii * sin(ph - 2 * ii * w));
-            tables[wavetable_metadata::wt_clav][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float v = (sin(ph + ii * sin(ph - 2 * ii * sin(ph) + ii * ii * ii * sin(3 * ph - ii * ii * sin(4 * ph)))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_clav:
+        for (int i = 0; i < 129; i++)
+        {
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ph2 = j / 128.0 - 1;
+                float ii = i / 128.0;
+                float w = sincl(ph2 * (1 + 7 * ii * ii), 4) * pow(sincl(j / 256.0, 1), 2);
+                float v = sin(ph + ii * sin(ph - 2 * ii * w));
+                table[i][j] = 32767 * v;
+            }
+        }
+        break;
+    case wavetable_metadata::wt_clav2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ph2 = j / 128.0 - 1;
-            float ii = i / 128.0;
-            float w = sincl(ph2 * (1 + 7 * ii * ii), 6) * sincl(j / 256.0, 1);
-            float v = sin(ph + ii * sin(3 * ph - 2 * ii * w));
-            tables[wavetable_metadata::wt_clav2][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ph2 = j / 128.0 - 1;
+                float ii = i / 128.0;
+                float w = sincl(ph2 * (1 + 7 * ii * ii), 6) * sincl(j / 256.0, 1);
+                float v = sin(ph + ii * sin(3 * ph - 2 * ii * w));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    /*
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_gtr:
+        /*
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ph2 = j / 128.0 - 1;
-            float ii = i / 128.0;
-            float w = sincl(ph2 * (1 + 7 * ii * ii), 6) * pow(sincl(j / 256.0, 1), 1);
-            float v = sin(ph + ii * ii * ii * sin(3 * ph - ii * ii * ii * w));
-            tables[wavetable_metadata::wt_gtr][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ph2 = j / 128.0 - 1;
+                float ii = i / 128.0;
+                float w = sincl(ph2 * (1 + 7 * ii * ii), 6) * pow(sincl(j / 256.0, 1), 1);
+                float v = sin(ph + ii * ii * ii * sin(3 * ph - ii * ii * ii * w));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    */
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        */
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = ii;
-            float w = pow(sincl(j / 256.0, 1), 1);
-            float v = sin(ph + ii2 * ii2 * ii2 * sin(3 * ph - ii2 * ii2 * ii2 * w * sin(ph + sin(3 * ph) + ii * sin(11 * ph) + ii * ii * sin(25 * ph))));
-            tables[wavetable_metadata::wt_gtr][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = ii;
+                float w = pow(sincl(j / 256.0, 1), 1);
+                float v = sin(ph + ii2 * ii2 * ii2 * sin(3 * ph - ii2 * ii2 * ii2 * w * sin(ph + sin(3 * ph) + ii * sin(11 * ph) + ii * ii * sin(25 * ph))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_gtr2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = dsp::clip(ii - 0.5, 0.0, 1.0);
-            float w = pow(sincl(j / 256.0, 1), 1);
-            float v = sin(ph + ii * ii * ii * sin(3 * ph - ii * ii * ii * w * sin(ph + sin(3 * ph + ii2 * sin(13 * ph)))));
-            tables[wavetable_metadata::wt_gtr2][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = dsp::clip(ii - 0.5, 0.0, 1.0);
+                float w = pow(sincl(j / 256.0, 1), 1);
+                float v = sin(ph + ii * ii * ii * sin(3 * ph - ii * ii * ii * w * sin(ph + sin(3 * ph + ii2 * sin(13 * ph)))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_gtr3:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = dsp::clip(2 * (ii - 0.5), 0.0, 1.0);
-            //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
-            float w = pow(sincl(j / 256.0, 1), 1);
-            float v = sin(ph + ii * sin(3 * ph - ii * w * sin(ph + sin(3 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(4 * ph))))));
-            tables[wavetable_metadata::wt_gtr3][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = dsp::clip(2 * (ii - 0.5), 0.0, 1.0);
+                //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
+                float w = pow(sincl(j / 256.0, 1), 1);
+                float v = sin(ph + ii * sin(3 * ph - ii * w * sin(ph + sin(3 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(4 * ph))))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_gtr4:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = dsp::clip(2 * (ii - 0.5), 0.0, 1.0);
-            //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
-            float w = pow(sincl(j / 256.0, 1), 1);
-            float v = sin(ph + ii * sin(3 * ph - ii * w * sin(2 * ph + sin(5 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(4 * ph))))));
-            tables[wavetable_metadata::wt_gtr4][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = dsp::clip(2 * (ii - 0.5), 0.0, 1.0);
+                //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
+                float w = pow(sincl(j / 256.0, 1), 1);
+                float v = sin(ph + ii * sin(3 * ph - ii * w * sin(2 * ph + sin(5 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(4 * ph))))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_gtr5:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = dsp::clip((ii - 0.25)/0.75, 0.0, 1.0);
-            //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
-            float w = pow(sincl(j / 256.0, 1), 3);
-            float v = sin(ph + (ii + 0.05) * sin(3 * ph - 2 * ii * w * sin(5 * ph + sin(7 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(11 * ph))))));
-            tables[wavetable_metadata::wt_gtr5][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = dsp::clip((ii - 0.25)/0.75, 0.0, 1.0);
+                //float w = sincl(ph2 * (1 + 15 * ii2 * ii2), 4) * pow(sincl(j / 256.0, 1), 1);
+                float w = pow(sincl(j / 256.0, 1), 3);
+                float v = sin(ph + (ii + 0.05) * sin(3 * ph - 2 * ii * w * sin(5 * ph + sin(7 * ph + 0.5 * ii2 * sin(13 * ph + 0.5 * sin(11 * ph))))));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_reed:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float w = pow(sincl(2 * (j / 256.0), 2), 3);
-            float v = sin(ph + (ii + 0.05) * sin(7 * ph - 2 * ii * w * sin(11 * ph)));
-            tables[wavetable_metadata::wt_reed][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float w = pow(sincl(2 * (j / 256.0), 2), 3);
+                float v = sin(ph + (ii + 0.05) * sin(7 * ph - 2 * ii * w * sin(11 * ph)));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_reed2:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float ii2 = dsp::clip((ii - 0.25)/0.75, 0.0, 1.0);
-            float ii3 = dsp::clip((ii - 0.5)/0.5, 0.0, 1.0);
-            float v = sin(ph + (ii + 0.05) * sin(ii * sin(2 * ph) - 2 * ii2 * sin(2 * ph + ii2 * sin(3 * ph)) + 3 * ii3 * sin(3 * ph)));
-            tables[wavetable_metadata::wt_reed2][i][j] = 32767 * v;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float ii2 = dsp::clip((ii - 0.25)/0.75, 0.0, 1.0);
+                float ii3 = dsp::clip((ii - 0.5)/0.5, 0.0, 1.0);
+                float v = sin(ph + (ii + 0.05) * sin(ii * sin(2 * ph) - 2 * ii2 * sin(2 * ph + ii2 * sin(3 * ph)) + 3 * ii3 * sin(3 * ph)));
+                table[i][j] = 32767 * v;
+            }
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_silver:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float mod = 0;
-            for (int k = 0; k < 13; k++)
+            for (int j = 0; j < 256; j++)
             {
-                mod += blip(i, k * 10, 30) * sin (ph * (5 + 3 * k) + ii * cos(ph * (2 + 2 * k)));
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float mod = 0;
+                for (int k = 0; k < 13; k++)
+                {
+                    mod += blip(i, k * 10, 30) * sin (ph * (5 + 3 * k) + ii * cos(ph * (2 + 2 * k)));
+                }
+                float v = sin(ph + ii * mod);
+                table[i][j] = 32767 * v;
             }
-            float v = sin(ph + ii * mod);
-            tables[wavetable_metadata::wt_silver][i][j] = 32767 * v;
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_brass:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float mod = 0;
-            for (int k = 0; k < 16; k++)
+            for (int j = 0; j < 256; j++)
             {
-                mod += 2 * blip(i, k * 8, k * 4 + 10) * cos (ph * (k + 1));
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float mod = 0;
+                for (int k = 0; k < 16; k++)
+                {
+                    mod += 2 * blip(i, k * 8, k * 4 + 10) * cos (ph * (k + 1));
+                }
+                float v = sin(ph + ii * mod);
+                table[i][j] = 32767 * v;
             }
-            float v = sin(ph + ii * mod);
-            tables[wavetable_metadata::wt_brass][i][j] = 32767 * v;
         }
-    }
-    for (int i = 0; i < 129; i++)
-    {
-        for (int j = 0; j < 256; j++)
+        break;
+    case wavetable_metadata::wt_multi:
+        for (int i = 0; i < 129; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float ii = i / 128.0;
-            float mod = 0;
-            for (int k = 0; k < 16; k++)
+            for (int j = 0; j < 256; j++)
             {
-                mod += 2 * blip(i, k * 8, 16) * cos (ph * (2 * k + 1));
+                float ph = j * 2 * M_PI / 256;
+                float ii = i / 128.0;
+                float mod = 0;
+                for (int k = 0; k < 16; k++)
+                {
+                    mod += 2 * blip(i, k * 8, 16) * cos (ph * (2 * k + 1));
+                }
+                float v = (sin(ph + ii * mod) + ii * sin(2 * ph + ii * mod)) / 2;
+                table[i][j] = 32767 * v;
             }
-            float v = (sin(ph + ii * mod) + ii * sin(2 * ph + ii * mod)) / 2;
-            tables[wavetable_metadata::wt_multi][i][j] = 32767 * v;
         }
+        break;
+    case wavetable_metadata::wt_multi2:
+        for (int i = 0; i < 129; i ++)
+        {
+            float h = 1 + i / 16.0;
+            for (int j = 0; j < 256; j++)
+            {
+                float ph = j * 2 * M_PI / 256;
+                float v = sin(ph), tv = 1;
+                for (int k = 1; k < 24; k++) {
+                    float amp = blip(i, k * 6, 20) / k;
+                    v += amp * sin((k + 1) * ph + h * sin(ph));
+                    tv += amp;
+                }
+                table[i][j] = 32767 * v / tv;
+            }
+        }
+        break;
     }
-    for (int i = 0; i < 129; i ++)
+}
+
+/////////////////////////////////////////////////////////////////////////////////////////////////////
+
+static pthread_mutex_t bank_mutex = PTHREAD_MUTEX_INITIALIZER;
+static wavetable_bank *shared_bank = NULL;
+
+wavetable_bank *wavetable_bank::acquire()
+{
+    pthread_mutex_lock(&bank_mutex);
+    if (!shared_bank)
+        shared_bank = new wavetable_bank;
+    shared_bank->refcount++;
+    wavetable_bank *bank = shared_bank;
+    pthread_mutex_unlock(&bank_mutex);
+    return bank;
+}
+
+void wavetable_bank::release()
+{
+    pthread_mutex_lock(&bank_mutex);
+    bool last = !--refcount;
+    if (last)
+        shared_bank = NULL;
+    pthread_mutex_unlock(&bank_mutex);
+    if (last)
+        delete this;
+}
+
+wavetable_bank::wavetable_bank()
+{
+    refcount = 0;
+    quit = false;
+    for (int i = 0; i < wavetable_metadata::wt_count; i++)
     {
-        float h = 1 + i / 16.0;
-        for (int j = 0; j < 256; j++)
+        tables[i] = NULL;
+        wanted[i] = 0;
+    }
+    pthread_mutex_init(&mutex, NULL);
+    sem_init(&requests, 0, 0);
+    pthread_create(&builder, NULL, builder_thread, this);
+}
+
+wavetable_bank::~wavetable_bank()
+{
+    quit = true;
+    sem_post(&requests);
+    pthread_join(builder, NULL);
+    sem_destroy(&requests);
+    pthread_mutex_destroy(&mutex);
+    for (int i = 0; i < wavetable_metadata::wt_count; i++)
+        delete []tables[i];
+}
+
+void *wavetable_bank::builder_thread(void *arg)
+{
+    wavetable_bank *self = (wavetable_bank *)arg;
+    while(true)
+    {
+        while(sem_wait(&self->requests) && errno == EINTR)
+            ;
+        if (self->quit)
+            break;
+        for (int i = 0; i < wavetable_metadata::wt_count; i++)
         {
-            float ph = j * 2 * M_PI / 256;
-            float v = sin(ph), tv = 1;
-            for (int k = 1; k < 24; k++) {
-                float amp = blip(i, k * 6, 20) / k;
-                v += amp * sin((k + 1) * ph + h * sin(ph));
-                tv += amp;
-            }
-            tables[wavetable_metadata::wt_multi2][i][j] = 32767 * v / tv;
+            if (__atomic_load_n(&self->wanted[i], __ATOMIC_RELAXED))
+                self->get(i);
         }
     }
+    return NULL;
+}
+
+const wavetable_oscillator::waveform *wavetable_bank::get(int index)
+{
+    const waveform *t = __atomic_load_n(&tables[index], __ATOMIC_ACQUIRE);
+    if (t)
+        return t;
+    pthread_mutex_lock(&mutex);
+    if (!tables[index])
+    {
+        // the tables are calculated in 16 bits, then expanded to floats with a guard point
+        std::vector<int16_t> itable(129 * 256);
+        make_table(index, (int16_t (*)[256])&itable[0]);
+        waveform *nt = new waveform[129];
+        for (int i = 0; i < 129; i++)
+        {
+            const int16_t *src = &itable[i * 256];
+            float *dest = nt[i];
+            for (int j = 0; j < 256; j++)
+                dest[j] = src[j] * (1.0f / 32768.0f);
+            dest[256] = dest[0];
+        }
+        __atomic_store_n(&tables[index], nt, __ATOMIC_RELEASE);
+    }
+    t = tables[index];
+    pthread_mutex_unlock(&mutex);
+    return t;
+}
+
+wavetable_audio_module::wavetable_audio_module()
+: mod_matrix_impl(mod_matrix_data, &mm_metadata)
+, inertia_pitchbend(64)
+, inertia_pressure(64)
+{
+    init_voices(36);
+    last_voice = (wavetable_voice *)allocated_voices.items[0];
+
+    panic_flag = false;
+    modwheel_value = 0.;
+
+    bank = wavetable_bank::acquire();
+    bank->get((int)param_props[par_o1wave].def_value);
+    bank->get((int)param_props[par_o2wave].def_value);
+}
+
+wavetable_audio_module::~wavetable_audio_module()
+{
+    bank->release();
+}
+
+void wavetable_audio_module::activate()
+{
+    // have the tables in use ready before the audio thread asks for them
+    bank->get((int)*params[par_o1wave]);
+    bank->get((int)*params[par_o2wave]);
 }
 
 void wavetable_audio_module::channel_pressure(int /*channel*/, int value)